@@ -1,30 +1,67 @@
 #include "array.h"
 
 namespace ax::array {
-    void Array::eval() {
+    std::shared_ptr<ComputeGraph> Array::build_graph() {
+        // Only the first build is guarded by the op, after which the graph's own lock takes over
+        std::lock_guard<std::mutex> lock(op->get_graph_mutex());
+        if (compute_graph == nullptr) {
+            // Arrays handing out the same op share its graph along with the graph's run state
+            compute_graph = op->get_graph();
+        }
         if (compute_graph == nullptr) {
             compute_graph = get_backend_graph_builder()(op);
             // TODO: use compute_graph->compile()
             compute_graph->forward();
-            get_backend_runner()->forward(compute_graph);
-            initial_run = true;
-        } else if (!initial_run || !op->is_idempotent()) {
-            get_backend_runner()->forward(compute_graph);
-            initial_run = true;
+            op->set_graph(compute_graph);
+        }
+        return compute_graph;
+    }
+
+    bool Array::run_forward() {
+        std::shared_ptr<ComputeGraph> graph = build_graph();
+        std::lock_guard<std::recursive_mutex> lock(graph->get_mutex());
+        if (!graph->has_run() || !op->is_idempotent()) {
+            get_backend_runner()->forward(graph);
+            graph->set_run();
+            return true;
+        }
+        return false;
+    }
+
+    void Array::eval() {
+        std::shared_ptr<ComputeGraph> graph = build_graph();
+        std::lock_guard<std::recursive_mutex> lock(graph->get_mutex());
+        if (run_forward()) {
+            graph->set_backpropagated(false);
         }
     }
 
+    std::shared_ptr<Buffer> Array::export_buff() {
+        eval();
+        std::shared_ptr<Buffer> buff = op->get_lazy()->get_buff();
+        std::shared_ptr<SpillManager> manager = get_backend_runner()->get_spill_manager();
+        if (manager != nullptr) {
+            manager->retain_export(buff);
+        } else {
+            // Nothing is spilled while no spill manager is set
+            buff->retain_export();
+        }
+        return buff;
+    }
+
     void Array::backward() {
+        std::shared_ptr<ComputeGraph> graph = build_graph();
+        std::lock_guard<std::recursive_mutex> lock(graph->get_mutex());
         eval();
-        compute_graph->backward();
-        get_backend_runner()->backward(compute_graph);
+        graph->backward();
+        // Leaf gradients accumulate so the same forward run must only be backpropagated once
+        if (!graph->is_backpropagated()) {
+            get_backend_runner()->backward(graph);
+            graph->set_backpropagated(true);
+        }
     }
 
     void Array::compile() {
-        if (compute_graph == nullptr) {
-            compute_graph = get_backend_graph_builder()(op);
-            // TODO: use compute_graph->compile()
-            compute_graph->forward();
-        }
+        build_graph();
     }
 } // namespace ax::array
@@ -12,26 +12,45 @@ namespace ax::array {
     private:
         OpPtr op = nullptr;
         std::shared_ptr<ComputeGraph> compute_graph = nullptr;
-        bool initial_run = false;
 
         static DevicePtr get_backend_device(const std::string &device_name) { return Backend::instance().get_device(device_name); }
         RunnerPtr get_backend_runner() const { return Backend::instance().get_runner(op->get_lazy()->get_device_name()); }
         std::function<std::shared_ptr<ComputeGraph>(OpPtr)> get_backend_graph_builder() { return Backend::instance().get_graph_builder(op->get_lazy()->get_device_name()); }
+        std::shared_ptr<ComputeGraph> build_graph();
+        bool run_forward();
 
     public:
         Array() = default;
-        Array(OpPtr op) : op(op) {}
+
+        Array(OpPtr op) : op(op) {
+            if (op != nullptr) {
+                op->retain_external();
+            }
+        }
 
         Array(const Array &arr) {
             op = arr.op;
+            if (op != nullptr) {
+                op->retain_external();
+            }
             compute_graph = arr.compute_graph;
-            initial_run = arr.initial_run;
+        }
+
+        ~Array() {
+            if (op != nullptr) {
+                op->release_external();
+            }
         }
 
         Array &operator=(const Array &arr) {
+            if (arr.op != nullptr) {
+                arr.op->retain_external();
+            }
+            if (op != nullptr) {
+                op->release_external();
+            }
             op = arr.op;
             compute_graph = arr.compute_graph;
-            initial_run = arr.initial_run;
             return *this;
         }
 
@@ -63,6 +82,7 @@ namespace ax::array {
         }
 
         std::shared_ptr<ComputeGraph> get_graph() { return compute_graph; }
+        OpPtr get_op() const { return op; }
 
         isize item() {
             eval();
@@ -71,6 +91,8 @@ namespace ax::array {
 
         Array detach() const { return Array(ax::graph::detach(op)); }
         void eval();
+        // Evaluates the array and keeps its buffer resident at a fixed address until the buffer's release_export
+        std::shared_ptr<Buffer> export_buff();
         void backward();
         void compile();
 
@@ -168,13 +190,23 @@ namespace ax::array {
         Array operator/=(T c) const { return Array(ax::graph::inplace_div(op, c)); }
 
         Array matmul(const Array &rhs) const { return Array(ax::graph::matmul(op, rhs.op)); }
+        Array quantize(const Array &scale) const { return Array(ax::graph::quantize(op, scale.op)); }
+        Array dequantize(const Array &scale) const { return Array(ax::graph::dequantize(op, scale.op)); }
+        Array qmatmul(const Array &rhs, const Array &scale) const { return Array(ax::graph::qmatmul(op, rhs.op, scale.op)); }
+        Array linear(const Array &weight, const Array &bias, Activation activation = Activation::NONE) const { return Array(ax::graph::linear(op, weight.op, bias.op, activation)); }
+        Array conv2d(const Array &weight, const ShapeView &stride = {1, 1}, const ShapeView &padding = {0, 0}, const ShapeView &dilation = {1, 1}, isize groups = 1) const { return Array(ax::graph::conv2d(op, weight.op, {stride, padding, dilation, groups})); }
         Array exp(bool in_place = false) const { return Array(ax::graph::exp(op, in_place)); }
+        Array gelu(bool in_place = false) const { return Array(ax::graph::gelu(op, in_place)); }
+        Array silu(bool in_place = false) const { return Array(ax::graph::silu(op, in_place)); }
         Array log(bool in_place = false) const { return Array(ax::graph::log(op, in_place)); }
         Array sqrt(bool in_place = false) const { return Array(ax::graph::sqrt(op, in_place)); }
         Array sq(bool in_place = false) const { return Array(ax::graph::sq(op, in_place)); }
         Array neg(bool in_place = false) const { return Array(ax::graph::neg(op, in_place)); }
         Array operator-() const { return Array(ax::graph::neg(op)); }
         Array recip(bool in_place = false) const { return Array(ax::graph::recip(op, in_place)); }
+        Array softmax() const { return Array(ax::graph::softmax(op)); }
+        Array log_softmax() const { return Array(ax::graph::log_softmax(op)); }
+        Array cross_entropy(const Array &labels) const { return Array(ax::graph::cross_entropy(op, labels.op)); }
         Array operator==(const Array &rhs) const { return Array(ax::graph::eq(op, rhs.op)); }
         Array operator!=(const Array &rhs) const { return Array(ax::graph::neq(op, rhs.op)); }
         Array operator<(const Array &rhs) const { return Array(ax::graph::lt(op, rhs.op)); }
@@ -183,6 +215,8 @@ namespace ax::array {
         Array operator>=(const Array &rhs) const { return Array(ax::graph::geq(op, rhs.op)); }
         Array minimum(const Array &rhs) const { return Array(ax::graph::minimum(op, rhs.op)); }
         Array maximum(const Array &rhs) const { return Array(ax::graph::maximum(op, rhs.op)); }
+        Array pack_mask() const { return Array(ax::graph::pack_mask(op)); }
+        Array mask_mul(const Array &mask) const { return Array(ax::graph::mask_mul(op, mask.op)); }
 
         template <Numeric T>
         Array operator==(T c) const { return Array(ax::graph::eq(op, c)); }
@@ -215,6 +249,10 @@ namespace ax::array {
         Array min(const ShapeDims &dims = {}) const { return Array(ax::graph::min(op, dims)); }
         Array argmax(const ShapeDims &dims = {}) const { return Array(ax::graph::argmax(op, dims)); }
         Array argmin(const ShapeDims &dims = {}) const { return Array(ax::graph::argmin(op, dims)); }
+        Array logsumexp() const { return Array(ax::graph::logsumexp(op)); }
+        Array count_nonzero() const { return Array(ax::graph::count_nonzero(op)); }
+        Array any() const { return Array(ax::graph::any(op)); }
+        Array all() const { return Array(ax::graph::all(op)); }
 
         // Shape operations
         Array broadcast(const ShapeView &view) const { return Array(ax::graph::broadcast(op, view)); }
@@ -10,8 +10,11 @@
 
 namespace ax::array {
     static Backend backend;
+    // The registry is only written by init and cleanup, and is read-only in between
+    static std::mutex registry_mutex;
 
     void Backend::init() {
+        std::lock_guard<std::mutex> lock(registry_mutex);
         if (backend.devices.size() > 0) {
             return;
         }
@@ -57,10 +60,50 @@ namespace ax::array {
     }
 
     void Backend::cleanup() {
+        std::lock_guard<std::mutex> lock(registry_mutex);
         backend.devices.clear();
         backend.runners.clear();
     }
 
+    void Backend::trim_cache() {
+        for (auto &[name, runner] : backend.runners) {
+            runner->get_allocator()->trim();
+        }
+    }
+
+    void Backend::set_cache_cap(isize nbytes) {
+        for (auto &[name, runner] : backend.runners) {
+            runner->get_allocator()->set_cache_cap(nbytes);
+        }
+    }
+
+    void Backend::enable_spill(isize budget, const std::string &dir) {
+        for (auto &[name, runner] : backend.runners) {
+            runner->set_spill_manager(std::make_shared<SpillManager>(budget, dir));
+        }
+    }
+
+    void Backend::disable_spill() {
+        for (auto &[name, runner] : backend.runners) {
+            runner->set_spill_manager(nullptr);
+        }
+    }
+
+    isize Backend::get_spilled_bytes(const std::string &device_name) {
+        std::shared_ptr<SpillManager> manager = backend.get_runner(device_name)->get_spill_manager();
+        return manager == nullptr ? 0 : manager->get_spilled();
+    }
+
+    MemoryStats Backend::get_memory_stats(const std::string &device_name) {
+        return backend.get_runner(device_name)->get_allocator()->get_stats();
+    }
+
+    void Backend::reset_peak_memory_stats() {
+        for (auto &[name, runner] : backend.runners) {
+            runner->get_allocator()->reset_peak();
+        }
+    }
+
     const Backend &Backend::instance() {
         return backend;
     }
@@ -7,6 +7,8 @@ namespace ax::array {
     using namespace ax::device;
     using namespace ax::runtime;
 
+    // Registry of devices and their runners, built once by init
+    // Lookups do not lock so init and cleanup must not run while other threads use arrays
     class Backend {
     private:
         std::unordered_map<std::string, DevicePtr> devices;
@@ -23,6 +25,18 @@ namespace ax::array {
         size_t count_devices() const { return devices.size(); }
         static void init();
         static void cleanup();
+        // Releases memory cached by the allocators of all devices
+        static void trim_cache();
+        // Caps the memory each device allocator keeps cached after buffers are freed
+        static void set_cache_cap(isize nbytes);
+        // Spills cold buffers of every device to files in dir once more than budget bytes are in use
+        static void enable_spill(isize budget, const std::string &dir = "");
+        static void disable_spill();
+        // Bytes of the device's buffers currently spilled to disk
+        static isize get_spilled_bytes(const std::string &device_name);
+        static MemoryStats get_memory_stats(const std::string &device_name);
+        // Resets the peak of every device to its current usage
+        static void reset_peak_memory_stats();
         static const Backend &instance();
     };
 } // namespace ax::array
\ No newline at end of file
@@ -1,9 +1,11 @@
 #pragma once
 
-#include "../utils.h"
+#include "half.h"
 
 namespace ax::core {
     enum struct DtypeName {
+        F16,
+        BF16,
         F32,
         F64,
         I8,
@@ -20,10 +22,14 @@ namespace ax::core {
     };
 
     inline const std::unordered_map<DtypeName, const std::string> str_by_dtype_name = {
+        {DtypeName::F16, "f16"},
+        {DtypeName::BF16, "bf16"},
         {DtypeName::F32, "f32"},
+        {DtypeName::F64, "f64"},
         {DtypeName::I8, "i8"},
         {DtypeName::I16, "i16"},
         {DtypeName::I32, "i32"},
+        {DtypeName::I64, "i64"},
         {DtypeName::B8, "b8"}};
 
     struct Dtype {
@@ -85,7 +91,8 @@ namespace ax::core {
         Float(const Float<T> &dtype) : Dtype(dtype) {}
 
         std::string get_value_as_str(uint8_t *ptr) const override {
-            T val = *reinterpret_cast<T *>(ptr);
+            // 16-bit floats are printed through f32
+            std::conditional_t<std::is_floating_point_v<T>, T, float> val = *reinterpret_cast<T *>(ptr);
             if (0 < val && val <= 1e-5) {
                 return std::format("{:.4e}", val);
             }
@@ -117,6 +124,43 @@ namespace ax::core {
         isize min() const override { return std::numeric_limits<T>::lowest(); }
     };
 
+    // Low-level values of 16-bit floats are their raw bits
+    struct F16 : public Float<Float16> {
+      public:
+        F16() : Float<Float16>(DtypeName::F16, 2) {}
+        F16(const F16 &dtype) : Float<Float16>(dtype) {}
+
+        std::string get_value_as_str(isize val) const override {
+            return std::to_string(static_cast<float>(Float16::from_bits(val)));
+        }
+
+        isize get_low_level_value(uint8_t *ptr) const override {
+            return reinterpret_cast<Float16 *>(ptr)->bits;
+        }
+
+        isize max() const override { return 0x7bff; }
+
+        isize min() const override { return 0xfbff; }
+    };
+
+    struct BF16 : public Float<BFloat16> {
+      public:
+        BF16() : Float<BFloat16>(DtypeName::BF16, 2) {}
+        BF16(const BF16 &dtype) : Float<BFloat16>(dtype) {}
+
+        std::string get_value_as_str(isize val) const override {
+            return std::to_string(static_cast<float>(BFloat16::from_bits(val)));
+        }
+
+        isize get_low_level_value(uint8_t *ptr) const override {
+            return reinterpret_cast<BFloat16 *>(ptr)->bits;
+        }
+
+        isize max() const override { return 0x7f7f; }
+
+        isize min() const override { return 0xff7f; }
+    };
+
     struct F32 : public Float<float> {
       public:
         F32() : Float<float>(DtypeName::F32, 4) {}
@@ -203,6 +247,8 @@ namespace ax::core {
     using DtypePtr = const Dtype *;
     using DtypePtrSet = const std::unordered_set<DtypePtr>;
 
+    inline const F16 f16;
+    inline const BF16 bf16;
     inline const F32 f32;
     inline const F64 f64;
     inline const I8 i8;
@@ -211,21 +257,63 @@ namespace ax::core {
     inline const I64 i64;
     inline const Bool b8;
 
-    inline DtypePtrSet all_dtypes = {&b8, &i32, &f32};
-    inline DtypePtrSet numeric_dtypes = {&i32, &f32};
-    inline DtypePtrSet binary_dtypes = {&i32, &f32};
-    inline DtypePtrSet unary_dtypes = {&i32, &f32};
-    inline DtypePtrSet cmp_dtypes = {&i32, &f32};
-    inline DtypePtrSet eq_dtypes = {&i32, &f32, &b8};
+    inline DtypePtrSet all_dtypes = {&b8, &i8, &i16, &i32, &i64, &f16, &bf16, &f32, &f64};
+    // Metal has no double so f64 arrays can be stored, converted and copied but not computed on
+    inline DtypePtrSet numeric_dtypes = {&i8, &i16, &i32, &i64, &f16, &bf16, &f32};
+    inline DtypePtrSet binary_dtypes = {&i8, &i16, &i32, &i64, &f16, &bf16, &f32};
+    inline DtypePtrSet unary_dtypes = {&i8, &i16, &i32, &i64, &f16, &bf16, &f32};
+    inline DtypePtrSet cmp_dtypes = {&i8, &i16, &i32, &i64, &f16, &bf16, &f32};
+    inline DtypePtrSet eq_dtypes = {&i8, &i16, &i32, &i64, &f16, &bf16, &f32, &b8};
+    // Floating-point dtypes the kernels compute on
+    inline DtypePtrSet float_dtypes = {&f16, &bf16, &f32};
+    inline DtypePtrSet half_dtypes = {&f16, &bf16};
+    // Scales and values that can be quantized to i8
+    inline DtypePtrSet quant_dtypes = {&f16, &bf16, &f32};
     inline const std::unordered_map<DtypePtr, DtypePtr> float_dtype_by_dtype = {
+        {&i8, &f32},
+        {&i16, &f32},
         {&i32, &f32},
+        {&i64, &f32},
+        {&f16, &f16},
+        {&bf16, &bf16},
         {&f32, &f32}};
+    // Reductions and matmuls over narrow types accumulate in a wider type and only round the result
+    inline const std::unordered_map<DtypePtr, DtypePtr> accum_dtype_by_dtype = {
+        {&i8, &i32},
+        {&i16, &i32},
+        {&f16, &f32},
+        {&bf16, &f32}};
+
+    // Dtype that binary ops over two numeric dtypes compute in
+    // Floats win over ints and the wider type wins within a kind, f16 and bf16 only fit together in f32
+    // Ints mixed with f16 or bf16 also go to f32 since half types overflow or round most int values
+    inline DtypePtr promote_dtypes(DtypePtr ldtype, DtypePtr rdtype) {
+        if (ldtype == rdtype) {
+            return ldtype;
+        }
+        bool lfloat = ldtype->get_type() == DtypeType::FLOAT;
+        bool rfloat = rdtype->get_type() == DtypeType::FLOAT;
+        if (lfloat != rfloat) {
+            DtypePtr float_dtype = lfloat ? ldtype : rdtype;
+            return half_dtypes.contains(float_dtype) ? &f32 : float_dtype;
+        }
+        if (ldtype->get_size() == rdtype->get_size()) {
+            return &f32;
+        }
+        return ldtype->get_size() > rdtype->get_size() ? ldtype : rdtype;
+    }
 
     template <class T>
     isize dtype_cast_down(T c, DtypePtr dtype) {
         switch (dtype->get_type()) {
         case DtypeType::FLOAT:
-            switch (dtype->get_size()) {
+            switch (dtype->get_name()) {
+            case DtypeName::F16:
+                return Float16(static_cast<float>(c)).bits;
+            case DtypeName::BF16:
+                return BFloat16(static_cast<float>(c)).bits;
+            case DtypeName::F64:
+                return std::bit_cast<int64_t>(static_cast<double>(c));
             default:
                 return std::bit_cast<int>(static_cast<float>(c));
             }
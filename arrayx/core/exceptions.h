@@ -10,6 +10,11 @@ namespace ax::core {
         ComputeGraphNotForwardedException() : std::runtime_error("Graph has not been forwarded.") {}
     };
 
+    class SavedArrayModified : public std::runtime_error {
+    public:
+        SavedArrayModified(const std::string &op, const std::string &id, isize saved_version, isize version) : std::runtime_error("Array " + id + " needed for gradient computation of operator " + op + " has been modified by an in-place operation (version " + std::to_string(version) + ", expected version " + std::to_string(saved_version) + ").") {}
+    };
+
     class IncompatShapesForOp : public std::invalid_argument {
     public:
         IncompatShapesForOp(const std::string &op, const std::string lview, const std::string rview) : std::invalid_argument("Cannot run operator " + op + " on incompatible shapes " + lview + " and " + rview + ".") {}
@@ -30,6 +35,11 @@ namespace ax::core {
         IncompatDevicesForOp(const std::string &op, const std::string lhs_device, const std::string rhs_device) : std::invalid_argument("Cannot run operator " + op + " on incompatible devices " + lhs_device + " and " + rhs_device + ".") {}
     };
 
+    class UnbatchableOp : public std::invalid_argument {
+    public:
+        UnbatchableOp(const std::string &op) : std::invalid_argument("Cannot batch operator " + op + " with vmap.") {}
+    };
+
     class OutOfRange : public std::out_of_range {
     public:
         OutOfRange(isize idx, isize start, isize stop) : std::out_of_range(std::to_string(idx) + " is not in the range [" + std::to_string(start) + ", " + std::to_string(stop) + ")") {}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include "../utils.h"
+#if defined(__F16C__) || (defined(__AVX512BF16__) && defined(__AVX512VL__))
+#include <immintrin.h>
+#endif
+
+namespace ax::core {
+    // IEEE 754 half precision value kept as raw bits on the host
+    // Devices load and store the bits natively, the host only converts scalars
+    struct Float16 {
+        uint16_t bits = 0;
+
+        Float16() = default;
+
+        explicit Float16(float x) : bits(from_float(x)) {}
+
+        static Float16 from_bits(uint16_t bits) {
+            Float16 x;
+            x.bits = bits;
+            return x;
+        }
+
+        operator float() const { return to_float(bits); }
+
+        // Rounds to the nearest half, ties to even
+        static uint16_t from_float(float x) {
+#if defined(__F16C__)
+            return _cvtss_sh(x, _MM_FROUND_TO_NEAREST_INT);
+#elif defined(__aarch64__)
+            return std::bit_cast<uint16_t>(static_cast<__fp16>(x));
+#else
+            uint32_t xbits = std::bit_cast<uint32_t>(x);
+            uint16_t sign = (xbits >> 16) & 0x8000;
+            uint32_t abs = xbits & 0x7fffffff;
+            if (abs > 0x7f800000) {
+                // Quiet NaN
+                return sign | 0x7e00;
+            }
+            if (abs >= 0x47800000) {
+                // At least 2^16, which overflows to infinity
+                return sign | 0x7c00;
+            }
+            if (abs < 0x38800000) {
+                // Below 2^-14, the smallest normal half
+                if (abs < 0x33000000) {
+                    return sign;
+                }
+                uint32_t exponent = abs >> 23;
+                uint32_t mantissa = (abs & 0x7fffff) | 0x800000;
+                uint32_t shift = 126 - exponent;
+                uint32_t half = mantissa >> shift;
+                uint32_t rem = mantissa & ((1u << shift) - 1);
+                uint32_t halfway = 1u << (shift - 1);
+                if (rem > halfway || (rem == halfway && (half & 1))) {
+                    half++;
+                }
+                return sign | half;
+            }
+            // Rebias the exponent from 127 to 15 and drop the low 13 mantissa bits
+            uint32_t half = (abs >> 13) - (112 << 10);
+            uint32_t rem = abs & 0x1fff;
+            if (rem > 0x1000 || (rem == 0x1000 && (half & 1))) {
+                half++;
+            }
+            return sign | half;
+#endif
+        }
+
+        static float to_float(uint16_t h) {
+#if defined(__F16C__)
+            return _cvtsh_ss(h);
+#elif defined(__aarch64__)
+            return static_cast<float>(std::bit_cast<__fp16>(h));
+#else
+            uint32_t sign = static_cast<uint32_t>(h & 0x8000) << 16;
+            uint32_t exponent = (h >> 10) & 0x1f;
+            uint32_t mantissa = h & 0x3ff;
+            if (exponent == 0x1f) {
+                return std::bit_cast<float>(sign | 0x7f800000 | (mantissa << 13));
+            }
+            if (exponent == 0) {
+                if (mantissa == 0) {
+                    return std::bit_cast<float>(sign);
+                }
+                // Normalize the subnormal half
+                exponent = 113;
+                while (!(mantissa & 0x400)) {
+                    mantissa <<= 1;
+                    exponent--;
+                }
+                return std::bit_cast<float>(sign | (exponent << 23) | ((mantissa & 0x3ff) << 13));
+            }
+            return std::bit_cast<float>(sign | ((exponent + 112) << 23) | (mantissa << 13));
+#endif
+        }
+    };
+
+    // Brain floating point value, the upper half of a f32, kept as raw bits on the host
+    struct BFloat16 {
+        uint16_t bits = 0;
+
+        BFloat16() = default;
+
+        explicit BFloat16(float x) : bits(from_float(x)) {}
+
+        static BFloat16 from_bits(uint16_t bits) {
+            BFloat16 x;
+            x.bits = bits;
+            return x;
+        }
+
+        operator float() const { return to_float(bits); }
+
+        // Rounds to the nearest bfloat, ties to even
+        static uint16_t from_float(float x) {
+#if defined(__AVX512BF16__) && defined(__AVX512VL__)
+            return std::bit_cast<uint16_t>(_mm_cvtness_sbh(x));
+#else
+            uint32_t xbits = std::bit_cast<uint32_t>(x);
+            if ((xbits & 0x7fffffff) > 0x7f800000) {
+                // Quiet NaN
+                return (xbits >> 16) | 0x40;
+            }
+            xbits += 0x7fff + ((xbits >> 16) & 1);
+            return xbits >> 16;
+#endif
+        }
+
+        static float to_float(uint16_t b) { return std::bit_cast<float>(static_cast<uint32_t>(b) << 16); }
+    };
+} // namespace ax::core
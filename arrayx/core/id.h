@@ -1,6 +1,7 @@
 #pragma once
 
 #include "../utils.h"
+#include <atomic>
 
 namespace ax::core {
     struct Id {
@@ -23,7 +24,8 @@ namespace ax::core {
 
     struct IdGenerator {
     private:
-        static isize counter;
+        // Shared by all threads building graphs
+        static inline std::atomic<isize> counter = 1;
 
     public:
         IdGenerator() = default;
@@ -31,12 +33,10 @@ namespace ax::core {
         IdGenerator &operator=(const IdGenerator &) = delete;
 
         Id generate() {
-            Id curr(counter++);
+            Id curr(counter.fetch_add(1, std::memory_order_relaxed));
             return curr;
         }
     };
-
-    inline isize IdGenerator::counter = 1;
 } // namespace ax::core
 
 namespace std {
@@ -22,7 +22,7 @@ namespace ax::core {
     }
 
     const std::string Lazy::str() const {
-        auto iter = std::make_unique<LazyIter>(shared_from_this());
+        auto iter = std::make_unique<LazyIter>(NodePtr<const Lazy>(this));
         iter->start();
         bool next_elm_available = iter->has_next();
         if (!next_elm_available) {
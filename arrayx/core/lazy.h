@@ -5,11 +5,12 @@
 #include "dtype.h"
 #include "exceptions.h"
 #include "id.h"
+#include "node_pool.h"
 #include "range.h"
 #include "shape.h"
 
 namespace ax::core {
-    class Lazy : public std::enable_shared_from_this<Lazy> {
+    class Lazy : public Node {
     private:
         static IdGenerator id_gen;
         Id id;
@@ -19,14 +20,16 @@ namespace ax::core {
         using DevicePtr = ax::device::DevicePtr;
         DevicePtr device;
         std::shared_ptr<Buffer> buff = nullptr;
+        // Number of in-place writes to the underlying buffer, shared by all arrays aliasing it
+        std::shared_ptr<isize> version = make_node<isize>(0);
 
     public:
         Lazy(uint8_t *ptr, isize nbytes, const Shape &shape, DtypePtr dtype, DevicePtr device) : id(id_gen.generate()), shape(shape), dtype(dtype), device(device) {
-            buff = std::make_shared<Buffer>(ptr, nbytes);
+            buff = make_node<Buffer>(ptr, nbytes);
         }
 
         Lazy(const Shape &shape, DtypePtr dtype, DevicePtr device) : id(id_gen.generate()), shape(shape), dtype(dtype), device(device) {}
-        Lazy(const Lazy &lazy) : id(id_gen.generate()), shape(lazy.shape), dtype(lazy.dtype), device(lazy.device), buff(lazy.buff) {}
+        Lazy(const Lazy &lazy) : Node(lazy), id(id_gen.generate()), shape(lazy.shape), dtype(lazy.dtype), device(lazy.device), buff(lazy.buff), version(lazy.version) {}
         ~Lazy() {}
 
         Lazy &operator=(const Lazy &lazy) = delete;
@@ -43,6 +46,11 @@ namespace ax::core {
             }
         }
 
+        isize get_version() const { return *version; }
+        void bump_version() { (*version)++; }
+        void share_version(LazyPtr lazy) { version = lazy->version; }
+        bool shares_version(LazyPtr lazy) const { return version == lazy->version; }
+
         // Gets the buffer pointer without accounting for offset
         uint8_t *get_buff_ptr() const { return buff->get_ptr(); }
         // Gets the buffer pointer after accounting for offset
@@ -59,16 +67,15 @@ namespace ax::core {
         isize get_nbytes() const { return get_numel() * get_itemsize(); }
 
         static LazyPtr empty(const Shape &shape, DtypePtr dtype, DevicePtr device) {
-            return std::make_shared<Lazy>(shape, dtype, device);
+            return make_node<Lazy>(shape, dtype, device);
         }
 
         static LazyPtr from_ptr(uint8_t *ptr, isize nbytes, const Shape &shape, DtypePtr dtype, DevicePtr device) {
-            return std::make_shared<Lazy>(ptr, nbytes, shape, dtype, device);
+            return make_node<Lazy>(ptr, nbytes, shape, dtype, device);
         }
 
         bool is_contiguous() const { return shape.is_contiguous(); }
-        // TODO: handle more cases to reduce copying?
-        bool copy_when_reshape(const ShapeView &view) { return !is_contiguous(); }
+        bool copy_when_reshape(const ShapeView &view) { return !shape.get_reshape_stride(view).has_value(); }
         uint8_t *strided_elm_ptr(isize k) const;
         const std::string str() const;
     };
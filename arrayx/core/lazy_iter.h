@@ -5,12 +5,12 @@
 namespace ax::core {
     struct LazyIter {
     private:
-        std::shared_ptr<const Lazy> lazy;
+        NodePtr<const Lazy> lazy;
         uint8_t *ptr;
         isize counter;
 
     public:
-        LazyIter(std::shared_ptr<const Lazy> lazy) : lazy(lazy) {}
+        LazyIter(NodePtr<const Lazy> lazy) : lazy(lazy) {}
 
         LazyIter(const LazyIter &) = delete;
 
@@ -0,0 +1,349 @@
+#pragma once
+
+#include "../utils.h"
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <utility>
+
+namespace ax::core {
+    // Recycles the memory of graph nodes so that building a graph does not go through malloc for every op and lazy
+    // Nodes are grouped into size classes of 16 bytes and carved out of slabs aligned to their own size
+    // Each thread frees into and allocates from its own free lists, which are capped and spill into a shared pool
+    // The shared pool keeps free nodes on their slabs and hands a slab back to the system once all of its nodes are free
+    class NodePool {
+    private:
+        struct FreeNode {
+            FreeNode *next;
+        };
+
+        // Header at the start of every slab, only touched under the shared pool lock
+        struct Slab {
+            // Neighbours in the list of slabs of the class that have free nodes in the shared pool
+            Slab *prev = nullptr;
+            Slab *next = nullptr;
+            FreeNode *free = nullptr;
+            size_t nfree = 0;
+        };
+
+        struct FreeList {
+            FreeNode *head = nullptr;
+            size_t count = 0;
+        };
+
+        static constexpr size_t num_classes = 32;
+        static constexpr size_t granularity = 16;
+        static constexpr size_t max_node_nbytes = granularity * num_classes;
+        static constexpr size_t slab_nbytes = 64 << 10;
+        static constexpr size_t slab_header_nbytes = (sizeof(Slab) + granularity - 1) / granularity * granularity;
+        using FreeLists = std::array<FreeList, num_classes>;
+
+        struct ThreadFreeLists {
+            FreeLists lists{};
+
+            ~ThreadFreeLists() {
+                exited = true;
+                for (size_t i = 0; i < lists.size(); i++) {
+                    shared().release(i, lists[i].head);
+                }
+            }
+        };
+
+        // Set once the thread's free lists are destroyed so that late allocations and frees go to the shared pool
+        static inline thread_local bool exited = false;
+        std::mutex mutex;
+        std::array<Slab *, num_classes> partial{};
+
+        // Never destroyed so that threads exiting during shutdown can still return their nodes
+        static NodePool &shared() {
+            static NodePool *pool = new NodePool();
+            return *pool;
+        }
+
+        static FreeLists &local() {
+            thread_local ThreadFreeLists lists;
+            return lists.lists;
+        }
+
+        static size_t get_node_nbytes(size_t size_class) { return (size_class + 1) * granularity; }
+        static size_t get_slab_capacity(size_t size_class) { return (slab_nbytes - slab_header_nbytes) / get_node_nbytes(size_class); }
+        static Slab *get_slab(FreeNode *node) { return reinterpret_cast<Slab *>(reinterpret_cast<uintptr_t>(node) & ~(slab_nbytes - 1)); }
+
+        void link(size_t size_class, Slab *slab) {
+            slab->prev = nullptr;
+            slab->next = partial[size_class];
+            if (slab->next != nullptr) {
+                slab->next->prev = slab;
+            }
+            partial[size_class] = slab;
+        }
+
+        void unlink(size_t size_class, Slab *slab) {
+            if (slab->prev != nullptr) {
+                slab->prev->next = slab->next;
+            } else {
+                partial[size_class] = slab->next;
+            }
+            if (slab->next != nullptr) {
+                slab->next->prev = slab->prev;
+            }
+        }
+
+        // Takes a slab of the class with free nodes, carving a new one when there is none
+        Slab *take_slab(size_t size_class) {
+            Slab *slab = partial[size_class];
+            if (slab != nullptr) {
+                unlink(size_class, slab);
+                return slab;
+            }
+            uint8_t *ptr = static_cast<uint8_t *>(::operator new(slab_nbytes, std::align_val_t(slab_nbytes)));
+            slab = new (ptr) Slab();
+            size_t node_nbytes = get_node_nbytes(size_class);
+            slab->nfree = get_slab_capacity(size_class);
+            for (size_t i = slab->nfree; i-- > 0;) {
+                FreeNode *node = reinterpret_cast<FreeNode *>(ptr + slab_header_nbytes + i * node_nbytes);
+                node->next = slab->free;
+                slab->free = node;
+            }
+            return slab;
+        }
+
+        // Moves all free nodes of one slab to the calling thread
+        void refill(size_t size_class, FreeList &list) {
+            std::lock_guard<std::mutex> lock(mutex);
+            Slab *slab = take_slab(size_class);
+            list.head = slab->free;
+            list.count = slab->nfree;
+            slab->free = nullptr;
+            slab->nfree = 0;
+        }
+
+        void *allocate_one(size_t size_class) {
+            std::lock_guard<std::mutex> lock(mutex);
+            Slab *slab = take_slab(size_class);
+            FreeNode *node = slab->free;
+            slab->free = node->next;
+            if (--slab->nfree > 0) {
+                link(size_class, slab);
+            }
+            return node;
+        }
+
+        // Returns a chain of free nodes to their slabs in one go
+        void release(size_t size_class, FreeNode *chain) {
+            if (chain == nullptr) {
+                return;
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            size_t capacity = get_slab_capacity(size_class);
+            while (chain != nullptr) {
+                FreeNode *node = chain;
+                chain = node->next;
+                Slab *slab = get_slab(node);
+                node->next = slab->free;
+                slab->free = node;
+                if (slab->nfree++ == 0) {
+                    link(size_class, slab);
+                }
+                // One free slab is kept per class so that a graph built right after another one does not carve again
+                if (slab->nfree == capacity && (slab->prev != nullptr || slab->next != nullptr)) {
+                    unlink(size_class, slab);
+                    slab->~Slab();
+                    ::operator delete(slab, std::align_val_t(slab_nbytes));
+                }
+            }
+        }
+
+    public:
+        static void *allocate(size_t nbytes) {
+            if (nbytes > max_node_nbytes) {
+                return ::operator new(nbytes, std::align_val_t(granularity));
+            }
+            size_t size_class = (nbytes - 1) / granularity;
+            if (exited) {
+                return shared().allocate_one(size_class);
+            }
+            FreeList &list = local()[size_class];
+            if (list.head == nullptr) {
+                shared().refill(size_class, list);
+            }
+            FreeNode *node = list.head;
+            list.head = node->next;
+            list.count--;
+            return node;
+        }
+
+        static void deallocate(void *ptr, size_t nbytes) {
+            if (nbytes > max_node_nbytes) {
+                ::operator delete(ptr, std::align_val_t(granularity));
+                return;
+            }
+            size_t size_class = (nbytes - 1) / granularity;
+            FreeNode *node = static_cast<FreeNode *>(ptr);
+            if (exited) {
+                node->next = nullptr;
+                shared().release(size_class, node);
+                return;
+            }
+            FreeList &list = local()[size_class];
+            node->next = list.head;
+            list.head = node;
+            list.count++;
+            // A thread freeing nodes built by other threads keeps one slab worth of them and hands the rest back
+            size_t capacity = get_slab_capacity(size_class);
+            if (list.count > 2 * capacity) {
+                FreeNode *last = list.head;
+                for (size_t i = 1; i < capacity; i++) {
+                    last = last->next;
+                }
+                FreeNode *excess = last->next;
+                last->next = nullptr;
+                list.count = capacity;
+                shared().release(size_class, excess);
+            }
+        }
+    };
+
+    template <class T>
+    class NodePtr;
+
+    template <class T, class... Args>
+    auto make_node(Args &&...args);
+
+    // Base of ops and lazies, which count their handles in place instead of in a separate control block
+    class Node {
+    private:
+        template <class T>
+        friend class NodePtr;
+
+        template <class T, class... Args>
+        friend auto make_node(Args &&...args);
+
+        mutable std::atomic<isize> refs = 0;
+        // Size of the most derived node so that it can be handed back to the pool through any handle
+        size_t nbytes = 0;
+
+    protected:
+        Node() = default;
+        Node(const Node &) {}
+        Node &operator=(const Node &) { return *this; }
+
+    public:
+        virtual ~Node() = default;
+    };
+
+    // Intrusive handle to a node with the same semantics as std::shared_ptr
+    template <class T>
+    class NodePtr {
+    private:
+        template <class U>
+        friend class NodePtr;
+
+        T *ptr = nullptr;
+
+        void retain() const {
+            if (ptr != nullptr) {
+                static_cast<const Node *>(ptr)->refs.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+
+        void release() const {
+            const Node *node = ptr;
+            if (node == nullptr || node->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+                return;
+            }
+            Node *dead = const_cast<Node *>(node);
+            size_t nbytes = dead->nbytes;
+            void *mem = dynamic_cast<void *>(dead);
+            dead->~Node();
+            NodePool::deallocate(mem, nbytes);
+        }
+
+    public:
+        using element_type = T;
+
+        NodePtr() = default;
+        NodePtr(std::nullptr_t) {}
+        // Also used to get a handle from this since the count lives in the node
+        explicit NodePtr(T *ptr) : ptr(ptr) { retain(); }
+        NodePtr(const NodePtr &other) : ptr(other.ptr) { retain(); }
+        NodePtr(NodePtr &&other) noexcept : ptr(std::exchange(other.ptr, nullptr)) {}
+
+        template <class U>
+            requires std::is_convertible_v<U *, T *>
+        NodePtr(const NodePtr<U> &other) : ptr(other.ptr) { retain(); }
+
+        template <class U>
+            requires std::is_convertible_v<U *, T *>
+        NodePtr(NodePtr<U> &&other) noexcept : ptr(std::exchange(other.ptr, nullptr)) {}
+
+        ~NodePtr() { release(); }
+
+        NodePtr &operator=(NodePtr other) noexcept {
+            std::swap(ptr, other.ptr);
+            return *this;
+        }
+
+        T *get() const { return ptr; }
+        T &operator*() const { return *ptr; }
+        T *operator->() const { return ptr; }
+        explicit operator bool() const { return ptr != nullptr; }
+        void reset() { *this = nullptr; }
+
+        template <class U>
+        bool operator==(const NodePtr<U> &other) const { return ptr == other.ptr; }
+
+        bool operator==(std::nullptr_t) const { return ptr == nullptr; }
+    };
+
+    template <class T, class U>
+    NodePtr<T> static_pointer_cast(const NodePtr<U> &ptr) {
+        return NodePtr<T>(static_cast<T *>(ptr.get()));
+    }
+
+    template <class T, class U>
+    NodePtr<T> dynamic_pointer_cast(const NodePtr<U> &ptr) {
+        return NodePtr<T>(dynamic_cast<T *>(ptr.get()));
+    }
+
+    // Standard allocator over the node pool for nodes shared through std::shared_ptr
+    template <class T>
+    struct NodeAllocator {
+        using value_type = T;
+
+        NodeAllocator() = default;
+
+        template <class U>
+        NodeAllocator(const NodeAllocator<U> &) {}
+
+        T *allocate(size_t n) {
+            static_assert(alignof(T) <= 16, "Graph nodes must not be over-aligned.");
+            return static_cast<T *>(NodePool::allocate(n * sizeof(T)));
+        }
+
+        void deallocate(T *ptr, size_t n) { NodePool::deallocate(ptr, n * sizeof(T)); }
+
+        template <class U>
+        bool operator==(const NodeAllocator<U> &) const { return true; }
+    };
+
+    // Creates a node from the node pool, handed out through NodePtr for ops and lazies and through std::shared_ptr otherwise
+    template <class T, class... Args>
+    auto make_node(Args &&...args) {
+        if constexpr (std::is_base_of_v<Node, T>) {
+            static_assert(alignof(T) <= 16, "Graph nodes must not be over-aligned.");
+            void *ptr = NodePool::allocate(sizeof(T));
+            T *node;
+            try {
+                node = new (ptr) T(std::forward<Args>(args)...);
+            } catch (...) {
+                NodePool::deallocate(ptr, sizeof(T));
+                throw;
+            }
+            static_cast<Node *>(node)->nbytes = sizeof(T);
+            return NodePtr<T>(node);
+        } else {
+            return std::allocate_shared<T>(NodeAllocator<T>(), std::forward<Args>(args)...);
+        }
+    }
+} // namespace ax::core
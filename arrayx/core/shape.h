@@ -1,11 +1,15 @@
 #pragma once
 
 #include "range.h"
+#include "small_vec.h"
+#include <optional>
 #include <set>
 
 namespace ax::core {
-    using ShapeView = std::vector<isize>;
-    using ShapeStride = std::vector<isize>;
+    // Views and strides of up to this many dimensions are stored inline
+    constexpr size_t max_inline_ndim = 8;
+    using ShapeView = SmallVec<isize, max_inline_ndim>;
+    using ShapeStride = SmallVec<isize, max_inline_ndim>;
     using ShapeDims = std::vector<isize>;
 
     class Shape {
@@ -13,6 +17,21 @@ namespace ax::core {
         isize offset;
         ShapeView view;
         ShapeStride stride;
+        // Cached since they are queried by every op constructor and kernel dispatch
+        isize numel;
+        bool contiguous;
+
+        // Must be called whenever view or stride changes
+        void update_cache() {
+            numel = 1;
+            contiguous = true;
+            for (ssize_t i = view.size() - 1; i >= 0; i--) {
+                if (stride[i] != numel) {
+                    contiguous = false;
+                }
+                numel *= view[i];
+            }
+        }
 
         void if_ranges_are_valid(const RangeVec &ranges) const {
             if (ranges.size() != get_ndim()) {
@@ -88,6 +107,7 @@ namespace ax::core {
             this->offset = offset;
             this->view = view;
             this->stride = stride;
+            update_cache();
         }
 
         Shape(isize offset, const ShapeView &view) {
@@ -101,18 +121,16 @@ namespace ax::core {
                 stride[i] = s;
                 s *= view[i];
             }
+
+            numel = s;
+            contiguous = true;
         }
 
         Shape(const ShapeView &view) : Shape(0, view) {}
 
-        Shape(const Shape &shape) : Shape(shape.offset, shape.view, shape.stride) {}
+        Shape(const Shape &shape) = default;
 
-        Shape &operator=(const Shape &shape) {
-            offset = shape.offset;
-            view = shape.view;
-            stride = shape.stride;
-            return *this;
-        }
+        Shape &operator=(const Shape &shape) = default;
 
         isize get_offset() const { return offset; }
 
@@ -120,7 +138,7 @@ namespace ax::core {
 
         const ShapeStride &get_stride() const { return stride; }
 
-        bool is_contiguous() const { return stride == get_contiguous_stride(); }
+        bool is_contiguous() const { return contiguous; }
 
         static void if_view_is_valid(const ShapeView &view) {
             if (view.size() == 0) {
@@ -157,7 +175,7 @@ namespace ax::core {
 
         isize get_ndim() const { return view.size(); }
 
-        isize get_numel() const { return std::accumulate(view.begin(), view.end(), 1, std::multiplies<isize>()); }
+        isize get_numel() const { return numel; }
 
         bool broadcastable(const ShapeView &rhs) const {
             if (view == rhs) {
@@ -236,6 +254,7 @@ namespace ax::core {
                 }
             }
 
+            broadcast_shape.update_cache();
             return std::make_pair(broadcast_shape, broadcast_dims);
         }
 
@@ -269,18 +288,70 @@ namespace ax::core {
                 }
             }
 
+            broadcast_shape.update_cache();
             return std::make_pair(broadcast_shape, broadcast_dims);
         }
 
+        // Finds the strides that let target view the same elements in the same order without copying, like NumPy
+        // Dims of size 1 are ignored, and each group of dims merged or split by the reshape must be contiguous with each other
+        std::optional<ShapeStride> get_reshape_stride(const ShapeView &target) const {
+            ShapeView old_view;
+            ShapeStride old_stride;
+            for (size_t i = 0; i < view.size(); i++) {
+                if (view[i] != 1) {
+                    old_view.push_back(view[i]);
+                    old_stride.push_back(stride[i]);
+                }
+            }
+
+            isize old_ndim = old_view.size();
+            isize new_ndim = target.size();
+            ShapeStride new_stride(new_ndim, 0);
+            isize oi = 0, oj = 1, ni = 0, nj = 1;
+
+            while (ni < new_ndim && oi < old_ndim) {
+                // Grow the old and new groups until they hold the same number of elements
+                isize np = target[ni];
+                isize op = old_view[oi];
+                while (np != op) {
+                    if (np < op) {
+                        np *= target[nj++];
+                    } else {
+                        op *= old_view[oj++];
+                    }
+                }
+                for (isize ok = oi; ok < oj - 1; ok++) {
+                    if (old_stride[ok] != old_view[ok + 1] * old_stride[ok + 1]) {
+                        return std::nullopt;
+                    }
+                }
+                new_stride[nj - 1] = old_stride[oj - 1];
+                for (isize nk = nj - 1; nk > ni; nk--) {
+                    new_stride[nk - 1] = new_stride[nk] * target[nk];
+                }
+                ni = nj++;
+                oi = oj++;
+            }
+
+            // Trailing dims of size 1
+            isize last_stride = ni > 0 ? new_stride[ni - 1] : 1;
+            for (isize nk = ni; nk < new_ndim; nk++) {
+                new_stride[nk] = last_stride;
+            }
+            return new_stride;
+        }
+
+        // Returns a view of the same elements if possible, otherwise the contiguous shape of a copy
         Shape reshape(const ShapeView &target) const {
-            // TODO: fix this
             if_view_is_valid(target);
-            isize numel = get_numel();
             isize target_numel = std::accumulate(target.begin(), target.end(), 1, std::multiplies<isize>());
             if (numel != target_numel) {
                 throw std::invalid_argument("Cannot reshape array of " + std::to_string(numel) + " to " + std::to_string(target_numel) + " elements.");
             }
-            return Shape(offset, target);
+            if (std::optional<ShapeStride> target_stride = get_reshape_stride(target)) {
+                return Shape(offset, target, *target_stride);
+            }
+            return Shape(0, target);
         }
 
         ShapeDims transpose(isize start_dim, isize end_dim) const {
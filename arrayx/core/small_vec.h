@@ -0,0 +1,198 @@
+#pragma once
+
+#include "../utils.h"
+
+namespace ax::core {
+    // Vector that stores up to N elements inline and only goes to the heap beyond that
+    // Only meant for trivially copyable elements like dimensions and strides
+    template <class T, size_t N>
+    class SmallVec {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+    private:
+        T inline_data[N];
+        std::unique_ptr<T[]> heap_data = nullptr;
+        size_t count = 0;
+        size_t capacity = N;
+
+        void grow(size_t min_capacity) {
+            if (min_capacity <= capacity) {
+                return;
+            }
+            size_t new_capacity = std::max(min_capacity, capacity * 2);
+            std::unique_ptr<T[]> new_data = std::make_unique_for_overwrite<T[]>(new_capacity);
+            std::copy_n(data(), count, new_data.get());
+            heap_data = std::move(new_data);
+            capacity = new_capacity;
+        }
+
+    public:
+        using value_type = T;
+        using size_type = size_t;
+        using reference = T &;
+        using const_reference = const T &;
+        using iterator = T *;
+        using const_iterator = const T *;
+        using reverse_iterator = std::reverse_iterator<iterator>;
+        using const_reverse_iterator = std::reverse_iterator<const_iterator>;
+
+        SmallVec() = default;
+
+        explicit SmallVec(size_t n, const T &value = T()) { assign(n, value); }
+
+        SmallVec(std::initializer_list<T> values) { assign(values.begin(), values.end()); }
+
+        template <std::input_iterator I>
+        SmallVec(I first, I last) { assign(first, last); }
+
+        SmallVec(const std::vector<T> &values) { assign(values.begin(), values.end()); }
+
+        SmallVec(const SmallVec &other) { assign(other.begin(), other.end()); }
+
+        SmallVec(SmallVec &&other) noexcept { *this = std::move(other); }
+
+        SmallVec &operator=(const SmallVec &other) {
+            if (this != &other) {
+                assign(other.begin(), other.end());
+            }
+            return *this;
+        }
+
+        SmallVec &operator=(SmallVec &&other) noexcept {
+            if (this == &other) {
+                return *this;
+            }
+            if (other.heap_data != nullptr) {
+                // Steal the heap storage instead of copying
+                heap_data = std::move(other.heap_data);
+                capacity = other.capacity;
+            } else {
+                heap_data = nullptr;
+                capacity = N;
+                std::copy_n(other.inline_data, other.count, inline_data);
+            }
+            count = other.count;
+            other.count = 0;
+            other.capacity = N;
+            return *this;
+        }
+
+        operator std::vector<T>() const { return std::vector<T>(begin(), end()); }
+
+        void assign(size_t n, const T &value) {
+            count = 0;
+            grow(n);
+            std::fill_n(data(), n, value);
+            count = n;
+        }
+
+        template <std::input_iterator I>
+        void assign(I first, I last) {
+            count = 0;
+            if constexpr (std::forward_iterator<I>) {
+                grow(std::distance(first, last));
+            }
+            for (; first != last; ++first) {
+                push_back(*first);
+            }
+        }
+
+        T *data() { return heap_data != nullptr ? heap_data.get() : inline_data; }
+        const T *data() const { return heap_data != nullptr ? heap_data.get() : inline_data; }
+        size_t size() const { return count; }
+        bool empty() const { return count == 0; }
+        void reserve(size_t n) { grow(n); }
+        void clear() { count = 0; }
+
+        void resize(size_t n, const T &value = T()) {
+            grow(n);
+            if (n > count) {
+                std::fill(data() + count, data() + n, value);
+            }
+            count = n;
+        }
+
+        void push_back(const T &value) {
+            // Copy first in case value lives in the storage being grown
+            T v = value;
+            grow(count + 1);
+            data()[count++] = v;
+        }
+
+        template <class... Args>
+        T &emplace_back(Args &&...args) {
+            push_back(T(std::forward<Args>(args)...));
+            return back();
+        }
+
+        void pop_back() { count--; }
+
+        iterator insert(const_iterator pos, size_t n, const T &value) {
+            size_t idx = pos - begin();
+            T v = value;
+            grow(count + n);
+            T *p = data();
+            std::copy_backward(p + idx, p + count, p + count + n);
+            std::fill_n(p + idx, n, v);
+            count += n;
+            return p + idx;
+        }
+
+        iterator insert(const_iterator pos, const T &value) { return insert(pos, 1, value); }
+
+        template <std::forward_iterator I>
+        iterator insert(const_iterator pos, I first, I last) {
+            size_t idx = pos - begin();
+            size_t n = std::distance(first, last);
+            // Buffer the inserted values since they may alias the storage being grown
+            std::vector<T> values(first, last);
+            grow(count + n);
+            T *p = data();
+            std::copy_backward(p + idx, p + count, p + count + n);
+            std::copy(values.begin(), values.end(), p + idx);
+            count += n;
+            return p + idx;
+        }
+
+        iterator erase(const_iterator first, const_iterator last) {
+            size_t idx = first - begin();
+            size_t n = last - first;
+            T *p = data();
+            std::copy(p + idx + n, p + count, p + idx);
+            count -= n;
+            return p + idx;
+        }
+
+        iterator erase(const_iterator pos) { return erase(pos, pos + 1); }
+
+        T &operator[](size_t i) { return data()[i]; }
+        const T &operator[](size_t i) const { return data()[i]; }
+
+        T &at(size_t i) {
+            if (i >= count) {
+                throw std::out_of_range("Index " + std::to_string(i) + " is out of range for size " + std::to_string(count) + ".");
+            }
+            return data()[i];
+        }
+
+        const T &at(size_t i) const { return const_cast<SmallVec *>(this)->at(i); }
+        T &front() { return data()[0]; }
+        const T &front() const { return data()[0]; }
+        T &back() { return data()[count - 1]; }
+        const T &back() const { return data()[count - 1]; }
+        iterator begin() { return data(); }
+        iterator end() { return data() + count; }
+        const_iterator begin() const { return data(); }
+        const_iterator end() const { return data() + count; }
+        const_iterator cbegin() const { return begin(); }
+        const_iterator cend() const { return end(); }
+        reverse_iterator rbegin() { return reverse_iterator(end()); }
+        reverse_iterator rend() { return reverse_iterator(begin()); }
+        const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+        const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+        const_reverse_iterator crbegin() const { return rbegin(); }
+        const_reverse_iterator crend() const { return rend(); }
+
+        friend bool operator==(const SmallVec &lhs, const SmallVec &rhs) { return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end()); }
+    };
+} // namespace ax::core
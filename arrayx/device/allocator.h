@@ -1,21 +1,145 @@
 #pragma once
 
 #include "../utils.h"
+#include "memory_stats.h"
+#include <array>
+#include <atomic>
+#include <mutex>
 
 namespace ax::device {
     using ax::core::isize;
 
+    // Tags every allocation made by the current thread within the scope
+    // Allocations are recorded by their allocators right away so that any thread can free them
+    class AllocationScope {
+    private:
+        static inline thread_local AllocationScope *current = nullptr;
+        AllocationScope *prev;
+        AllocationTag tag;
+        // Built on the first allocation and shared by all records of the scope
+        std::shared_ptr<const OpMemory> op = nullptr;
+
+    public:
+        AllocationScope(const AllocationTag &tag) : prev(current), tag(tag) { current = this; }
+        AllocationScope(const AllocationScope &) = delete;
+        ~AllocationScope() { current = prev; }
+        AllocationScope &operator=(const AllocationScope &) = delete;
+        static AllocationScope *get_current() { return current; }
+
+        const std::shared_ptr<const OpMemory> &get_op() {
+            if (op == nullptr) {
+                op = std::make_shared<const OpMemory>(OpMemory{std::string(tag.opname), tag.id, std::vector<isize>(tag.view, tag.view + tag.ndim), 0});
+            }
+            return op;
+        }
+    };
+
     struct Allocator : public std::enable_shared_from_this<Allocator> {
+    private:
+        struct Record {
+            std::shared_ptr<const OpMemory> op;
+            isize nbytes;
+        };
+
+        // Live allocations made within an allocation scope, sharded by address to keep frees from contending
+        struct RecordShard {
+            mutable std::mutex mutex;
+            std::unordered_map<uint8_t *, Record> records;
+        };
+
+        static constexpr isize nrecord_shards = 16;
+        std::atomic<isize> peak = 0;
+        std::atomic<isize> alloc_count = 0;
+        std::atomic<isize> free_count = 0;
+        std::array<RecordShard, nrecord_shards> record_shards;
+        // Lets frees skip the shards when no allocation was ever made within a scope
+        std::atomic<isize> nrecords = 0;
+
+        // Blocks are at least 64-byte aligned so the low bits carry no information
+        RecordShard &get_record_shard(uint8_t *ptr) { return record_shards[(reinterpret_cast<uintptr_t>(ptr) >> 6) % nrecord_shards]; }
+
     protected:
-        isize allocated = 0;
+        std::atomic<isize> allocated = 0;
+
+        void record_alloc(uint8_t *ptr, isize nbytes) {
+            isize curr = allocated += nbytes;
+            isize prev_peak = peak;
+            while (curr > prev_peak && !peak.compare_exchange_weak(prev_peak, curr)) {
+            }
+            alloc_count++;
+            if (AllocationScope *scope = AllocationScope::get_current()) {
+                RecordShard &shard = get_record_shard(ptr);
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                shard.records[ptr] = Record{scope->get_op(), nbytes};
+                nrecords++;
+            }
+        }
+
+        void record_free(uint8_t *ptr, isize nbytes) {
+            allocated -= nbytes;
+            free_count++;
+            if (nrecords == 0) {
+                return;
+            }
+            RecordShard &shard = get_record_shard(ptr);
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            if (shard.records.erase(ptr) > 0) {
+                nrecords--;
+            }
+        }
+
+        // Lets allocators that hold on to memory report it
+        virtual void fill_stats(MemoryStats &stats) const {
+            stats.reserved_bytes = stats.current_bytes;
+            stats.cache_misses = stats.alloc_count;
+        }
 
     public:
         Allocator() = default;
         Allocator(const Allocator &) = delete;
         virtual ~Allocator() = default;
         Allocator &operator=(const Allocator &) = delete;
+        // Contents of the returned memory are undefined
         virtual uint8_t *alloc(isize nbytes) = 0;
+
+        virtual uint8_t *alloc_zeroed(isize nbytes) {
+            uint8_t *ptr = alloc(nbytes);
+            std::memset(ptr, 0, nbytes);
+            return ptr;
+        }
+
         virtual void free(uint8_t *ptr, isize nbytes) = 0;
         isize get_allocated() const { return allocated; }
+        isize get_peak() const { return peak; }
+        void reset_peak() { peak = allocated.load(); }
+
+        MemoryStats get_stats() const {
+            MemoryStats stats;
+            stats.current_bytes = allocated;
+            stats.peak_bytes = peak;
+            stats.alloc_count = alloc_count;
+            stats.free_count = free_count;
+            fill_stats(stats);
+            stats.cache_hits = stats.alloc_count - stats.cache_misses;
+
+            // Group live allocations by the op that made them
+            std::unordered_map<isize, size_t> op_idx;
+            for (auto &shard : record_shards) {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                for (auto &[ptr, record] : shard.records) {
+                    auto [iter, inserted] = op_idx.try_emplace(record.op->id, stats.ops.size());
+                    if (inserted) {
+                        stats.ops.push_back(OpMemory{record.op->opname, record.op->id, record.op->view, 0});
+                    }
+                    stats.ops[iter->second].nbytes += record.nbytes;
+                }
+            }
+            std::sort(stats.ops.begin(), stats.ops.end(), [](const OpMemory &lhs, const OpMemory &rhs) { return lhs.nbytes > rhs.nbytes; });
+            return stats;
+        }
+
+        // Allocators that do not cache memory have nothing to trim
+        virtual void trim() {}
+        virtual void set_cache_cap(isize /*nbytes*/) {}
     };
 } // namespace ax::device
\ No newline at end of file
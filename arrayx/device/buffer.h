@@ -1,6 +1,8 @@
 #pragma once
 
 #include "allocator.h"
+#include <sys/mman.h>
+#include <unistd.h>
 
 namespace ax::device {
     struct Buffer : public std::enable_shared_from_this<Buffer> {
@@ -8,16 +10,27 @@ namespace ax::device {
         std::shared_ptr<Allocator> allocator = nullptr;
         uint8_t *ptr;
         isize nbytes;
+        // Whether ptr points to a file mapping instead of allocator memory
+        bool spilled = false;
+        // Tick of the last op that used the buffer, or 0 if no spill manager tracks it
+        isize last_use = 0;
+        // Number of running ops that need the buffer resident
+        isize pins = 0;
+        // Number of views handed out to other libraries, which need the buffer resident at a fixed address
+        std::atomic<isize> exports = 0;
 
         void free() {
-            if (allocator != nullptr) {
+            if (spilled) {
+                munmap(ptr, nbytes);
+            } else if (allocator != nullptr) {
                 allocator->free(ptr, nbytes);
             }
         }
 
     public:
-        Buffer(std::shared_ptr<Allocator> allocator, isize nbytes) : allocator(allocator), nbytes(nbytes) {
-            ptr = allocator->alloc(nbytes);
+        // Buffers are uninitialized unless zeroed is set
+        Buffer(std::shared_ptr<Allocator> allocator, isize nbytes, bool zeroed = false) : allocator(allocator), nbytes(nbytes) {
+            ptr = zeroed ? allocator->alloc_zeroed(nbytes) : allocator->alloc(nbytes);
         }
 
         Buffer(uint8_t *ptr, isize nbytes) : ptr(ptr), nbytes(nbytes) {}
@@ -29,10 +42,65 @@ namespace ax::device {
             allocator = nullptr;
             ptr = buff.ptr;
             nbytes = buff.nbytes;
+            spilled = false;
             return *this;
         }
 
+        // Note: the pointer changes when the buffer is spilled or faulted back in
         uint8_t *get_ptr() const { return ptr; }
         isize get_nbytes() const { return nbytes; }
+        bool is_spillable() const { return allocator != nullptr && nbytes > 0 && exports == 0; }
+        bool is_spilled() const { return spilled; }
+        isize get_last_use() const { return last_use; }
+        void set_last_use(isize tick) { last_use = tick; }
+        bool is_pinned() const { return pins > 0; }
+        void pin() { pins++; }
+        void unpin() { pins--; }
+        void retain_export() { exports++; }
+        void release_export() { exports--; }
+
+        // Moves the contents to an unlinked file in dir and returns the memory to the allocator
+        // The file mapping keeps the contents addressable until the buffer is faulted back in
+        void spill(const std::string &dir) {
+            if (spilled || !is_spillable()) {
+                return;
+            }
+            std::string path = dir + "/arrayx-spill-XXXXXX";
+            int fd = mkstemp(path.data());
+            if (fd < 0) {
+                throw std::runtime_error("Failed to create spill file in " + dir + ".");
+            }
+            unlink(path.c_str());
+            void *mapped = MAP_FAILED;
+            if (ftruncate(fd, nbytes) == 0) {
+                mapped = mmap(nullptr, nbytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+            close(fd);
+            if (mapped == MAP_FAILED) {
+                throw std::runtime_error("Failed to map spill file in " + dir + ".");
+            }
+            std::memcpy(mapped, ptr, nbytes);
+            allocator->free(ptr, nbytes);
+            ptr = static_cast<uint8_t *>(mapped);
+            spilled = true;
+        }
+
+        void fault_in() {
+            if (!spilled) {
+                return;
+            }
+            uint8_t *resident_ptr = allocator->alloc(nbytes);
+            std::memcpy(resident_ptr, ptr, nbytes);
+            munmap(ptr, nbytes);
+            ptr = resident_ptr;
+            spilled = false;
+        }
+
+        // Starts reading a spilled buffer back from disk without blocking
+        void prefetch() const {
+            if (spilled) {
+                madvise(ptr, nbytes, MADV_WILLNEED);
+            }
+        }
     };
-} // namespace ax::device
\ No newline at end of file
+} // namespace ax::device
@@ -0,0 +1,345 @@
+#pragma once
+
+#include "allocator.h"
+#include <atomic>
+#include <limits>
+#include <map>
+#include <mutex>
+#include <set>
+#include <sys/mman.h>
+
+namespace ax::device {
+    // Allocator that keeps freed blocks around for reuse instead of returning them to the system
+    // Requests are rounded up to size classes with four steps between consecutive powers of two
+    // Small blocks are first cached per thread, everything else goes back to a central pool
+    // The central pool carves blocks out of large segments, splitting and coalescing them as needed
+    // Segments are mapped straight from the system so blocks that were never handed out are still zeroed
+    // Every block starts on a 512-byte boundary and is padded to its size class so vector tails never cross into another block
+    class CachingAllocator : public Allocator {
+    private:
+        struct Block {
+            uint8_t *segment;
+            isize nbytes;
+            bool free;
+            // Whether the block belongs to a segment shared by small blocks
+            bool small;
+            // Whether the block has not been written since its segment was mapped
+            bool clean;
+        };
+
+        // Blocks freed by one thread and reused by it
+        // Its lock is only contended when another thread trims the allocator
+        struct ThreadCache {
+            std::weak_ptr<Allocator> owner;
+            std::mutex mutex;
+            std::unordered_map<isize, std::vector<uint8_t *>> blocks;
+            isize nbytes = 0;
+
+            ~ThreadCache() {
+                // Hand the blocks back so that exiting threads do not leak them
+                if (auto allocator = owner.lock()) {
+                    std::static_pointer_cast<CachingAllocator>(allocator)->flush(*this);
+                }
+            }
+        };
+
+        static constexpr isize min_block_nbytes = 512;
+        // Blocks up to this size are carved out of shared segments and cached per thread
+        static constexpr isize small_block_nbytes = 1 << 20;
+        // Segments are huge-page sized and aligned so that the system can back them with huge pages
+        static constexpr isize segment_nbytes = 2 << 20;
+        static constexpr isize thread_cache_nbytes = 16 << 20;
+        static inline std::atomic<isize> id_counter = 0;
+
+        isize id = id_counter++;
+        mutable std::mutex mutex;
+        // All blocks ordered by address so that neighbors can be found when coalescing
+        std::map<uint8_t *, Block> blocks;
+        // Free blocks ordered by size for best-fit lookups
+        // Small and large blocks are kept apart so that large requests do not fragment small segments
+        std::set<std::pair<isize, uint8_t *>> small_free_blocks;
+        std::set<std::pair<isize, uint8_t *>> large_free_blocks;
+        std::unordered_map<uint8_t *, isize> segments;
+        isize reserved = 0;
+        // Number of requests that had to map a new segment
+        isize misses = 0;
+        // Bytes of free blocks held by the central pool
+        isize pooled = 0;
+        std::atomic<isize> thread_cached = 0;
+        isize cache_cap = std::numeric_limits<isize>::max();
+        // Caches of every thread that freed small blocks, so that trimming reaches idle threads too
+        std::mutex thread_caches_mutex;
+        std::vector<std::weak_ptr<ThreadCache>> thread_caches;
+
+        static isize round_up(isize nbytes, isize multiple) { return (nbytes + multiple - 1) / multiple * multiple; }
+
+        ThreadCache &get_thread_cache() {
+            thread_local std::unordered_map<isize, std::shared_ptr<ThreadCache>> caches;
+            std::shared_ptr<ThreadCache> &cache = caches[id];
+            if (cache == nullptr) {
+                cache = std::make_shared<ThreadCache>();
+                cache->owner = weak_from_this();
+                std::lock_guard<std::mutex> lock(thread_caches_mutex);
+                // Caches of exited threads were already flushed by their destructors
+                std::erase_if(thread_caches, [](const std::weak_ptr<ThreadCache> &cache) { return cache.expired(); });
+                thread_caches.push_back(cache);
+            }
+            return *cache;
+        }
+
+        // Hands the blocks cached by every live thread back to the central pool
+        // Must be called without the mutex held since caches are locked before it
+        void flush_thread_caches() {
+            std::vector<std::shared_ptr<ThreadCache>> caches;
+            {
+                std::lock_guard<std::mutex> lock(thread_caches_mutex);
+                for (auto &cache : thread_caches) {
+                    if (auto locked = cache.lock()) {
+                        caches.push_back(locked);
+                    }
+                }
+            }
+            for (auto &cache : caches) {
+                std::lock_guard<std::mutex> lock(cache->mutex);
+                flush(*cache);
+            }
+        }
+
+        std::set<std::pair<isize, uint8_t *>> &get_free_blocks(bool small) { return small ? small_free_blocks : large_free_blocks; }
+
+        void fill_stats(MemoryStats &stats) const override {
+            std::lock_guard<std::mutex> lock(mutex);
+            stats.reserved_bytes = reserved;
+            stats.cached_bytes = pooled + thread_cached;
+            stats.cache_misses = misses;
+            isize largest = 0;
+            if (!small_free_blocks.empty()) {
+                largest = small_free_blocks.rbegin()->first;
+            }
+            if (!large_free_blocks.empty()) {
+                largest = std::max(largest, large_free_blocks.rbegin()->first);
+            }
+            stats.fragmentation = pooled == 0 ? 0 : 1 - static_cast<double>(largest) / pooled;
+        }
+
+        uint8_t *map_segment(isize nbytes) {
+            // Over-map by one segment and unmap the misaligned head and tail
+            isize mapped_nbytes = nbytes + segment_nbytes;
+            void *mapped = mmap(nullptr, mapped_nbytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANON, -1, 0);
+            if (mapped == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+            uint8_t *mapped_ptr = static_cast<uint8_t *>(mapped);
+            uint8_t *ptr = reinterpret_cast<uint8_t *>(round_up(reinterpret_cast<isize>(mapped_ptr), segment_nbytes));
+            isize head = ptr - mapped_ptr;
+            if (head > 0) {
+                munmap(mapped_ptr, head);
+            }
+            if (mapped_nbytes - head - nbytes > 0) {
+                munmap(ptr + nbytes, mapped_nbytes - head - nbytes);
+            }
+#ifdef MADV_HUGEPAGE
+            madvise(ptr, nbytes, MADV_HUGEPAGE);
+#endif
+            return ptr;
+        }
+
+        static void unmap_segment(uint8_t *segment, isize nbytes) { munmap(segment, nbytes); }
+
+        uint8_t *alloc_block(isize nbytes, bool &clean) {
+            std::lock_guard<std::mutex> lock(mutex);
+            bool small = nbytes <= small_block_nbytes;
+            auto &free_blocks = get_free_blocks(small);
+            auto iter = free_blocks.lower_bound({nbytes, nullptr});
+            uint8_t *ptr;
+
+            if (iter == free_blocks.end()) {
+                isize nsegment = small ? segment_nbytes : round_up(nbytes, segment_nbytes);
+                ptr = map_segment(nsegment);
+                misses++;
+                segments[ptr] = nsegment;
+                reserved += nsegment;
+                blocks[ptr] = Block{ptr, nsegment, false, small, true};
+            } else {
+                ptr = iter->second;
+                free_blocks.erase(iter);
+                blocks[ptr].free = false;
+                pooled -= blocks[ptr].nbytes;
+            }
+
+            // Split off the unused tail as a new free block
+            Block &block = blocks[ptr];
+            clean = block.clean;
+            block.clean = false;
+            isize remaining = block.nbytes - nbytes;
+            if (remaining >= min_block_nbytes) {
+                block.nbytes = nbytes;
+                blocks[ptr + nbytes] = Block{block.segment, remaining, true, small, clean};
+                free_blocks.insert({remaining, ptr + nbytes});
+                pooled += remaining;
+            }
+            return ptr;
+        }
+
+        // Must be called with the mutex held
+        void free_block(uint8_t *ptr) {
+            auto iter = blocks.find(ptr);
+            auto &free_blocks = get_free_blocks(iter->second.small);
+            iter->second.free = true;
+            pooled += iter->second.nbytes;
+
+            // Merge with the next block
+            auto next = std::next(iter);
+            if (next != blocks.end() && next->second.free && next->second.segment == iter->second.segment) {
+                free_blocks.erase({next->second.nbytes, next->first});
+                iter->second.nbytes += next->second.nbytes;
+                blocks.erase(next);
+            }
+            // Merge with the previous block
+            if (iter != blocks.begin()) {
+                auto prev = std::prev(iter);
+                if (prev->second.free && prev->second.segment == iter->second.segment) {
+                    free_blocks.erase({prev->second.nbytes, prev->first});
+                    prev->second.nbytes += iter->second.nbytes;
+                    // The merged block holds this block's data
+                    prev->second.clean = false;
+                    blocks.erase(iter);
+                    iter = prev;
+                }
+            }
+            free_blocks.insert({iter->second.nbytes, iter->first});
+        }
+
+        void flush(ThreadCache &cache) {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto &[nbytes, ptrs] : cache.blocks) {
+                for (uint8_t *ptr : ptrs) {
+                    free_block(ptr);
+                }
+            }
+            thread_cached -= cache.nbytes;
+            cache.blocks.clear();
+            cache.nbytes = 0;
+        }
+
+        // Returns whole free segments to the system until at most cap bytes are cached
+        // Must be called with the mutex held
+        void release_segments(isize cap) {
+            for (auto iter = segments.begin(); iter != segments.end() && pooled + thread_cached > cap;) {
+                auto [segment, nsegment] = *iter;
+                Block &block = blocks[segment];
+                if (block.free && block.nbytes == nsegment) {
+                    get_free_blocks(block.small).erase({nsegment, segment});
+                    blocks.erase(segment);
+                    unmap_segment(segment, nsegment);
+                    pooled -= nsegment;
+                    reserved -= nsegment;
+                    iter = segments.erase(iter);
+                } else {
+                    ++iter;
+                }
+            }
+        }
+
+    public:
+        CachingAllocator() = default;
+
+        ~CachingAllocator() {
+            for (auto &[segment, nsegment] : segments) {
+                unmap_segment(segment, nsegment);
+            }
+        }
+
+        static isize get_size_class(isize nbytes) {
+            if (nbytes <= min_block_nbytes) {
+                return min_block_nbytes;
+            }
+            // Four classes between consecutive powers of two keep the rounding waste under 25%
+            isize step = std::max(static_cast<isize>(std::bit_floor(static_cast<uint64_t>(nbytes - 1))) / 4, min_block_nbytes);
+            return round_up(nbytes, step);
+        }
+
+        uint8_t *alloc(isize nbytes, bool &clean) {
+            isize size_class = get_size_class(nbytes);
+            uint8_t *ptr = nullptr;
+            if (size_class <= small_block_nbytes) {
+                ThreadCache &cache = get_thread_cache();
+                std::lock_guard<std::mutex> lock(cache.mutex);
+                auto iter = cache.blocks.find(size_class);
+                if (iter != cache.blocks.end() && !iter->second.empty()) {
+                    ptr = iter->second.back();
+                    iter->second.pop_back();
+                    cache.nbytes -= size_class;
+                    thread_cached -= size_class;
+                    clean = false;
+                }
+            }
+            if (ptr == nullptr) {
+                ptr = alloc_block(size_class, clean);
+            }
+            record_alloc(ptr, nbytes);
+            return ptr;
+        }
+
+        uint8_t *alloc(isize nbytes) override {
+            bool clean;
+            return alloc(nbytes, clean);
+        }
+
+        uint8_t *alloc_zeroed(isize nbytes) override {
+            bool clean;
+            uint8_t *ptr = alloc(nbytes, clean);
+            // Freshly mapped pages are already zeroed by the system
+            if (!clean) {
+                std::memset(ptr, 0, nbytes);
+            }
+            return ptr;
+        }
+
+        void free(uint8_t *ptr, isize nbytes) override {
+            isize size_class = get_size_class(nbytes);
+            record_free(ptr, nbytes);
+            if (size_class <= small_block_nbytes) {
+                ThreadCache &cache = get_thread_cache();
+                std::lock_guard<std::mutex> lock(cache.mutex);
+                if (cache.nbytes + size_class <= thread_cache_nbytes) {
+                    cache.blocks[size_class].push_back(ptr);
+                    cache.nbytes += size_class;
+                    thread_cached += size_class;
+                    return;
+                }
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            free_block(ptr);
+            if (pooled + thread_cached > cache_cap) {
+                release_segments(cache_cap);
+            }
+        }
+
+        // Returns the blocks cached by every thread and every unused segment to the system
+        void trim() override {
+            flush_thread_caches();
+            std::lock_guard<std::mutex> lock(mutex);
+            release_segments(0);
+        }
+
+        void set_cache_cap(isize nbytes) override {
+            bool over_cap;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                cache_cap = nbytes;
+                over_cap = pooled + thread_cached > cache_cap;
+            }
+            // Blocks held by thread caches pin their segments, so they are drained when over the cap
+            if (over_cap) {
+                flush_thread_caches();
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            release_segments(cache_cap);
+        }
+
+        isize get_cache_cap() const { return cache_cap; }
+        isize get_reserved() const { return reserved; }
+        isize get_cached() const { return pooled + thread_cached; }
+    };
+} // namespace ax::device
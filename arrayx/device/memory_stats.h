@@ -0,0 +1,40 @@
+#pragma once
+
+#include "../utils.h"
+
+namespace ax::device {
+    using ax::core::isize;
+
+    // Op on whose behalf memory is being allocated
+    struct AllocationTag {
+        std::string_view opname;
+        isize id;
+        const isize *view;
+        size_t ndim;
+    };
+
+    // Live bytes attributed to the op that allocated them
+    struct OpMemory {
+        std::string opname;
+        isize id;
+        std::vector<isize> view;
+        isize nbytes;
+    };
+
+    struct MemoryStats {
+        isize current_bytes = 0;
+        isize peak_bytes = 0;
+        // Bytes held from the system, including cached memory
+        isize reserved_bytes = 0;
+        isize cached_bytes = 0;
+        isize alloc_count = 0;
+        isize free_count = 0;
+        isize cache_hits = 0;
+        isize cache_misses = 0;
+        // Fraction of the cached bytes that are not part of the largest free block
+        double fragmentation = 0;
+        std::vector<OpMemory> ops;
+
+        double get_cache_hit_rate() const { return alloc_count == 0 ? 0 : static_cast<double>(cache_hits) / alloc_count; }
+    };
+} // namespace ax::device
@@ -1,22 +1,10 @@
 #pragma once
 
-#include "../allocator.h"
+#include "../caching_allocator.h"
 
 namespace ax::device::metal {
-    using ax::device::Allocator;
+    using ax::device::CachingAllocator;
 
-    struct MTLAllocator : public Allocator {
-    public:
-        uint8_t *alloc(isize nbytes) override {
-            allocated += nbytes;
-            auto ptr = new uint8_t[nbytes];
-            std::memset(ptr, 0, nbytes);
-            return ptr;
-        }
-
-        void free(uint8_t *ptr, isize nbytes) override {
-            allocated -= nbytes;
-            delete[] ptr;
-        }
+    struct MTLAllocator : public CachingAllocator {
     };
 } // namespace ax::device::metal
\ No newline at end of file
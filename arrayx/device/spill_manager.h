@@ -0,0 +1,187 @@
+#pragma once
+
+#include "buffer.h"
+#include <filesystem>
+#include <mutex>
+#include <span>
+#include <utility>
+
+namespace ax::device {
+    // Keeps the buffers it tracks within a resident memory budget
+    // Once the budget is exceeded, the least recently used buffers not pinned by a running op are spilled to disk
+    // Runners fault spilled buffers back in and pin them right before the op consuming them
+    class SpillManager {
+    private:
+        isize budget;
+        std::string dir;
+        isize tick = 0;
+        std::vector<std::weak_ptr<Buffer>> buffs;
+        // Ops may run on several threads at once
+        mutable std::mutex mutex;
+
+        // Marks the buffer as the most recently used, tracking it if needed
+        // Must be called with the mutex held
+        void touch(const std::shared_ptr<Buffer> &buff) {
+            if (buff == nullptr || !buff->is_spillable()) {
+                return;
+            }
+            if (buff->get_last_use() == 0) {
+                buffs.push_back(buff);
+            }
+            buff->set_last_use(++tick);
+        }
+
+        // Must be called with the mutex held
+        static void unpin(std::span<const std::shared_ptr<Buffer>> pinned) {
+            for (auto &buff : pinned) {
+                if (buff != nullptr) {
+                    buff->unpin();
+                }
+            }
+        }
+
+        // Spills least recently used buffers until the resident ones fit in the budget
+        // Must be called with the mutex held
+        void enforce() {
+            std::erase_if(buffs, [](const std::weak_ptr<Buffer> &buff) { return buff.expired(); });
+            isize resident = 0;
+            std::vector<std::shared_ptr<Buffer>> candidates;
+            for (auto &weak_buff : buffs) {
+                std::shared_ptr<Buffer> buff = weak_buff.lock();
+                if (buff->is_spilled()) {
+                    continue;
+                }
+                resident += buff->get_nbytes();
+                if (!buff->is_pinned()) {
+                    candidates.push_back(buff);
+                }
+            }
+            if (resident <= budget) {
+                return;
+            }
+            std::sort(candidates.begin(), candidates.end(), [](const std::shared_ptr<Buffer> &lhs, const std::shared_ptr<Buffer> &rhs) { return lhs->get_last_use() < rhs->get_last_use(); });
+            for (auto &buff : candidates) {
+                if (resident <= budget) {
+                    break;
+                }
+                buff->spill(dir);
+                resident -= buff->get_nbytes();
+            }
+        }
+
+    public:
+        SpillManager(isize budget, const std::string &dir = "") : budget(budget), dir(dir.empty() ? std::filesystem::temp_directory_path().string() : dir) {
+            if (budget < 0) {
+                throw std::invalid_argument("Spill budget must be non-negative.");
+            }
+        }
+
+        SpillManager(const SpillManager &) = delete;
+        SpillManager &operator=(const SpillManager &) = delete;
+
+        // Faults the buffers in and keeps them resident until they are released
+        // Buffers pinned before a failed fault are unpinned again
+        void acquire(const std::vector<std::shared_ptr<Buffer>> &in_buffs) {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (size_t i = 0; i < in_buffs.size(); i++) {
+                if (in_buffs[i] == nullptr) {
+                    continue;
+                }
+                try {
+                    in_buffs[i]->fault_in();
+                } catch (...) {
+                    unpin(std::span(in_buffs.data(), i));
+                    throw;
+                }
+                in_buffs[i]->pin();
+                touch(in_buffs[i]);
+            }
+        }
+
+        // Unpins the buffers, tracks the op's output and spills cold buffers beyond the budget
+        void release(const std::vector<std::shared_ptr<Buffer>> &in_buffs, const std::shared_ptr<Buffer> &out_buff) {
+            std::lock_guard<std::mutex> lock(mutex);
+            unpin(in_buffs);
+            touch(out_buff);
+            enforce();
+        }
+
+        // Unpins the buffers of an op that failed without touching anything else
+        void abandon(const std::vector<std::shared_ptr<Buffer>> &in_buffs) {
+            std::lock_guard<std::mutex> lock(mutex);
+            unpin(in_buffs);
+        }
+
+        // Faults the buffer in for a view handed out to another library, after which it is never spilled until the view is gone
+        void retain_export(const std::shared_ptr<Buffer> &buff) {
+            std::lock_guard<std::mutex> lock(mutex);
+            buff->fault_in();
+            buff->retain_export();
+        }
+
+        void prefetch(const std::shared_ptr<Buffer> &buff) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (buff == nullptr || !buff->is_spilled()) {
+                return;
+            }
+            buff->prefetch();
+            touch(buff);
+        }
+
+        // Faults every spilled buffer back in
+        void restore() {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto &weak_buff : buffs) {
+                if (std::shared_ptr<Buffer> buff = weak_buff.lock()) {
+                    buff->fault_in();
+                }
+            }
+        }
+
+        isize get_budget() const { return budget; }
+        const std::string &get_dir() const { return dir; }
+
+        isize get_spilled() const {
+            std::lock_guard<std::mutex> lock(mutex);
+            isize nbytes = 0;
+            for (auto &weak_buff : buffs) {
+                std::shared_ptr<Buffer> buff = weak_buff.lock();
+                if (buff != nullptr && buff->is_spilled()) {
+                    nbytes += buff->get_nbytes();
+                }
+            }
+            return nbytes;
+        }
+    };
+
+    // Pins the operands of an op while it runs and unpins them even if its kernel throws
+    class PinScope {
+    private:
+        std::shared_ptr<SpillManager> manager;
+        std::vector<std::shared_ptr<Buffer>> in_buffs;
+
+    public:
+        PinScope(std::shared_ptr<SpillManager> manager, std::vector<std::shared_ptr<Buffer>> in_buffs) : manager(manager), in_buffs(std::move(in_buffs)) {
+            if (this->manager != nullptr) {
+                this->manager->acquire(this->in_buffs);
+            }
+        }
+
+        PinScope(const PinScope &) = delete;
+        PinScope &operator=(const PinScope &) = delete;
+
+        ~PinScope() {
+            if (manager != nullptr) {
+                manager->abandon(in_buffs);
+            }
+        }
+
+        // Unpins the operands once the op produced its output
+        void release(const std::shared_ptr<Buffer> &out_buff) {
+            std::shared_ptr<SpillManager> released = std::exchange(manager, nullptr);
+            if (released != nullptr) {
+                released->release(in_buffs, out_buff);
+            }
+        }
+    };
+} // namespace ax::device
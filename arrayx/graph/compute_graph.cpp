@@ -1,6 +1,14 @@
 #include "compute_graph.h"
 
 namespace ax::graph {
+    // Tracked consumers turn gradients of their operands on while other consumers leave them as they are
+    // since the operand may also feed tracked consumers visited later or in graphs built on other threads
+    static void enable_operand_grad(const OpPtr &consumer, const OpPtr &operand) {
+        if (consumer->is_grad_enabled() && !operand->is_grad_enabled()) {
+            operand->enable_grad(true);
+        }
+    }
+
     void ComputeGraph::fw_toposort(OpPtr op) {
         LazyPtr lazy = op->get_lazy();
         if (visited.contains(lazy->get_id())) {
@@ -13,37 +21,51 @@ namespace ax::graph {
             break;
         }
         case Optype::UNARY: {
-            std::shared_ptr<UnaryOp> unary_op = std::static_pointer_cast<UnaryOp>(op);
+            NodePtr<UnaryOp> unary_op = static_pointer_cast<UnaryOp>(op);
             OpPtr operand = unary_op->get_operand();
-            operand->enable_grad(unary_op->is_grad_enabled());
+            enable_operand_grad(unary_op, operand);
             fw_toposort(operand);
             fw_order.push_back(op);
             break;
         }
         case Optype::BINARY: {
-            std::shared_ptr<BinaryOp> binary_op = std::static_pointer_cast<BinaryOp>(op);
+            NodePtr<BinaryOp> binary_op = static_pointer_cast<BinaryOp>(op);
             OpPtr lhs = binary_op->get_lhs();
             OpPtr rhs = binary_op->get_rhs();
-            lhs->enable_grad(binary_op->is_grad_enabled());
-            rhs->enable_grad(binary_op->is_grad_enabled());
+            enable_operand_grad(binary_op, lhs);
+            enable_operand_grad(binary_op, rhs);
             fw_toposort(lhs);
             fw_toposort(rhs);
             fw_order.push_back(op);
             break;
         }
+        case Optype::TERNARY: {
+            NodePtr<TernaryOp> ternary_op = static_pointer_cast<TernaryOp>(op);
+            OpPtr first = ternary_op->get_first();
+            OpPtr second = ternary_op->get_second();
+            OpPtr third = ternary_op->get_third();
+            enable_operand_grad(ternary_op, first);
+            enable_operand_grad(ternary_op, second);
+            enable_operand_grad(ternary_op, third);
+            fw_toposort(first);
+            fw_toposort(second);
+            fw_toposort(third);
+            fw_order.push_back(op);
+            break;
+        }
         case Optype::TRANSFORM: {
-            std::shared_ptr<TransformOp> transform_op = std::static_pointer_cast<TransformOp>(op);
+            NodePtr<TransformOp> transform_op = static_pointer_cast<TransformOp>(op);
             OpPtr operand = transform_op->get_operand();
-            operand->enable_grad(transform_op->is_grad_enabled());
+            enable_operand_grad(transform_op, operand);
             fw_toposort(operand);
             fw_order.push_back(op);
             break;
         }
         default: {
             // Reduce operation
-            std::shared_ptr<ReduceOp> reduce_op = std::static_pointer_cast<ReduceOp>(op);
+            NodePtr<ReduceOp> reduce_op = static_pointer_cast<ReduceOp>(op);
             OpPtr operand = reduce_op->get_operand();
-            operand->enable_grad(reduce_op->is_grad_enabled());
+            enable_operand_grad(reduce_op, operand);
             fw_toposort(operand);
             fw_order.push_back(op);
             break;
@@ -63,14 +85,14 @@ namespace ax::graph {
             break;
         }
         case Optype::UNARY: {
-            std::shared_ptr<UnaryOp> unary_op = std::static_pointer_cast<UnaryOp>(op);
+            NodePtr<UnaryOp> unary_op = static_pointer_cast<UnaryOp>(op);
             OpPtr operand = unary_op->get_operand();
             bw_toposort(operand);
             bw_order.push_back(op);
             break;
         }
         case Optype::BINARY: {
-            std::shared_ptr<BinaryOp> binary_op = std::static_pointer_cast<BinaryOp>(op);
+            NodePtr<BinaryOp> binary_op = static_pointer_cast<BinaryOp>(op);
             OpPtr lhs = binary_op->get_lhs();
             OpPtr rhs = binary_op->get_rhs();
             bw_toposort(lhs);
@@ -78,8 +100,16 @@ namespace ax::graph {
             bw_order.push_back(op);
             break;
         }
+        case Optype::TERNARY: {
+            NodePtr<TernaryOp> ternary_op = static_pointer_cast<TernaryOp>(op);
+            bw_toposort(ternary_op->get_first());
+            bw_toposort(ternary_op->get_second());
+            bw_toposort(ternary_op->get_third());
+            bw_order.push_back(op);
+            break;
+        }
         case Optype::TRANSFORM: {
-            std::shared_ptr<TransformOp> transform_op = std::static_pointer_cast<TransformOp>(op);
+            NodePtr<TransformOp> transform_op = static_pointer_cast<TransformOp>(op);
             OpPtr operand = transform_op->get_operand();
             bw_toposort(operand);
             bw_order.push_back(op);
@@ -87,7 +117,7 @@ namespace ax::graph {
         }
         default: {
             // Reduce operation
-            std::shared_ptr<ReduceOp> reduce_op = std::static_pointer_cast<ReduceOp>(op);
+            NodePtr<ReduceOp> reduce_op = static_pointer_cast<ReduceOp>(op);
             OpPtr operand = reduce_op->get_operand();
             bw_toposort(operand);
             bw_order.push_back(op);
@@ -96,9 +126,119 @@ namespace ax::graph {
         }
     }
 
+    void ComputeGraph::plan_buff_reuse() {
+        // Counts how many times each op is consumed by another op in the graph
+        std::unordered_map<Id, isize> consumers;
+        auto count_consumer = [&](const OpPtr &operand) { consumers[operand->get_lazy()->get_id()]++; };
+        for (auto &op : fw_order) {
+            switch (op->get_optype()) {
+            case Optype::INITIALIZER:
+                break;
+            case Optype::BINARY: {
+                NodePtr<BinaryOp> binary_op = static_pointer_cast<BinaryOp>(op);
+                count_consumer(binary_op->get_lhs());
+                count_consumer(binary_op->get_rhs());
+                break;
+            }
+            case Optype::TERNARY: {
+                NodePtr<TernaryOp> ternary_op = static_pointer_cast<TernaryOp>(op);
+                count_consumer(ternary_op->get_first());
+                count_consumer(ternary_op->get_second());
+                count_consumer(ternary_op->get_third());
+                break;
+            }
+            case Optype::UNARY:
+                count_consumer(static_pointer_cast<UnaryOp>(op)->get_operand());
+                break;
+            case Optype::TRANSFORM:
+                count_consumer(static_pointer_cast<TransformOp>(op)->get_operand());
+                break;
+            default:
+                count_consumer(static_pointer_cast<ReduceOp>(op)->get_operand());
+                break;
+            }
+        }
+
+        // An operand can donate its buffer to an element-wise consumer if:
+        // - it was created in inference mode so no gradient needs it later
+        // - it owns a freshly allocated buffer, i.e. it is not a view or an in-place result
+        // - the consumer is its only user and nothing outside the graph refers to it
+        // - the buffer matches the consumer's output in size, type and layout
+        auto can_donate = [&](const OpPtr &operand, const OpPtr &op) {
+            if (!operand->is_inference() || operand == output) {
+                return false;
+            }
+            switch (operand->get_optype()) {
+            case Optype::UNARY: {
+                if (static_pointer_cast<UnaryOp>(operand)->is_in_place()) {
+                    return false;
+                }
+                break;
+            }
+            case Optype::BINARY: {
+                NodePtr<BinaryOp> binary_operand = static_pointer_cast<BinaryOp>(operand);
+                if (binary_operand->get_mode() == BinaryMode::MATMUL || binary_operand->get_mode() == BinaryMode::INDEX) {
+                    return false;
+                }
+                if (binary_operand->get_mode() == BinaryMode::ELMWISE && static_pointer_cast<ElmwiseBinaryOp>(binary_operand)->is_in_place()) {
+                    return false;
+                }
+                break;
+            }
+            case Optype::REDUCE:
+                break;
+            default:
+                return false;
+            }
+            if (consumers[operand->get_lazy()->get_id()] != 1 || operand->is_externally_referenced()) {
+                return false;
+            }
+            LazyPtr in_lazy = operand->get_lazy();
+            LazyPtr out_lazy = op->get_lazy();
+            return in_lazy->get_dtype() == out_lazy->get_dtype() &&
+                   in_lazy->get_view() == out_lazy->get_view() &&
+                   in_lazy->is_contiguous() && out_lazy->is_contiguous() &&
+                   in_lazy->get_offset() == 0 && out_lazy->get_offset() == 0;
+        };
+
+        for (auto &op : fw_order) {
+            if (!op->is_inference()) {
+                continue;
+            }
+            if (op->get_optype() == Optype::UNARY) {
+                NodePtr<UnaryOp> unary_op = static_pointer_cast<UnaryOp>(op);
+                OpPtr operand = unary_op->get_operand();
+                // Counts are accumulated into a zeroed output so they cannot start from the operand's words
+                if (unary_op->get_opcode() == Opcode::COUNT_MASK) {
+                    continue;
+                }
+                if (!unary_op->is_in_place() && can_donate(operand, op)) {
+                    op->set_buff_donor(operand->get_lazy());
+                }
+            } else if (op->get_optype() == Optype::BINARY) {
+                NodePtr<BinaryOp> binary_op = static_pointer_cast<BinaryOp>(op);
+                // Convolutions read whole windows of their operands so they cannot write over them
+                if (binary_op->get_mode() == BinaryMode::MATMUL || binary_op->get_mode() == BinaryMode::INDEX || binary_op->get_mode() == BinaryMode::CONV) {
+                    continue;
+                }
+                if (binary_op->get_mode() == BinaryMode::ELMWISE && static_pointer_cast<ElmwiseBinaryOp>(binary_op)->is_in_place()) {
+                    continue;
+                }
+                OpPtr lhs = binary_op->get_lhs();
+                OpPtr rhs = binary_op->get_rhs();
+                if (can_donate(lhs, op)) {
+                    op->set_buff_donor(lhs->get_lazy());
+                } else if (can_donate(rhs, op)) {
+                    op->set_buff_donor(rhs->get_lazy());
+                }
+            }
+        }
+    }
+
     void ComputeGraph::forward() {
         if (fw_order.empty()) {
             fw_toposort(output);
+            plan_buff_reuse();
         }
     }
 
@@ -106,16 +246,33 @@ namespace ax::graph {
         if (fw_order.empty()) {
             throw ComputeGraphNotForwardedException();
         }
+        // Arrays read by backward must not have been overwritten by in-place operations
+        for (auto &op : fw_order) {
+            if (op->is_grad_enabled()) {
+                op->check_saved_versions();
+            }
+        }
         if (bw_order.empty()) {
             LazyPtr lazy = output->get_lazy();
+            if (!output->is_tracked() || output->is_inference()) {
+                throw std::runtime_error("Array " + lazy->get_id().str() + " was created with gradient tracking disabled and cannot do gradient backpropagation.");
+            }
             if (lazy->get_numel() > 1) {
                 throw std::invalid_argument("Array " + lazy->get_id().str() + " must be a singleton to do gradient backpropation.");
             }
+            if (lazy->get_dtype()->get_type() != DtypeType::FLOAT) {
+                throw std::runtime_error("Only arrays of floating-point types can have gradients but array " + lazy->get_id().str() + " has type " + lazy->get_dtype()->str());
+            }
+            // Gradients of ops shared with previously backpropagated graphs belong to those graphs
+            for (auto &op : fw_order) {
+                op->reset_grad();
+            }
             // Initializes gradient with 1's
             output->init_grad(false);
             // Initializes the gradient array first without allocating buffers
             for (auto &op : std::views::reverse(fw_order)) {
-                if (op->is_grad_enabled()) {
+                // Integer ops feeding promoted binary ops receive no gradient
+                if (op->is_grad_enabled() && op->grad != nullptr) {
                     op->backward();
                 }
             }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "ops.h"
+#include <mutex>
 
 namespace ax::graph {
     class ComputeGraph : public std::enable_shared_from_this<ComputeGraph> {
@@ -9,13 +10,25 @@ namespace ax::graph {
         std::unordered_set<Id> visited;
         std::vector<OpPtr> fw_order;
         std::vector<OpPtr> bw_order;
+        // Serializes building and running the graph when several threads evaluate the same arrays
+        std::recursive_mutex mutex;
+        // Whether the graph was run at least once
+        bool run = false;
+        // Whether gradients of the latest forward run were already accumulated
+        bool backpropagated = false;
 
         void fw_toposort(OpPtr op);
         void bw_toposort(OpPtr op);
+        void plan_buff_reuse();
 
     public:
         ComputeGraph(OpPtr output) : output(output) {}
         OpPtr get_output() const { return output; }
+        std::recursive_mutex &get_mutex() { return mutex; }
+        bool has_run() const { return run; }
+        void set_run() { run = true; }
+        bool is_backpropagated() const { return backpropagated; }
+        void set_backpropagated(bool backpropagated) { this->backpropagated = backpropagated; }
         void forward();
         void backward();
         virtual void compile() = 0;
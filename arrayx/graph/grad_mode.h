@@ -0,0 +1,93 @@
+#pragma once
+
+#include "../core/dtype.h"
+#include "../utils.h"
+
+namespace ax::graph {
+    using namespace ax::core;
+
+    // Thread-local switches read by ops when they are constructed
+    // Gradient mode controls whether new ops take part in autograd
+    // Inference mode additionally lets the graph builder recycle dead intermediate buffers
+    struct GradMode {
+    private:
+        static thread_local bool enabled;
+        static thread_local bool inference;
+
+    public:
+        static bool is_enabled() { return enabled; }
+        static void set_enabled(bool enabled) { GradMode::enabled = enabled; }
+        static bool is_inference() { return inference; }
+        static void set_inference(bool inference) { GradMode::inference = inference; }
+    };
+
+    inline thread_local bool GradMode::enabled = true;
+    inline thread_local bool GradMode::inference = false;
+
+    // Disables gradient tracking for ops created in the current scope
+    class NoGradGuard {
+    private:
+        bool prev_enabled;
+
+    public:
+        NoGradGuard() : prev_enabled(GradMode::is_enabled()) { GradMode::set_enabled(false); }
+        NoGradGuard(const NoGradGuard &) = delete;
+        ~NoGradGuard() { GradMode::set_enabled(prev_enabled); }
+        NoGradGuard &operator=(const NoGradGuard &) = delete;
+    };
+
+    // Same as NoGradGuard but also marks the new ops as inference ops
+    class InferenceModeGuard {
+    private:
+        bool prev_enabled;
+        bool prev_inference;
+
+    public:
+        InferenceModeGuard() : prev_enabled(GradMode::is_enabled()), prev_inference(GradMode::is_inference()) {
+            GradMode::set_enabled(false);
+            GradMode::set_inference(true);
+        }
+
+        InferenceModeGuard(const InferenceModeGuard &) = delete;
+
+        ~InferenceModeGuard() {
+            GradMode::set_enabled(prev_enabled);
+            GradMode::set_inference(prev_inference);
+        }
+
+        InferenceModeGuard &operator=(const InferenceModeGuard &) = delete;
+    };
+
+    // Low precision dtype picked by ops created while autocasting, nullptr when autocasting is off
+    // Matmuls and element-wise ops reading a low precision operand run in it
+    // Reductions, exponentials and logarithms of low precision arrays produce f32 to keep softmax and losses accurate
+    struct AutocastMode {
+    private:
+        static thread_local DtypePtr dtype;
+
+    public:
+        static DtypePtr get_dtype() { return dtype; }
+        static bool is_enabled() { return dtype != nullptr; }
+
+        static void set_dtype(DtypePtr dtype) {
+            if (dtype != nullptr && dtype != &f16 && dtype != &bf16) {
+                throw std::invalid_argument("Cannot autocast to data type " + dtype->str() + ", only f16 and bf16 are supported.");
+            }
+            AutocastMode::dtype = dtype;
+        }
+    };
+
+    inline thread_local DtypePtr AutocastMode::dtype = nullptr;
+
+    // Autocasts the ops created in the current scope
+    class AutocastGuard {
+    private:
+        DtypePtr prev_dtype;
+
+    public:
+        AutocastGuard(DtypePtr dtype = &f16) : prev_dtype(AutocastMode::get_dtype()) { AutocastMode::set_dtype(dtype); }
+        AutocastGuard(const AutocastGuard &) = delete;
+        ~AutocastGuard() { AutocastMode::set_dtype(prev_dtype); }
+        AutocastGuard &operator=(const AutocastGuard &) = delete;
+    };
+} // namespace ax::graph
@@ -20,6 +20,11 @@ namespace ax::graph::metal {
             NS::AutoreleasePool *pool = NS::AutoreleasePool::alloc()->init();
             auto ns_name = NS::String::string(name.c_str(), NS::UTF8StringEncoding);
             function = NS::TransferPtr<MTL::Function>(lib->newFunction(ns_name));
+            if (function.get() == nullptr) {
+                // The library has no kernel of that name
+                pool->release();
+                return;
+            }
             // TODO: handle error
             NS::Error *error = nullptr;
             state = NS::TransferPtr<MTL::ComputePipelineState>(device->newComputePipelineState(function.get(), &error));
@@ -5,17 +5,42 @@ namespace ax::graph {
         if (grad == nullptr) {
             DtypePtr dtype = lazy->get_dtype();
             if (dtype->get_type() != DtypeType::FLOAT) {
-                throw std::runtime_error("Only arrays of floating-point types can have gradients but array " + lazy->get_id().str() + " has type " + dtype->str());
+                // Integer operands of promoted binary ops take no gradient
+                return;
             }
             const ShapeView &view = lazy->get_shape().get_view();
             DtypePtr grad_dtype = float_dtype_by_dtype.at(dtype);
             DevicePtr device = lazy->get_device();
-            grad = with_zeros ? zeros(view, grad_dtype, device) : ones(view, grad_dtype, device);
+            if (get_optype() == Optype::INITIALIZER) {
+                // Leaves accumulate into their persistent buffer, which is zeroed when first allocated
+                if (persistent_grad == nullptr) {
+                    persistent_grad = Lazy::empty(Shape(view), grad_dtype, device);
+                }
+                grad = make_node<Nop>(persistent_grad);
+                if (!with_zeros) {
+                    grad = inplace_add(grad, ones(view, grad_dtype, device));
+                }
+            } else {
+                grad = with_zeros ? zeros(view, grad_dtype, device) : ones(view, grad_dtype, device);
+            }
             grad_root = grad;
         }
     }
 
+    void Op::check_saved_versions() const {
+        for (auto &[saved_lazy, version] : saved) {
+            if (saved_lazy->get_version() != version) {
+                throw SavedArrayModified(get_opname(), saved_lazy->get_id().str(), version, saved_lazy->get_version());
+            }
+        }
+    }
+
     void Op::update_grad(OpPtr grad, bool sub) {
+        if (this->grad == nullptr) {
+            return;
+        }
+        // Gradients flowing out of mixed precision ops are accumulated in the gradient's own dtype
+        grad = astype(grad, this->grad->get_lazy()->get_dtype());
         this->grad = sub ? inplace_sub(this->grad, grad) : inplace_add(this->grad, grad);
         this->grad_root = this->grad;
     }
@@ -68,26 +93,88 @@ namespace ax::graph {
         // z = min(x, y)
         // dx += dz * (1 where x is min and 0 otherwise)
         // dy += dz * (1 where y is min and 0 otherwise)
-        OpPtr out_op = de_op();
-        OpPtr lminimum = astype(eq(de_lhs(), out_op), out_op->get_lazy()->get_dtype());
-        OpPtr rminimum = astype(eq(de_rhs(), out_op), out_op->get_lazy()->get_dtype());
+        // Both masks are fused into the gradient kernel
+        // The mask compares mixed operands in the promoted dtype like the forward kernel
+        OpPtr de_lop = astype(de_lhs(), lazy->get_dtype());
+        OpPtr de_rop = astype(de_rhs(), lazy->get_dtype());
         lhs->init_grad();
-        lhs->update_grad(mul(grad, lminimum));
+        lhs->update_grad(minimum_grad(de_lop, de_rop, grad));
         rhs->init_grad();
-        rhs->update_grad(mul(grad, rminimum));
+        rhs->update_grad(minimum_grad(de_rop, de_lop, grad));
     }
 
     void MaximumOp::backward() const {
         // z = max(x, y)
         // dx += dz * (1 where x is max and 0 otherwise)
         // dy += dz * (1 where y is max and 0 otherwise)
-        OpPtr out_op = de_op();
-        OpPtr lmaximum = astype(eq(de_lhs(), out_op), out_op->get_lazy()->get_dtype());
-        OpPtr rmaximum = astype(eq(de_rhs(), out_op), out_op->get_lazy()->get_dtype());
+        // Both masks are fused into the gradient kernel
+        // The mask compares mixed operands in the promoted dtype like the forward kernel
+        OpPtr de_lop = astype(de_lhs(), lazy->get_dtype());
+        OpPtr de_rop = astype(de_rhs(), lazy->get_dtype());
+        lhs->init_grad();
+        lhs->update_grad(maximum_grad(de_lop, de_rop, grad));
+        rhs->init_grad();
+        rhs->update_grad(maximum_grad(de_rop, de_lop, grad));
+    }
+
+    void MaximumGradOp::backward() const {
+        // z = x >= y ? g : 0
+        // dg += dz * (1 where x >= y and 0 otherwise)
+        // The mask is piecewise constant so x and y get no gradient
+        third->init_grad();
+        third->update_grad(maximum_grad(de_first(), de_second(), grad));
+    }
+
+    void MinimumGradOp::backward() const {
+        // z = x <= y ? g : 0
+        // dg += dz * (1 where x <= y and 0 otherwise)
+        third->init_grad();
+        third->update_grad(minimum_grad(de_first(), de_second(), grad));
+    }
+
+    void MaskMulOp::backward() const {
+        // z = x where m else 0
+        // dx += dz where m else 0
         lhs->init_grad();
-        lhs->update_grad(mul(grad, lmaximum));
+        lhs->update_grad(mask_mul(grad, de_rhs()));
+    }
+
+    void IndexGradOp::backward() const {
+        // z[i, j] = j == idx[i] ? g[i] : 0
+        // dg[i] += dz[i, idx[i]]
+        // Gathers with a one-hot mask built by the same kernel
+        OpPtr mask = index_grad(de_lhs(), ones_like(rhs, rhs->get_lazy()->get_dtype(), rhs->get_lazy()->get_device()), lazy->get_view());
+        OpPtr masked_grad = mul(grad, mask);
+        // All reduction has a single row spanning the whole array
+        OpPtr row_grad = rhs->get_lazy()->get_numel() == 1 ? sum(masked_grad) : sum(masked_grad, {1});
         rhs->init_grad();
-        rhs->update_grad(mul(grad, rmaximum));
+        rhs->update_grad(row_grad);
+    }
+
+    void LinearOp::backward() const {
+        // z = x @ w^T + b, out = act(z)
+        // dz = dout * act'(z)
+        // dx += dz @ w
+        // dw += dz^T @ x
+        // db += sum(dz) over the rows
+        // Tracked layers are only fused with activations whose gradient can be read from the output
+        OpPtr pre_grad = activation == Activation::RELU ? relu_grad(de_op(), grad) : grad;
+        first->init_grad();
+        first->update_grad(matmul(pre_grad, de_second()));
+        second->init_grad();
+        second->update_grad(matmul(transpose(pre_grad, 0, 1), de_first()));
+        third->init_grad();
+        third->update_grad(reshape(sum(pre_grad, {0}), third->get_lazy()->get_view()));
+    }
+
+    void Conv2dOp::backward() const {
+        // z = conv2d(x, w)
+        // dx += every output gradient scattered back through the weights to the inputs it was read from
+        // dw += correlation of x with dz over the batch
+        lhs->init_grad();
+        lhs->update_grad(conv2d_input_grad(grad, de_rhs(), lhs->get_lazy()->get_view(), params));
+        rhs->init_grad();
+        rhs->update_grad(conv2d_weight_grad(de_lhs(), grad, rhs->get_lazy()->get_view(), params));
     }
 
     void MatmulOp::backward() const {
@@ -140,6 +227,51 @@ namespace ax::graph {
         operand->update_grad(mul(grad, de_op()));
     }
 
+    void GeluOp::backward() const {
+        // z = gelu(x)
+        // dx += dz * gelu'(x)
+        operand->init_grad();
+        operand->update_grad(gelu_grad(de_operand(), grad));
+    }
+
+    void SiluOp::backward() const {
+        // z = x * sigmoid(x)
+        // dx += dz * sigmoid(x) * (1 + x * (1 - sigmoid(x)))
+        operand->init_grad();
+        operand->update_grad(silu_grad(de_operand(), grad));
+    }
+
+    void SoftmaxOp::backward() const {
+        // z = softmax(x)
+        // dx += z * (dz - sum(dz * z))
+        operand->init_grad();
+        operand->update_grad(softmax_grad(de_op(), grad));
+    }
+
+    void LogSoftmaxOp::backward() const {
+        // z = log_softmax(x)
+        // dx += dz - softmax(x) * sum(dz)
+        // dx += dz - exp(z) * sum(dz)
+        operand->init_grad();
+        operand->update_grad(log_softmax_grad(de_op(), grad));
+    }
+
+    void LogsumexpOp::backward() const {
+        // z = log(sum(exp(x)))
+        // dx += dz * exp(x) / sum(exp(x))
+        // dx += dz * softmax(x)
+        operand->init_grad();
+        operand->update_grad(mul(grad, softmax(de_operand())));
+    }
+
+    void CrossEntropyOp::backward() const {
+        // z = logsumexp(x) - x[y]
+        // dx += dz * (softmax(x) - onehot(y))
+        // Labels are integers and never take gradients
+        lhs->init_grad();
+        lhs->update_grad(cross_entropy_grad(de_lhs(), de_rhs(), grad));
+    }
+
     void LogOp::backward() const {
         // z = log(x)
         // dx += dz / x
@@ -201,41 +333,42 @@ namespace ax::graph {
         operand->update_grad(squeeze(grad, dims));
     }
 
-    void SumOp::backward() const {
+    void AstypeOp::backward() const {
         operand->init_grad();
         operand->update_grad(grad);
     }
 
-    void MaxOp::backward() const {
+    void SumOp::backward() const {
         operand->init_grad();
-        // Column reduction: operand's array is of shape (d1, d2) and "this" array is of shape (d1, 1)
-        // All reduction: operand's array is of shape (d1, d2, etc.) and "this" array is of shape (1)
-        // eq() handles broadcasting automatically
-        OpPtr mask = eq(operand, de_op());
-        operand->update_grad(mul(astype(mask, operand->get_lazy()->get_dtype()), grad));
+        operand->update_grad(grad);
     }
 
-    void MinOp::backward() const {
+    void ExtremumOp::backward() const {
         operand->init_grad();
         // Column reduction: operand's array is of shape (d1, d2) and "this" array is of shape (d1, 1)
         // All reduction: operand's array is of shape (d1, d2, etc.) and "this" array is of shape (1)
-        // eq() handles broadcasting automatically
-        OpPtr mask = eq(operand, de_op());
-        operand->update_grad(mul(astype(mask, operand->get_lazy()->get_dtype()), grad));
+        // The gradient only flows to the index of the extremum in each row, located by the forward pass
+        OpPtr idx = make_node<Nop>(index);
+        operand->update_grad(index_grad(idx, grad, operand->get_lazy()->get_view()));
     }
 
     OpPtr detach(OpPtr op) {
-        // Shared array -> shared buffer -> buffer goes out of scope -> Memory is freed twice
-        // Solution: separate buffers using same memory region
+        // Detached arrays share the operand's buffer instead of its memory address
+        // so that they follow the buffer when it is spilled, faulted back in or freed
+        // The detached array starts a new version history so updates made outside of autograd,
+        // e.g. optimizer steps, do not invalidate graphs that are run again
+        op->set_aliased();
         LazyPtr in_lazy = op->get_lazy();
-        LazyPtr out_lazy = Lazy::from_ptr(in_lazy->get_ptr(), in_lazy->get_nbytes(), in_lazy->get_shape(), in_lazy->get_dtype(), in_lazy->get_device());
-        return std::make_shared<Nop>(out_lazy);
+        LazyPtr out_lazy = Lazy::empty(in_lazy->get_shape(), in_lazy->get_dtype(), in_lazy->get_device());
+        // Operands that were not run yet share their buffer when the detached array is run
+        out_lazy->init_buff(in_lazy->get_buff());
+        return make_node<Nop>(out_lazy, in_lazy);
     }
 
     OpPtr empty_like(OpPtr op, DtypePtr dtype, DevicePtr device) {
         LazyPtr in_lazy = op->get_lazy();
         LazyPtr out_lazy = Lazy::empty(in_lazy->get_shape(), dtype, device);
-        return std::make_shared<Nop>(out_lazy);
+        return make_node<Nop>(out_lazy);
     }
 
     isize item(OpPtr op) {
@@ -256,13 +389,13 @@ namespace ax::graph {
 
     OpPtr arange(const ShapeView &view, isize start, isize step, DtypePtr dtype, DevicePtr device) {
         LazyPtr lazy = Lazy::empty(Shape(view), dtype, device);
-        OpPtr op = std::make_shared<ArangeOp>(lazy, view, start, step, dtype);
+        OpPtr op = make_node<ArangeOp>(lazy, view, start, step, dtype);
         return op;
     }
 
     OpPtr from_ptr(uint8_t *ptr, isize nbytes, const Shape &shape, DtypePtr dtype, DevicePtr device) {
         LazyPtr lazy = Lazy::from_ptr(ptr, nbytes, shape, dtype, device);
-        OpPtr op = std::make_shared<Nop>(lazy);
+        OpPtr op = make_node<Nop>(lazy);
         return op;
     }
 
@@ -282,7 +415,7 @@ namespace ax::graph {
 
         const ShapeDims &broadcast_dims = broadcast_result.second;
         LazyPtr out_lazy = Lazy::empty(broadcast_shape, in_lazy->get_dtype(), in_lazy->get_device());
-        OpPtr out_op = std::make_shared<BroadcastOp>(out_lazy, op, in_view, view, broadcast_dims);
+        OpPtr out_op = make_node<BroadcastOp>(out_lazy, op, in_view, view, broadcast_dims);
         return out_op;
     }
 
@@ -302,14 +435,14 @@ namespace ax::graph {
 
         const ShapeDims &broadcast_dims = broadcast_result.second;
         LazyPtr out_lazy = Lazy::empty(broadcast_shape, in_lazy->get_dtype(), in_lazy->get_device());
-        OpPtr out_op = std::make_shared<BroadcastOp>(out_lazy, op, in_view, view, broadcast_dims);
+        OpPtr out_op = make_node<BroadcastOp>(out_lazy, op, in_view, view, broadcast_dims);
         return out_op;
     }
 
     OpPtr slice(OpPtr in_op, const RangeVec &ranges) {
         LazyPtr in_lazy = in_op->get_lazy();
         LazyPtr out_lazy = Lazy::empty(in_lazy->get_shape().slice(ranges), in_lazy->get_dtype(), in_lazy->get_device());
-        OpPtr out_op = std::make_shared<SliceOp>(out_lazy, in_op, ranges);
+        OpPtr out_op = make_node<SliceOp>(out_lazy, in_op, ranges);
         return out_op;
     }
 
@@ -318,22 +451,23 @@ namespace ax::graph {
         if (in_lazy->get_dtype() == dtype) {
             return in_op;
         }
-        LazyPtr out_lazy = Lazy::empty(in_lazy->get_shape(), dtype, in_lazy->get_device());
-        OpPtr out_op = std::make_shared<AstypeOp>(out_lazy, in_op, dtype);
+        // The cast writes a fresh contiguous buffer so strided inputs are gathered by the same copy
+        LazyPtr out_lazy = Lazy::empty(Shape(in_lazy->get_view()), dtype, in_lazy->get_device());
+        OpPtr out_op = make_node<AstypeOp>(out_lazy, in_op, dtype);
         return out_op;
     }
 
     OpPtr unsqueeze(OpPtr in_op, const ShapeDims &dims) {
         LazyPtr in_lazy = in_op->get_lazy();
         LazyPtr out_lazy = Lazy::empty(in_lazy->get_shape().unsqueeze(dims), in_lazy->get_dtype(), in_lazy->get_device());
-        OpPtr out_op = std::make_shared<UnsqueezeOp>(out_lazy, in_op, dims);
+        OpPtr out_op = make_node<UnsqueezeOp>(out_lazy, in_op, dims);
         return out_op;
     }
 
     OpPtr squeeze(OpPtr in_op, const ShapeDims &dims) {
         LazyPtr in_lazy = in_op->get_lazy();
         LazyPtr out_lazy = Lazy::empty(in_lazy->get_shape().squeeze(dims), in_lazy->get_dtype(), in_lazy->get_device());
-        OpPtr out_op = std::make_shared<SqueezeOp>(out_lazy, in_op, dims);
+        OpPtr out_op = make_node<SqueezeOp>(out_lazy, in_op, dims);
         return out_op;
     }
 
@@ -342,27 +476,11 @@ namespace ax::graph {
     OpPtr mul(OpPtr lop, OpPtr rop) { return elmwise_binary<MulOp>(lop, rop); }
     OpPtr div(OpPtr lop, OpPtr rop) { return elmwise_binary<DivOp>(lop, rop); }
 
-    OpPtr matmul(OpPtr lop, OpPtr rop) {
-        LazyPtr llazy = lop->get_lazy();
-        LazyPtr rlazy = rop->get_lazy();
-        const Shape &lshape = llazy->get_shape();
-        const ShapeView &lview = llazy->get_view();
-        const ShapeView &rview = rlazy->get_view();
-        DtypePtr ldtype = llazy->get_dtype();
-        DtypePtr rdtype = rlazy->get_dtype();
-        DevicePtr ldevice = llazy->get_device();
-        DevicePtr rdevice = rlazy->get_device();
-
-        if (!lshape.matmul_broadcastable(rview)) {
-            throw IncompatShapesForOp(MatmulOp::opname, vnumstr(lview), vnumstr(rview));
-        }
-        if (!binary_dtypes.contains(ldtype) || ldtype != rdtype) {
-            throw IncompatDtypesForOp(MatmulOp::opname, ldtype->str(), rdtype->str());
-        }
-        if (ldevice != rdevice) {
-            throw IncompatDevicesForOp(MatmulOp::opname, ldevice->str(), rdevice->str());
-        }
-
+    // Broadcasts the batch dimensions of lhs and rhs and folds them into a single one
+    // Returns lhs as (B, M, K), rhs as (B, K, N) and the view the (B, M, N) result is reshaped to
+    static std::tuple<OpPtr, OpPtr, ShapeView> fold_matmul_operands(OpPtr lop, OpPtr rop) {
+        const ShapeView &lview = lop->get_lazy()->get_view();
+        const ShapeView &rview = rop->get_lazy()->get_view();
         ShapeView broadcasted_lview = lview;
         ShapeView broadcasted_rview = rview;
         size_t ndim = std::max(broadcasted_lview.size(), broadcasted_rview.size());
@@ -397,16 +515,268 @@ namespace ax::graph {
         OpPtr mm_rop = broadcast(rop, broadcasted_rview);
         mm_rop = reshape(mm_rop, mm_rview);
 
+        // Expected result's shape
+        ShapeView out_view = broadcasted_lview;
+        out_view[out_view.size() - 1] = rview[rview.size() - 1];
+        return {mm_lop, mm_rop, out_view};
+    }
+
+    OpPtr matmul(OpPtr lop, OpPtr rop) {
+        lop = autocast(lop);
+        rop = autocast(rop);
+        LazyPtr llazy = lop->get_lazy();
+        LazyPtr rlazy = rop->get_lazy();
+        const Shape &lshape = llazy->get_shape();
+        const ShapeView &lview = llazy->get_view();
+        const ShapeView &rview = rlazy->get_view();
+        DtypePtr ldtype = llazy->get_dtype();
+        DtypePtr rdtype = rlazy->get_dtype();
+        DevicePtr ldevice = llazy->get_device();
+        DevicePtr rdevice = rlazy->get_device();
+
+        if (!lshape.matmul_broadcastable(rview)) {
+            throw IncompatShapesForOp(MatmulOp::opname, vnumstr(lview), vnumstr(rview));
+        }
+        if (!binary_dtypes.contains(ldtype) || ldtype != rdtype) {
+            throw IncompatDtypesForOp(MatmulOp::opname, ldtype->str(), rdtype->str());
+        }
+        if (ldevice != rdevice) {
+            throw IncompatDevicesForOp(MatmulOp::opname, ldevice->str(), rdevice->str());
+        }
+
+        auto [mm_lop, mm_rop, out_view] = fold_matmul_operands(lop, rop);
         // Result's shape: B, M, K
         ShapeView mm_view = mm_lop->get_lazy()->get_view();
         mm_view[mm_view.size() - 1] = rview[rview.size() - 1];
         LazyPtr mm_arr = Lazy::empty(Shape(mm_view), ldtype, ldevice);
-        OpPtr out_op = std::make_shared<MatmulOp>(mm_arr, mm_lop, mm_rop);
+        OpPtr out_op = make_node<MatmulOp>(mm_arr, mm_lop, mm_rop);
 
         // Reshape to expected result's shape
-        ShapeView reshaped_mm_view = broadcasted_lview;
-        reshaped_mm_view[reshaped_mm_view.size() - 1] = rview[rview.size() - 1];
-        out_op = reshape(out_op, reshaped_mm_view);
+        out_op = reshape(out_op, out_view);
+        return out_op;
+    }
+
+    OpPtr linear(OpPtr in_op, OpPtr weight_op, OpPtr bias_op, Activation activation) {
+        in_op = autocast(in_op);
+        weight_op = autocast(weight_op);
+        bias_op = autocast(bias_op);
+        LazyPtr in_lazy = in_op->get_lazy();
+        LazyPtr weight_lazy = weight_op->get_lazy();
+        LazyPtr bias_lazy = bias_op->get_lazy();
+        const ShapeView &in_view = in_lazy->get_view();
+        const ShapeView &weight_view = weight_lazy->get_view();
+        DtypePtr in_dtype = in_lazy->get_dtype();
+        DevicePtr in_device = in_lazy->get_device();
+
+        if (in_view.empty() || weight_view.size() != 2 || in_view.back() != weight_view[1]) {
+            throw IncompatShapesForOp(LinearOp::opname, vnumstr(in_view), vnumstr(weight_view));
+        }
+        if (bias_lazy->get_view() != ShapeView{weight_view[0]}) {
+            throw IncompatShapesForOp(LinearOp::opname, vnumstr(weight_view), vnumstr(bias_lazy->get_view()));
+        }
+        if (!float_dtypes.contains(in_dtype) || in_dtype != weight_lazy->get_dtype()) {
+            throw IncompatDtypesForOp(LinearOp::opname, in_dtype->str(), weight_lazy->get_dtype()->str());
+        }
+        if (in_dtype != bias_lazy->get_dtype()) {
+            throw IncompatDtypesForOp(LinearOp::opname, in_dtype->str(), bias_lazy->get_dtype()->str());
+        }
+        if (in_device != weight_lazy->get_device()) {
+            throw IncompatDevicesForOp(LinearOp::opname, in_device->str(), weight_lazy->get_device()->str());
+        }
+        if (in_device != bias_lazy->get_device()) {
+            throw IncompatDevicesForOp(LinearOp::opname, in_device->str(), bias_lazy->get_device()->str());
+        }
+
+        // Leading dimensions are folded into the rows of a single matrix and every operand is read contiguously
+        isize nrow = in_lazy->get_numel() / in_view.back();
+        OpPtr mm_in_op = reshape(in_op, {nrow, in_view.back()});
+        mm_in_op = mm_in_op->get_lazy()->is_contiguous() ? mm_in_op : copy(mm_in_op);
+        OpPtr mm_weight_op = weight_lazy->is_contiguous() ? weight_op : copy(weight_op);
+        OpPtr mm_bias_op = bias_lazy->is_contiguous() ? bias_op : copy(bias_op);
+
+        // GELU and SiLU gradients need the operands of the activations, which the fused kernel never writes out,
+        // so layers tracked by autograd keep them by running the activations on their own
+        bool keep_operand = GradMode::is_enabled() && (activation == Activation::GELU || activation == Activation::SILU);
+        LazyPtr out_lazy = Lazy::empty(Shape({nrow, weight_view[0]}), in_dtype, in_device);
+        OpPtr out_op = make_node<LinearOp>(out_lazy, mm_in_op, mm_weight_op, mm_bias_op, keep_operand ? Activation::NONE : activation);
+        if (keep_operand) {
+            // Same dtype as the fused path, whereas gelu and silu would compute autocasted arrays in f32
+            LazyPtr act_lazy = Lazy::empty(Shape(out_lazy->get_view()), in_dtype, in_device);
+            if (activation == Activation::GELU) {
+                out_op = make_node<GeluOp>(act_lazy, out_op, false);
+            } else {
+                out_op = make_node<SiluOp>(act_lazy, out_op, false);
+            }
+        }
+
+        ShapeView out_view = in_view;
+        out_view.back() = weight_view[0];
+        return reshape(out_op, out_view);
+    }
+
+    // Output size of a convolution along one spatial dimension, nullopt if the dilated kernel does not fit the padded input
+    // Checked before dividing since the division truncates toward zero and would turn a slightly negative span into one output
+    static std::optional<isize> conv_out_size(isize in_size, isize kernel_size, isize stride, isize padding, isize dilation) {
+        isize span = in_size + 2 * padding - dilation * (kernel_size - 1) - 1;
+        if (span < 0) {
+            return std::nullopt;
+        }
+        return span / stride + 1;
+    }
+
+    static void check_conv2d_params(const Conv2dParams &params) {
+        if (params.stride.size() != 2 || params.padding.size() != 2 || params.dilation.size() != 2) {
+            throw std::invalid_argument("Stride, padding and dilation of conv2d must be pairs of (height, width).");
+        }
+        for (isize i = 0; i < 2; i++) {
+            if (params.stride[i] <= 0 || params.dilation[i] <= 0 || params.padding[i] < 0) {
+                throw std::invalid_argument("Invalid conv2d parameters " + params.str() + ".");
+            }
+        }
+        if (params.groups <= 0) {
+            throw std::invalid_argument("Invalid conv2d parameters " + params.str() + ".");
+        }
+    }
+
+    // The kernels index contiguous float operands of the same dtype
+    template <class O>
+    static std::pair<OpPtr, OpPtr> conv_operands(OpPtr lop, OpPtr rop) {
+        LazyPtr llazy = lop->get_lazy();
+        LazyPtr rlazy = rop->get_lazy();
+        if (!float_dtypes.contains(llazy->get_dtype()) || llazy->get_dtype() != rlazy->get_dtype()) {
+            throw IncompatDtypesForOp(O::opname, llazy->get_dtype()->str(), rlazy->get_dtype()->str());
+        }
+        if (llazy->get_device() != rlazy->get_device()) {
+            throw IncompatDevicesForOp(O::opname, llazy->get_device()->str(), rlazy->get_device()->str());
+        }
+        OpPtr contiguous_lop = llazy->is_contiguous() ? lop : copy(lop);
+        OpPtr contiguous_rop = rlazy->is_contiguous() ? rop : copy(rop);
+        return {contiguous_lop, contiguous_rop};
+    }
+
+    // Output shape of a convolution, throwing if the weight does not fit the input
+    static ShapeView conv2d_out_view(const ShapeView &in_view, const ShapeView &weight_view, const Conv2dParams &params) {
+        check_conv2d_params(params);
+        if (in_view.size() != 4 || weight_view.size() != 4 ||
+            in_view[1] % params.groups != 0 || weight_view[0] % params.groups != 0 ||
+            weight_view[1] != in_view[1] / params.groups) {
+            throw IncompatShapesForOp(Conv2dOp::opname, vnumstr(in_view), vnumstr(weight_view));
+        }
+        std::optional<isize> out_h = conv_out_size(in_view[2], weight_view[2], params.stride[0], params.padding[0], params.dilation[0]);
+        std::optional<isize> out_w = conv_out_size(in_view[3], weight_view[3], params.stride[1], params.padding[1], params.dilation[1]);
+        if (!out_h.has_value() || !out_w.has_value()) {
+            throw IncompatShapesForOp(Conv2dOp::opname, vnumstr(in_view), vnumstr(weight_view));
+        }
+        return {in_view[0], weight_view[0], *out_h, *out_w};
+    }
+
+    OpPtr conv2d(OpPtr in_op, OpPtr weight_op, const Conv2dParams &params) {
+        in_op = autocast(in_op);
+        weight_op = autocast(weight_op);
+        ShapeView out_view = conv2d_out_view(in_op->get_lazy()->get_view(), weight_op->get_lazy()->get_view(), params);
+        auto [conv_in_op, conv_weight_op] = conv_operands<Conv2dOp>(in_op, weight_op);
+        LazyPtr in_lazy = conv_in_op->get_lazy();
+        LazyPtr out_lazy = Lazy::empty(Shape(out_view), in_lazy->get_dtype(), in_lazy->get_device());
+        OpPtr out_op = make_node<Conv2dOp>(out_lazy, conv_in_op, conv_weight_op, params);
+        return out_op;
+    }
+
+    OpPtr conv2d_input_grad(OpPtr grad_op, OpPtr weight_op, const ShapeView &in_view, const Conv2dParams &params) {
+        if (grad_op->get_lazy()->get_view() != conv2d_out_view(in_view, weight_op->get_lazy()->get_view(), params)) {
+            throw IncompatShapesForOp(Conv2dInputGradOp::opname, vnumstr(grad_op->get_lazy()->get_view()), vnumstr(weight_op->get_lazy()->get_view()));
+        }
+        auto [conv_grad_op, conv_weight_op] = conv_operands<Conv2dInputGradOp>(grad_op, weight_op);
+        LazyPtr grad_lazy = conv_grad_op->get_lazy();
+        LazyPtr out_lazy = Lazy::empty(Shape(in_view), grad_lazy->get_dtype(), grad_lazy->get_device());
+        OpPtr out_op = make_node<Conv2dInputGradOp>(out_lazy, conv_grad_op, conv_weight_op, params);
+        return out_op;
+    }
+
+    OpPtr conv2d_weight_grad(OpPtr in_op, OpPtr grad_op, const ShapeView &weight_view, const Conv2dParams &params) {
+        if (grad_op->get_lazy()->get_view() != conv2d_out_view(in_op->get_lazy()->get_view(), weight_view, params)) {
+            throw IncompatShapesForOp(Conv2dWeightGradOp::opname, vnumstr(in_op->get_lazy()->get_view()), vnumstr(grad_op->get_lazy()->get_view()));
+        }
+        auto [conv_in_op, conv_grad_op] = conv_operands<Conv2dWeightGradOp>(in_op, grad_op);
+        LazyPtr in_lazy = conv_in_op->get_lazy();
+        LazyPtr out_lazy = Lazy::empty(Shape(weight_view), in_lazy->get_dtype(), in_lazy->get_device());
+        OpPtr out_op = make_node<Conv2dWeightGradOp>(out_lazy, conv_in_op, conv_grad_op, params);
+        return out_op;
+    }
+
+    OpPtr quantize(OpPtr in_op, OpPtr scale_op) {
+        LazyPtr in_lazy = in_op->get_lazy();
+        LazyPtr scale_lazy = scale_op->get_lazy();
+        const ShapeView &in_view = in_lazy->get_view();
+        const ShapeView &scale_view = scale_lazy->get_view();
+        DtypePtr in_dtype = in_lazy->get_dtype();
+        DtypePtr scale_dtype = scale_lazy->get_dtype();
+        DevicePtr in_device = in_lazy->get_device();
+        DevicePtr scale_device = scale_lazy->get_device();
+
+        if (!in_lazy->get_shape().broadcastable(scale_view)) {
+            throw IncompatShapesForOp(QuantizeOp::opname, vnumstr(in_view), vnumstr(scale_view));
+        }
+        if (!quant_dtypes.contains(in_dtype) || in_dtype != scale_dtype) {
+            throw IncompatDtypesForOp(QuantizeOp::opname, in_dtype->str(), scale_dtype->str());
+        }
+        if (in_device != scale_device) {
+            throw IncompatDevicesForOp(QuantizeOp::opname, in_device->str(), scale_device->str());
+        }
+
+        OpPtr broadcasted_in_op = broadcast(in_op, scale_view);
+        OpPtr broadcasted_scale_op = broadcast(scale_op, in_view);
+        LazyPtr out_lazy = Lazy::empty(Shape(broadcasted_in_op->get_lazy()->get_view()), &i8, in_device);
+        OpPtr out_op = make_node<QuantizeOp>(out_lazy, broadcasted_in_op, broadcasted_scale_op);
+        return out_op;
+    }
+
+    OpPtr dequantize(OpPtr in_op, OpPtr scale_op) {
+        DtypePtr in_dtype = in_op->get_lazy()->get_dtype();
+        DtypePtr scale_dtype = scale_op->get_lazy()->get_dtype();
+        if (in_dtype != &i8 || !quant_dtypes.contains(scale_dtype)) {
+            throw IncompatDtypesForOp("dequantize", in_dtype->str(), scale_dtype->str());
+        }
+        return mul(astype(in_op, scale_dtype), scale_op);
+    }
+
+    OpPtr qmatmul(OpPtr lop, OpPtr rop, OpPtr scale_op) {
+        LazyPtr llazy = lop->get_lazy();
+        LazyPtr rlazy = rop->get_lazy();
+        LazyPtr scale_lazy = scale_op->get_lazy();
+        const Shape &lshape = llazy->get_shape();
+        const ShapeView &lview = llazy->get_view();
+        const ShapeView &rview = rlazy->get_view();
+        DtypePtr ldtype = llazy->get_dtype();
+        DtypePtr rdtype = rlazy->get_dtype();
+        DtypePtr scale_dtype = scale_lazy->get_dtype();
+        DevicePtr ldevice = llazy->get_device();
+        DevicePtr rdevice = rlazy->get_device();
+        DevicePtr scale_device = scale_lazy->get_device();
+
+        if (!lshape.matmul_broadcastable(rview)) {
+            throw IncompatShapesForOp(QMatmulOp::opname, vnumstr(lview), vnumstr(rview));
+        }
+        if (ldtype != &i8 || rdtype != &i8) {
+            throw IncompatDtypesForOp(QMatmulOp::opname, ldtype->str(), rdtype->str());
+        }
+        if (!quant_dtypes.contains(scale_dtype)) {
+            throw IncompatDtypeForOp(QMatmulOp::opname, scale_dtype->str());
+        }
+        if (ldevice != rdevice) {
+            throw IncompatDevicesForOp(QMatmulOp::opname, ldevice->str(), rdevice->str());
+        }
+        if (ldevice != scale_device) {
+            throw IncompatDevicesForOp(QMatmulOp::opname, ldevice->str(), scale_device->str());
+        }
+
+        auto [mm_lop, mm_rop, out_view] = fold_matmul_operands(lop, rop);
+        const ShapeView &mm_lview = mm_lop->get_lazy()->get_view();
+        ShapeView mm_view = {mm_lview[0], mm_lview[1], rview[rview.size() - 1]};
+        // Scales are read at the same position as the result, usually through zero strides
+        OpPtr mm_scale_op = reshape(broadcast_to(scale_op, out_view), mm_view);
+        LazyPtr mm_arr = Lazy::empty(Shape(mm_view), scale_dtype, ldevice);
+        OpPtr out_op = make_node<QMatmulOp>(mm_arr, mm_lop, mm_rop, mm_scale_op);
+        out_op = reshape(out_op, out_view);
         return out_op;
     }
 
@@ -414,14 +784,231 @@ namespace ax::graph {
     OpPtr inplace_sub(OpPtr lop, OpPtr rop) { return inplace_binary<SubOp>(lop, rop); }
     OpPtr inplace_mul(OpPtr lop, OpPtr rop) { return inplace_binary<MulOp>(lop, rop); }
     OpPtr inplace_div(OpPtr lop, OpPtr rop) { return inplace_binary<DivOp>(lop, rop); }
-    OpPtr eq(OpPtr lop, OpPtr rop) { return cmp<EqOp>(lop, rop, all_dtypes); }
-    OpPtr neq(OpPtr lop, OpPtr rop) { return cmp<NeqOp>(lop, rop, all_dtypes); }
-    OpPtr lt(OpPtr lop, OpPtr rop) { return cmp<LtOp>(lop, rop, numeric_dtypes); }
-    OpPtr gt(OpPtr lop, OpPtr rop) { return cmp<GtOp>(lop, rop, numeric_dtypes); }
-    OpPtr leq(OpPtr lop, OpPtr rop) { return cmp<LeqOp>(lop, rop, numeric_dtypes); }
-    OpPtr geq(OpPtr lop, OpPtr rop) { return cmp<GeqOp>(lop, rop, numeric_dtypes); }
+    OpPtr eq(OpPtr lop, OpPtr rop) { return cmp<EqOp>(lop, rop, eq_dtypes); }
+    OpPtr neq(OpPtr lop, OpPtr rop) { return cmp<NeqOp>(lop, rop, eq_dtypes); }
+    OpPtr lt(OpPtr lop, OpPtr rop) { return cmp<LtOp>(lop, rop, cmp_dtypes); }
+    OpPtr gt(OpPtr lop, OpPtr rop) { return cmp<GtOp>(lop, rop, cmp_dtypes); }
+    OpPtr leq(OpPtr lop, OpPtr rop) { return cmp<LeqOp>(lop, rop, cmp_dtypes); }
+    OpPtr geq(OpPtr lop, OpPtr rop) { return cmp<GeqOp>(lop, rop, cmp_dtypes); }
     OpPtr minimum(OpPtr lop, OpPtr rop) { return elmwise_binary<MinimumOp>(lop, rop); }
     OpPtr maximum(OpPtr lop, OpPtr rop) { return elmwise_binary<MaximumOp>(lop, rop); }
+    OpPtr maximum_grad(OpPtr lop, OpPtr rop, OpPtr grad_op) { return elmwise_ternary<MaximumGradOp>(lop, rop, grad_op); }
+    OpPtr minimum_grad(OpPtr lop, OpPtr rop, OpPtr grad_op) { return elmwise_ternary<MinimumGradOp>(lop, rop, grad_op); }
+
+    OpPtr index_grad(OpPtr idx_op, OpPtr grad_op, const ShapeView &view) {
+        LazyPtr idx_lazy = idx_op->get_lazy();
+        LazyPtr grad_lazy = grad_op->get_lazy();
+        DtypePtr grad_dtype = grad_lazy->get_dtype();
+        DevicePtr grad_device = grad_lazy->get_device();
+
+        if (idx_lazy->get_view() != grad_lazy->get_view()) {
+            throw IncompatShapesForOp(IndexGradOp::opname, vnumstr(idx_lazy->get_view()), vnumstr(grad_lazy->get_view()));
+        }
+        if (idx_lazy->get_dtype() != &i32 || !binary_dtypes.contains(grad_dtype)) {
+            throw IncompatDtypesForOp(IndexGradOp::opname, idx_lazy->get_dtype()->str(), grad_dtype->str());
+        }
+        if (idx_lazy->get_device() != grad_device) {
+            throw IncompatDevicesForOp(IndexGradOp::opname, idx_lazy->get_device()->str(), grad_device->str());
+        }
+
+        // The kernel reads one index and one gradient per row
+        OpPtr contiguous_idx = idx_lazy->is_contiguous() ? idx_op : copy(idx_op);
+        OpPtr contiguous_grad = grad_lazy->is_contiguous() ? grad_op : copy(grad_op);
+        LazyPtr out_lazy = Lazy::empty(Shape(view), grad_dtype, grad_device);
+        OpPtr out_op = make_node<IndexGradOp>(out_lazy, contiguous_idx, contiguous_grad);
+        return out_op;
+    }
+
+    // Number of words holding the packed mask of an array of numel elements
+    static isize mask_nwords(isize numel) { return (numel + 31) / 32; }
+
+    OpPtr pack_mask(OpPtr in_op) {
+        LazyPtr in_lazy = in_op->get_lazy();
+        if (in_lazy->get_dtype() != &b8) {
+            throw IncompatDtypeForOp(PackMaskOp::opname, in_lazy->get_dtype()->str());
+        }
+        LazyPtr out_lazy = Lazy::empty(Shape({mask_nwords(in_lazy->get_numel())}), &i32, in_lazy->get_device());
+        OpPtr out_op = make_node<PackMaskOp>(out_lazy, in_op);
+        return out_op;
+    }
+
+    OpPtr count_mask(OpPtr mask_op) {
+        LazyPtr mask_lazy = mask_op->get_lazy();
+        if (mask_lazy->get_dtype() != &i32) {
+            throw IncompatDtypeForOp(CountMaskOp::opname, mask_lazy->get_dtype()->str());
+        }
+        OpPtr contiguous_mask = mask_lazy->is_contiguous() ? mask_op : copy(mask_op);
+        LazyPtr out_lazy = Lazy::empty(Shape({1}), &i32, mask_lazy->get_device());
+        OpPtr out_op = make_node<CountMaskOp>(out_lazy, contiguous_mask);
+        return out_op;
+    }
+
+    OpPtr mask_mul(OpPtr lop, OpPtr mask_op) {
+        LazyPtr llazy = lop->get_lazy();
+        const ShapeView &lview = llazy->get_view();
+        DtypePtr ldtype = llazy->get_dtype();
+        DevicePtr ldevice = llazy->get_device();
+
+        // Boolean masks are broadcasted to lhs and packed first
+        if (mask_op->get_lazy()->get_dtype() == &b8) {
+            mask_op = pack_mask(broadcast_to(mask_op, lview));
+        }
+        LazyPtr mask_lazy = mask_op->get_lazy();
+        if (!binary_dtypes.contains(ldtype) || mask_lazy->get_dtype() != &i32) {
+            throw IncompatDtypesForOp(MaskMulOp::opname, ldtype->str(), mask_lazy->get_dtype()->str());
+        }
+        if (mask_lazy->get_ndim() != 1 || mask_lazy->get_numel() != mask_nwords(llazy->get_numel())) {
+            throw IncompatShapesForOp(MaskMulOp::opname, vnumstr(lview), vnumstr(mask_lazy->get_view()));
+        }
+        if (ldevice != mask_lazy->get_device()) {
+            throw IncompatDevicesForOp(MaskMulOp::opname, ldevice->str(), mask_lazy->get_device()->str());
+        }
+
+        OpPtr contiguous_mask = mask_lazy->is_contiguous() ? mask_op : copy(mask_op);
+        LazyPtr out_lazy = Lazy::empty(Shape(lview), ldtype, ldevice);
+        OpPtr out_op = make_node<MaskMulOp>(out_lazy, lop, contiguous_mask);
+        return out_op;
+    }
+
+    OpPtr count_nonzero(OpPtr in_op) {
+        if (in_op->get_lazy()->get_dtype() != &b8) {
+            in_op = neq(in_op, 0);
+        }
+        return count_mask(pack_mask(in_op));
+    }
+
+    OpPtr any(OpPtr in_op) { return gt(count_nonzero(in_op), 0); }
+
+    OpPtr all(OpPtr in_op) { return eq(count_nonzero(in_op), in_op->get_lazy()->get_numel()); }
+
+    // Integers are cast to floats, half floats are computed in f32 while autocasting
+    // and the kernels read whole rows of contiguous arrays
+    template <class O>
+    static OpPtr row_op(OpPtr in_op, bool reduce) {
+        DtypePtr in_dtype = in_op->get_lazy()->get_dtype();
+        auto float_dtype = float_dtype_by_dtype.find(in_dtype);
+        if (float_dtype == float_dtype_by_dtype.end()) {
+            throw IncompatDtypeForOp(O::opname, in_dtype->str());
+        }
+        DtypePtr result_dtype = autocast_accum_dtype(float_dtype->second);
+        in_op = astype(in_op, result_dtype);
+        if (!in_op->get_lazy()->is_contiguous()) {
+            in_op = copy(in_op);
+        }
+        LazyPtr in_lazy = in_op->get_lazy();
+        ShapeView view = in_lazy->get_view();
+        if (reduce) {
+            view.back() = 1;
+        }
+        LazyPtr out_lazy = Lazy::empty(Shape(view), result_dtype, in_lazy->get_device());
+        OpPtr out_op = make_node<O>(out_lazy, in_op);
+        return out_op;
+    }
+
+    OpPtr softmax(OpPtr in_op) { return row_op<SoftmaxOp>(in_op, false); }
+    OpPtr log_softmax(OpPtr in_op) { return row_op<LogSoftmaxOp>(in_op, false); }
+    OpPtr logsumexp(OpPtr in_op) { return row_op<LogsumexpOp>(in_op, true); }
+
+    template <class O>
+    static OpPtr row_grad(OpPtr out_op, OpPtr grad_op) {
+        LazyPtr out_lazy = out_op->get_lazy();
+        LazyPtr grad_lazy = grad_op->get_lazy();
+        if (out_lazy->get_view() != grad_lazy->get_view()) {
+            throw IncompatShapesForOp(O::opname, vnumstr(out_lazy->get_view()), vnumstr(grad_lazy->get_view()));
+        }
+        if (!float_dtypes.contains(out_lazy->get_dtype()) || out_lazy->get_dtype() != grad_lazy->get_dtype()) {
+            throw IncompatDtypesForOp(O::opname, out_lazy->get_dtype()->str(), grad_lazy->get_dtype()->str());
+        }
+        // Gradients are often broadcasted from reductions
+        OpPtr contiguous_out = out_lazy->is_contiguous() ? out_op : copy(out_op);
+        OpPtr contiguous_grad = grad_lazy->is_contiguous() ? grad_op : copy(grad_op);
+        LazyPtr in_grad_lazy = Lazy::empty(Shape(out_lazy->get_view()), out_lazy->get_dtype(), out_lazy->get_device());
+        OpPtr in_grad_op = make_node<O>(in_grad_lazy, contiguous_out, contiguous_grad);
+        return in_grad_op;
+    }
+
+    OpPtr softmax_grad(OpPtr out_op, OpPtr grad_op) { return row_grad<SoftmaxGradOp>(out_op, grad_op); }
+    OpPtr log_softmax_grad(OpPtr out_op, OpPtr grad_op) { return row_grad<LogSoftmaxGradOp>(out_op, grad_op); }
+
+    // Labels hold one class index per row of logits so their shape is that of the logits without the last dimension
+    static void check_labels(const std::string &opname, LazyPtr logits_lazy, LazyPtr labels_lazy) {
+        const ShapeView &logits_view = logits_lazy->get_view();
+        ShapeView rows_view(logits_view.begin(), logits_view.end() - 1);
+        if (logits_view.empty() || labels_lazy->get_view() != rows_view) {
+            throw IncompatShapesForOp(opname, vnumstr(logits_view), vnumstr(labels_lazy->get_view()));
+        }
+        if (labels_lazy->get_dtype()->get_type() != DtypeType::INT) {
+            throw IncompatDtypeForOp(opname, labels_lazy->get_dtype()->str());
+        }
+        if (logits_lazy->get_device() != labels_lazy->get_device()) {
+            throw IncompatDevicesForOp(opname, logits_lazy->get_device()->str(), labels_lazy->get_device()->str());
+        }
+    }
+
+    // The kernels read i32 labels of contiguous arrays
+    static OpPtr contiguous_labels(OpPtr labels_op) {
+        labels_op = astype(labels_op, &i32);
+        return labels_op->get_lazy()->is_contiguous() ? labels_op : copy(labels_op);
+    }
+
+    // Activation gradients are computed in the dtype of the arrays they flow into
+    template <class O>
+    static OpPtr activation_grad(OpPtr in_op, OpPtr grad_op) {
+        LazyPtr in_lazy = in_op->get_lazy();
+        LazyPtr grad_lazy = grad_op->get_lazy();
+        if (in_lazy->get_view() != grad_lazy->get_view()) {
+            throw IncompatShapesForOp(O::opname, vnumstr(in_lazy->get_view()), vnumstr(grad_lazy->get_view()));
+        }
+        if (!float_dtypes.contains(in_lazy->get_dtype()) || in_lazy->get_dtype() != grad_lazy->get_dtype()) {
+            throw IncompatDtypesForOp(O::opname, in_lazy->get_dtype()->str(), grad_lazy->get_dtype()->str());
+        }
+        LazyPtr out_lazy = Lazy::empty(Shape(in_lazy->get_view()), in_lazy->get_dtype(), in_lazy->get_device());
+        OpPtr out_op = make_node<O>(out_lazy, in_op, grad_op);
+        return out_op;
+    }
+
+    OpPtr relu_grad(OpPtr out_op, OpPtr grad_op) { return activation_grad<ReluGradOp>(out_op, grad_op); }
+    OpPtr gelu_grad(OpPtr in_op, OpPtr grad_op) { return activation_grad<GeluGradOp>(in_op, grad_op); }
+    OpPtr silu_grad(OpPtr in_op, OpPtr grad_op) { return activation_grad<SiluGradOp>(in_op, grad_op); }
+
+    OpPtr cross_entropy(OpPtr logits_op, OpPtr labels_op) {
+        check_labels(CrossEntropyOp::opname, logits_op->get_lazy(), labels_op->get_lazy());
+        DtypePtr logits_dtype = logits_op->get_lazy()->get_dtype();
+        auto float_dtype = float_dtype_by_dtype.find(logits_dtype);
+        if (float_dtype == float_dtype_by_dtype.end()) {
+            throw IncompatDtypeForOp(CrossEntropyOp::opname, logits_dtype->str());
+        }
+        // Half logits are computed in f32 while autocasting like the other row ops
+        DtypePtr result_dtype = autocast_accum_dtype(float_dtype->second);
+        logits_op = astype(logits_op, result_dtype);
+        if (!logits_op->get_lazy()->is_contiguous()) {
+            logits_op = copy(logits_op);
+        }
+        labels_op = contiguous_labels(labels_op);
+        LazyPtr labels_lazy = labels_op->get_lazy();
+        LazyPtr out_lazy = Lazy::empty(Shape(labels_lazy->get_view()), result_dtype, labels_lazy->get_device());
+        OpPtr out_op = make_node<CrossEntropyOp>(out_lazy, logits_op, labels_op);
+        return out_op;
+    }
+
+    OpPtr cross_entropy_grad(OpPtr logits_op, OpPtr labels_op, OpPtr grad_op) {
+        LazyPtr logits_lazy = logits_op->get_lazy();
+        LazyPtr grad_lazy = grad_op->get_lazy();
+        check_labels(CrossEntropyGradOp::opname, logits_lazy, labels_op->get_lazy());
+        if (grad_lazy->get_view() != labels_op->get_lazy()->get_view()) {
+            throw IncompatShapesForOp(CrossEntropyGradOp::opname, vnumstr(labels_op->get_lazy()->get_view()), vnumstr(grad_lazy->get_view()));
+        }
+        if (!float_dtypes.contains(logits_lazy->get_dtype()) || logits_lazy->get_dtype() != grad_lazy->get_dtype()) {
+            throw IncompatDtypesForOp(CrossEntropyGradOp::opname, logits_lazy->get_dtype()->str(), grad_lazy->get_dtype()->str());
+        }
+        OpPtr contiguous_logits = logits_lazy->is_contiguous() ? logits_op : copy(logits_op);
+        // Row gradients are usually broadcasted from the mean of the losses
+        OpPtr contiguous_grad = grad_lazy->is_contiguous() ? grad_op : copy(grad_op);
+        LazyPtr in_grad_lazy = Lazy::empty(Shape(logits_lazy->get_view()), logits_lazy->get_dtype(), logits_lazy->get_device());
+        OpPtr in_grad_op = make_node<CrossEntropyGradOp>(in_grad_lazy, contiguous_logits, contiguous_labels(labels_op), contiguous_grad);
+        return in_grad_op;
+    }
+
     OpPtr sq(OpPtr in_op, bool in_place) { return unary<SqOp>(in_op, in_place); }
     OpPtr sqrt(OpPtr in_op, bool in_place) { return unary_float<SqrtOp>(in_op, in_place); }
     OpPtr neg(OpPtr in_op, bool in_place) { return unary<NegOp>(in_op, in_place); }
@@ -429,11 +1016,13 @@ namespace ax::graph {
     OpPtr copy(OpPtr in_op) {
         LazyPtr in_lazy = in_op->get_lazy();
         LazyPtr out_lazy = Lazy::empty(Shape(in_lazy->get_view()), in_lazy->get_dtype(), in_lazy->get_device());
-        OpPtr out_op = std::make_shared<CopyOp>(out_lazy, in_op);
+        OpPtr out_op = make_node<CopyOp>(out_lazy, in_op);
         return out_op;
     }
 
     OpPtr exp(OpPtr in_op, bool in_place) { return unary_float<ExpOp>(in_op, in_place); }
+    OpPtr gelu(OpPtr in_op, bool in_place) { return unary_float<GeluOp>(in_op, in_place); }
+    OpPtr silu(OpPtr in_op, bool in_place) { return unary_float<SiluOp>(in_op, in_place); }
     OpPtr log(OpPtr in_op, bool in_place) { return unary_float<LogOp>(in_op, in_place); }
     OpPtr recip(OpPtr in_op, bool in_place) { return unary_float<RecipOp>(in_op, in_place); }
 
@@ -443,14 +1032,14 @@ namespace ax::graph {
             return in_op;
         }
         LazyPtr out_lazy = Lazy::empty(in_lazy->get_shape().reshape(view), in_lazy->get_dtype(), in_lazy->get_device());
-        OpPtr out_op = std::make_shared<ReshapeOp>(out_lazy, in_op, view);
+        OpPtr out_op = make_node<ReshapeOp>(out_lazy, in_op, view);
         return out_op;
     }
 
     OpPtr permute(OpPtr in_op, const ShapeDims &dims) {
         LazyPtr in_lazy = in_op->get_lazy();
         LazyPtr out_lazy = Lazy::empty(in_lazy->get_shape().permute(dims), in_lazy->get_dtype(), in_lazy->get_device());
-        OpPtr out_op = std::make_shared<PermuteOp>(out_lazy, in_op, dims);
+        OpPtr out_op = make_node<PermuteOp>(out_lazy, in_op, dims);
         return out_op;
     }
 
@@ -466,7 +1055,7 @@ namespace ax::graph {
         return reshape(in_op, flattened_view);
     }
 
-    OpPtr sum(OpPtr in_op, const ShapeDims &dims) { return reduce<SumOp>(in_op, dims, in_op->get_lazy()->get_dtype(), numeric_dtypes); }
+    OpPtr sum(OpPtr in_op, const ShapeDims &dims) { return reduce<SumOp>(in_op, dims, autocast_accum_dtype(in_op->get_lazy()->get_dtype()), numeric_dtypes); }
 
     OpPtr mean(OpPtr in_op, const ShapeDims &dims) {
         OpPtr sum_op = sum(in_op, dims);
@@ -483,8 +1072,21 @@ namespace ax::graph {
         return div(sum_op, numel);
     }
 
-    OpPtr max(OpPtr in_op, const ShapeDims &dims) { return reduce<MaxOp>(in_op, dims, in_op->get_lazy()->get_dtype(), numeric_dtypes); }
-    OpPtr min(OpPtr in_op, const ShapeDims &dims) { return reduce<MinOp>(in_op, dims, in_op->get_lazy()->get_dtype(), numeric_dtypes); }
+    OpPtr max(OpPtr in_op, const ShapeDims &dims) { return reduce<MaxOp>(in_op, dims, autocast_accum_dtype(in_op->get_lazy()->get_dtype()), numeric_dtypes); }
+    OpPtr min(OpPtr in_op, const ShapeDims &dims) { return reduce<MinOp>(in_op, dims, autocast_accum_dtype(in_op->get_lazy()->get_dtype()), numeric_dtypes); }
     OpPtr argmax(OpPtr in_op, const ShapeDims &dims) { return reduce<ArgmaxOp>(in_op, dims, &i32, numeric_dtypes); }
     OpPtr argmin(OpPtr in_op, const ShapeDims &dims) { return reduce<ArgminOp>(in_op, dims, &i32, numeric_dtypes); }
+
+    OpPtr autocast(OpPtr op) {
+        DtypePtr dtype = AutocastMode::get_dtype();
+        if (dtype == nullptr || op->get_lazy()->get_dtype()->get_type() != DtypeType::FLOAT) {
+            return op;
+        }
+        return astype(op, dtype);
+    }
+
+    DtypePtr autocast_accum_dtype(DtypePtr dtype) {
+        // Reducing low precision arrays already accumulates in f32 so keeping the result in f32 costs no extra cast
+        return AutocastMode::is_enabled() && half_dtypes.contains(dtype) ? &f32 : dtype;
+    }
 } // namespace ax::graph
\ No newline at end of file
@@ -3,6 +3,9 @@
 #include "../core/lazy_iter.h"
 #include "../device/device.h"
 #include "../utils.h"
+#include "grad_mode.h"
+#include <atomic>
+#include <mutex>
 
 namespace ax::graph {
     using namespace ax::core;
@@ -26,6 +29,8 @@ namespace ax::graph {
         MINIMUM,
         MAXIMUM,
         MATMUL,
+        QUANTIZE,
+        QMATMUL,
         SQ,
         SQRT,
         NEG,
@@ -45,6 +50,28 @@ namespace ax::graph {
         ARGMAX,
         ARGMIN,
         ASTYPE,
+        MAXIMUM_GRAD,
+        MINIMUM_GRAD,
+        INDEX_GRAD,
+        PACK_MASK,
+        COUNT_MASK,
+        MASK_MUL,
+        SOFTMAX,
+        LOG_SOFTMAX,
+        LOGSUMEXP,
+        SOFTMAX_GRAD,
+        LOG_SOFTMAX_GRAD,
+        CROSS_ENTROPY,
+        CROSS_ENTROPY_GRAD,
+        LINEAR,
+        GELU,
+        SILU,
+        RELU_GRAD,
+        GELU_GRAD,
+        SILU_GRAD,
+        CONV2D,
+        CONV2D_INPUT_GRAD,
+        CONV2D_WEIGHT_GRAD,
         // Used to get the number of enums
         COUNT
     };
@@ -53,6 +80,7 @@ namespace ax::graph {
         INITIALIZER,
         UNARY,
         BINARY,
+        TERNARY,
         TRANSFORM,
         REDUCE
     };
@@ -60,7 +88,13 @@ namespace ax::graph {
     enum struct BinaryMode {
         ELMWISE,
         CMP,
-        MATMUL
+        MATMUL,
+        QUANTIZE,
+        INDEX,
+        MASK,
+        // Row-wise ops over the last dimension
+        ROW,
+        CONV
     };
 
     enum struct ReduceMode {
@@ -68,17 +102,70 @@ namespace ax::graph {
         ARG,
     };
 
+    // Activation applied by fused linear layers when writing out each element
+    enum struct Activation {
+        NONE,
+        RELU,
+        GELU,
+        SILU
+    };
+
+    inline const std::string &activation_str(Activation activation) {
+        static const std::vector<std::string> names = {"none", "relu", "gelu", "silu"};
+        return names[static_cast<isize>(activation)];
+    }
+
+    // Stride, padding and dilation of 2D convolutions as (height, width) pairs
+    struct Conv2dParams {
+        ShapeView stride = {1, 1};
+        ShapeView padding = {0, 0};
+        ShapeView dilation = {1, 1};
+        isize groups = 1;
+
+        const std::string str() const { return "stride: (" + vnumstr(stride) + "), padding: (" + vnumstr(padding) + "), dilation: (" + vnumstr(dilation) + "), groups: " + std::to_string(groups); }
+    };
+
     struct Op;
-    using OpPtr = std::shared_ptr<Op>;
+    using OpPtr = NodePtr<Op>;
+    class ComputeGraph;
     OpPtr detach(OpPtr op);
 
-    struct Op : public std::enable_shared_from_this<Op> {
+    struct Op : public Node {
     protected:
         LazyPtr lazy;
         bool idempotent = true;
+        // Ops created with gradient mode off are never tracked by autograd
+        bool tracked = GradMode::is_enabled();
+        // Ops created in inference mode may have their buffers recycled by later ops
+        bool inference = GradMode::is_inference();
         // Note: grad_enabled cannot be used to set gradient flow
         // once the computational graph is compiled
-        bool grad_enabled = true;
+        // Atomic since graphs built on several threads may enable gradients of the ops they share
+        std::atomic<bool> grad_enabled = tracked;
+        // Dead operand whose buffer is reused as the output buffer
+        LazyPtr buff_donor = nullptr;
+        // Arrays read by backward along with their versions when the op was created
+        std::vector<std::pair<LazyPtr, isize>> saved;
+        // Gradient buffer owned by a leaf and accumulated into by every graph it takes part in
+        LazyPtr persistent_grad = nullptr;
+        // Number of arrays handing the op out to users
+        std::atomic<isize> external_refs = 0;
+        // Set once another op reads or writes the op's memory outside of its graph
+        bool aliased = false;
+        // Graph built when the op was first evaluated, shared by every array handing the op out
+        std::weak_ptr<ComputeGraph> graph;
+        // Guards building the graph so that only arrays handing out the same op wait on each other
+        std::mutex graph_mutex;
+
+        void save_for_backward(LazyPtr saved_lazy) {
+            isize version = saved_lazy->get_version();
+            // In-place ops bump the version shared with their input when created
+            // but the input is read before being overwritten
+            if (is_in_place() && saved_lazy != lazy && saved_lazy->shares_version(lazy)) {
+                version--;
+            }
+            saved.emplace_back(saved_lazy, version);
+        }
 
     public:
         OpPtr grad = nullptr;
@@ -92,28 +179,58 @@ namespace ax::graph {
         virtual const std::string &get_opname() const = 0;
         virtual Optype get_optype() const = 0;
         LazyPtr get_lazy() const { return lazy; }
-        OpPtr de_op() const { return detach(std::const_pointer_cast<Op>(shared_from_this())); }
+        OpPtr de_op() const { return detach(OpPtr(const_cast<Op *>(this))); }
         bool is_grad_enabled() const { return grad_enabled; }
-        virtual void enable_grad(bool enabled) { grad_enabled = enabled; }
+        virtual void enable_grad(bool enabled) { grad_enabled = enabled && tracked; }
+        bool is_tracked() const { return tracked; }
+        bool is_inference() const { return inference; }
+        LazyPtr get_buff_donor() const { return buff_donor; }
+        void set_buff_donor(LazyPtr donor) { buff_donor = donor; }
+        void retain_external() { external_refs++; }
+        void release_external() { external_refs--; }
+        void set_aliased() { aliased = true; }
+        // Whether anything outside the graphs built on the op may still read its buffer
+        bool is_externally_referenced() const { return external_refs > 0 || aliased; }
+        std::shared_ptr<ComputeGraph> get_graph() const { return graph.lock(); }
+        void set_graph(std::shared_ptr<ComputeGraph> graph) { this->graph = graph; }
+        std::mutex &get_graph_mutex() { return graph_mutex; }
         bool is_idempotent() const { return idempotent; }
+        virtual bool is_in_place() const { return false; }
+        void check_saved_versions() const;
         virtual void backward() const {}
         void init_grad(bool with_zeros = true);
         void update_grad(OpPtr grad, bool sub = false);
+        void reset_grad() {
+            grad = nullptr;
+            grad_root = nullptr;
+        }
+        LazyPtr get_persistent_grad() const { return persistent_grad; }
+        void set_persistent_grad(LazyPtr grad_lazy) { persistent_grad = grad_lazy; }
         virtual const std::string str() const { return lazy->get_id().str() + ": opname: " + get_opname() + ", shape: " + lazy->get_shape().str() + ", dtype: " + lazy->get_dtype()->str(); }
     };
 
     struct InitializerOp : public Op {
     public:
-        InitializerOp(LazyPtr lazy) : Op(lazy) {}
+        InitializerOp(LazyPtr lazy) : Op(lazy) {
+            // Leaves can always be tracked since they do not record any history
+            tracked = true;
+            grad_enabled = true;
+        }
+
         Optype get_optype() const override { return Optype::INITIALIZER; }
     };
 
     struct Nop : public InitializerOp {
+    private:
+        // Array whose buffer a detached array shares once it is allocated
+        LazyPtr source = nullptr;
+
     public:
         static constexpr std::string opname = "nop";
-        Nop(LazyPtr lazy) : InitializerOp(lazy) {}
+        Nop(LazyPtr lazy, LazyPtr source = nullptr) : InitializerOp(lazy), source(source) {}
         Opcode get_opcode() const override { return Opcode::NOP; }
         const std::string &get_opname() const override { return opname; }
+        LazyPtr get_source() const { return source; }
     };
 
     struct ArangeOp : public InitializerOp {
@@ -164,12 +281,16 @@ namespace ax::graph {
         UnaryOp(LazyPtr lazy, OpPtr operand, bool in_place) : Op(lazy), operand(operand), in_place(in_place) {
             if (operand != nullptr) {
                 idempotent = !in_place && operand->is_idempotent();
+                if (in_place) {
+                    lazy->share_version(operand->get_lazy());
+                    lazy->bump_version();
+                }
             }
         }
         Optype get_optype() const override { return Optype::UNARY; }
         OpPtr get_operand() const { return operand; }
         OpPtr de_operand() const { return detach(operand); }
-        bool is_in_place() const { return in_place; }
+        bool is_in_place() const override { return in_place; }
         const std::string str() const override { return Op::str() + ", in-place: " + std::to_string(in_place) + ", operand: " + operand->get_lazy()->get_id().str(); }
     };
 
@@ -197,11 +318,15 @@ namespace ax::graph {
         ElmwiseBinaryOp(LazyPtr lazy, OpPtr lhs, OpPtr rhs, bool in_place) : BinaryOp(lazy, lhs, rhs), in_place(in_place) {
             if (lhs != nullptr && rhs != nullptr) {
                 idempotent = lhs->is_idempotent() && rhs->is_idempotent();
+                if (in_place) {
+                    lazy->share_version(lhs->get_lazy());
+                    lazy->bump_version();
+                }
             }
         }
 
         BinaryMode get_mode() const override { return BinaryMode::ELMWISE; }
-        bool is_in_place() const { return in_place; }
+        bool is_in_place() const override { return in_place; }
         const std::string str() const override { return Op::str() + ", in-place: " + std::to_string(in_place) + ", lhs: " + lhs->get_lazy()->get_id().str() + ", rhs: " + rhs->get_lazy()->get_id().str(); }
     };
 
@@ -212,14 +337,41 @@ namespace ax::graph {
         void enable_grad(bool enabled) override { grad_enabled = false; }
     };
 
+    struct TernaryOp : public Op {
+    protected:
+        OpPtr first;
+        OpPtr second;
+        OpPtr third;
+
+    public:
+        TernaryOp(LazyPtr lazy, OpPtr first, OpPtr second, OpPtr third) : Op(lazy), first(first), second(second), third(third) {
+            if (first != nullptr && second != nullptr && third != nullptr) {
+                idempotent = first->is_idempotent() && second->is_idempotent() && third->is_idempotent();
+            }
+        }
+
+        Optype get_optype() const override { return Optype::TERNARY; }
+        OpPtr get_first() const { return first; }
+        OpPtr get_second() const { return second; }
+        OpPtr get_third() const { return third; }
+        OpPtr de_first() const { return detach(first); }
+        OpPtr de_second() const { return detach(second); }
+        OpPtr de_third() const { return detach(third); }
+        const std::string str() const override { return Op::str() + ", first: " + first->get_lazy()->get_id().str() + ", second: " + second->get_lazy()->get_id().str() + ", third: " + third->get_lazy()->get_id().str(); }
+    };
+
     struct TransformOp : public Op {
     protected:
         OpPtr operand;
 
     public:
-        TransformOp(LazyPtr lazy, OpPtr operand) : Op(lazy), operand(operand) {
+        // Views alias the operand's buffer and therefore share its version
+        TransformOp(LazyPtr lazy, OpPtr operand, bool aliased = true) : Op(lazy), operand(operand) {
             if (operand != nullptr) {
                 idempotent = operand->is_idempotent();
+                if (aliased) {
+                    lazy->share_version(operand->get_lazy());
+                }
             }
         }
 
@@ -270,7 +422,10 @@ namespace ax::graph {
     struct MulOp : public ElmwiseBinaryOp {
     public:
         static constexpr std::string opname = "mul";
-        MulOp(LazyPtr lazy, OpPtr lhs, OpPtr rhs, bool in_place) : ElmwiseBinaryOp(lazy, lhs, rhs, in_place) {}
+        MulOp(LazyPtr lazy, OpPtr lhs, OpPtr rhs, bool in_place) : ElmwiseBinaryOp(lazy, lhs, rhs, in_place) {
+            save_for_backward(lhs->get_lazy());
+            save_for_backward(rhs->get_lazy());
+        }
         Opcode get_opcode() const override { return Opcode::MUL; }
         const std::string &get_opname() const override { return opname; }
         void backward() const override;
@@ -279,7 +434,10 @@ namespace ax::graph {
     struct DivOp : public ElmwiseBinaryOp {
     public:
         static constexpr std::string opname = "div";
-        DivOp(LazyPtr lazy, OpPtr lhs, OpPtr rhs, bool in_place) : ElmwiseBinaryOp(lazy, lhs, rhs, in_place) {}
+        DivOp(LazyPtr lazy, OpPtr lhs, OpPtr rhs, bool in_place) : ElmwiseBinaryOp(lazy, lhs, rhs, in_place) {
+            save_for_backward(rhs->get_lazy());
+            save_for_backward(lazy);
+        }
         Opcode get_opcode() const override { return Opcode::DIV; }
         const std::string &get_opname() const override { return opname; }
         void backward() const override;
@@ -336,7 +494,10 @@ namespace ax::graph {
     struct MinimumOp : public ElmwiseBinaryOp {
     public:
         static constexpr std::string opname = "minimum";
-        MinimumOp(LazyPtr lazy, OpPtr lhs, OpPtr rhs, bool in_place) : ElmwiseBinaryOp(lazy, lhs, rhs, in_place) {}
+        MinimumOp(LazyPtr lazy, OpPtr lhs, OpPtr rhs, bool in_place) : ElmwiseBinaryOp(lazy, lhs, rhs, in_place) {
+            save_for_backward(lhs->get_lazy());
+            save_for_backward(rhs->get_lazy());
+        }
         Opcode get_opcode() const override { return Opcode::MINIMUM; }
         const std::string &get_opname() const override { return opname; }
         void backward() const override;
@@ -345,7 +506,10 @@ namespace ax::graph {
     struct MaximumOp : public ElmwiseBinaryOp {
     public:
         static constexpr std::string opname = "maximum";
-        MaximumOp(LazyPtr lazy, OpPtr lhs, OpPtr rhs, bool in_place) : ElmwiseBinaryOp(lazy, lhs, rhs, in_place) {}
+        MaximumOp(LazyPtr lazy, OpPtr lhs, OpPtr rhs, bool in_place) : ElmwiseBinaryOp(lazy, lhs, rhs, in_place) {
+            save_for_backward(lhs->get_lazy());
+            save_for_backward(rhs->get_lazy());
+        }
         Opcode get_opcode() const override { return Opcode::MAXIMUM; }
         const std::string &get_opname() const override { return opname; }
         void backward() const override;
@@ -354,17 +518,265 @@ namespace ax::graph {
     struct MatmulOp : public BinaryOp {
     public:
         static constexpr std::string opname = "matmul";
-        MatmulOp(LazyPtr lazy, OpPtr lhs, OpPtr rhs) : BinaryOp(lazy, lhs, rhs) {}
+        MatmulOp(LazyPtr lazy, OpPtr lhs, OpPtr rhs) : BinaryOp(lazy, lhs, rhs) {
+            save_for_backward(lhs->get_lazy());
+            save_for_backward(rhs->get_lazy());
+        }
         Opcode get_opcode() const override { return Opcode::MATMUL; }
         BinaryMode get_mode() const override { return BinaryMode::MATMUL; }
         const std::string &get_opname() const override { return opname; }
         void backward() const override;
     };
 
+    // Symmetric quantization to i8: out = clamp(round(lhs / rhs), -127, 127)
+    // rhs holds the scales broadcasted to lhs, e.g. one scale per output channel of a weight
+    struct QuantizeOp : public BinaryOp {
+    public:
+        static constexpr std::string opname = "quantize";
+        QuantizeOp(LazyPtr lazy, OpPtr lhs, OpPtr rhs) : BinaryOp(lazy, lhs, rhs) { grad_enabled = false; }
+        Opcode get_opcode() const override { return Opcode::QUANTIZE; }
+        BinaryMode get_mode() const override { return BinaryMode::QUANTIZE; }
+        const std::string &get_opname() const override { return opname; }
+        void enable_grad(bool enabled) override { grad_enabled = false; }
+    };
+
+    // Multiplies i8 matrices with i32 accumulation and scales every dot product when writing it out
+    // first: (B, M, K) and second: (B, K, N) of i8, third: float scales broadcasted to (B, M, N)
+    // out[b, m, n] = third[b, m, n] * sum(first[b, m, k] * second[b, k, n])
+    struct QMatmulOp : public TernaryOp {
+    public:
+        static constexpr std::string opname = "qmatmul";
+        QMatmulOp(LazyPtr lazy, OpPtr first, OpPtr second, OpPtr third) : TernaryOp(lazy, first, second, third) { grad_enabled = false; }
+        Opcode get_opcode() const override { return Opcode::QMATMUL; }
+        const std::string &get_opname() const override { return opname; }
+        void enable_grad(bool enabled) override { grad_enabled = false; }
+    };
+
+    // Gradient of maximum w.r.t. the first operand: out = first >= second ? third : 0
+    // Swapping first and second gives the gradient w.r.t. the second operand
+    struct MaximumGradOp : public TernaryOp {
+    public:
+        static constexpr std::string opname = "maximum_grad";
+        MaximumGradOp(LazyPtr lazy, OpPtr first, OpPtr second, OpPtr third) : TernaryOp(lazy, first, second, third) {
+            save_for_backward(first->get_lazy());
+            save_for_backward(second->get_lazy());
+        }
+        Opcode get_opcode() const override { return Opcode::MAXIMUM_GRAD; }
+        const std::string &get_opname() const override { return opname; }
+        void backward() const override;
+    };
+
+    // Gradient of minimum w.r.t. the first operand: out = first <= second ? third : 0
+    struct MinimumGradOp : public TernaryOp {
+    public:
+        static constexpr std::string opname = "minimum_grad";
+        MinimumGradOp(LazyPtr lazy, OpPtr first, OpPtr second, OpPtr third) : TernaryOp(lazy, first, second, third) {
+            save_for_backward(first->get_lazy());
+            save_for_backward(second->get_lazy());
+        }
+        Opcode get_opcode() const override { return Opcode::MINIMUM_GRAD; }
+        const std::string &get_opname() const override { return opname; }
+        void backward() const override;
+    };
+
+    // Gradient of cross-entropy w.r.t. the logits in first given the labels in second and the row gradients in third
+    // out = third * (softmax(first) - onehot(second)) without materializing the one-hot rows
+    struct CrossEntropyGradOp : public TernaryOp {
+    public:
+        static constexpr std::string opname = "xentropy_grad";
+        CrossEntropyGradOp(LazyPtr lazy, OpPtr first, OpPtr second, OpPtr third) : TernaryOp(lazy, first, second, third) { grad_enabled = false; }
+        Opcode get_opcode() const override { return Opcode::CROSS_ENTROPY_GRAD; }
+        const std::string &get_opname() const override { return opname; }
+        void enable_grad(bool enabled) override { grad_enabled = false; }
+    };
+
+    // Linear layer with its bias and activation applied in the epilogue of the matmul
+    // first: (M, K), second: weight of shape (N, K) read without transposing it, third: bias of shape (N)
+    // out[m, n] = activation(sum(first[m, k] * second[n, k]) + third[n])
+    struct LinearOp : public TernaryOp {
+    private:
+        Activation activation;
+
+    public:
+        static constexpr std::string opname = "linear";
+        LinearOp(LazyPtr lazy, OpPtr first, OpPtr second, OpPtr third, Activation activation) : TernaryOp(lazy, first, second, third), activation(activation) {
+            save_for_backward(first->get_lazy());
+            save_for_backward(second->get_lazy());
+            if (activation == Activation::RELU) {
+                // The ReLU gradient only needs to know which outputs are positive
+                save_for_backward(lazy);
+            }
+        }
+        Opcode get_opcode() const override { return Opcode::LINEAR; }
+        const std::string &get_opname() const override { return opname; }
+        Activation get_activation() const { return activation; }
+        void enable_grad(bool enabled) override { grad_enabled = enabled && tracked; }
+        void backward() const override;
+        const std::string str() const override { return TernaryOp::str() + ", activation: " + activation_str(activation); }
+    };
+
+    // Scatters the gradient of a max/min reduction to the saved argmax/argmin indices
+    // lhs holds the indices and rhs the gradient, both with one element per reduced row
+    // out[i, j] = j == lhs[i] ? rhs[i] : 0
+    struct IndexGradOp : public BinaryOp {
+    public:
+        static constexpr std::string opname = "index_grad";
+        IndexGradOp(LazyPtr lazy, OpPtr lhs, OpPtr rhs) : BinaryOp(lazy, lhs, rhs) {
+            save_for_backward(lhs->get_lazy());
+        }
+        Opcode get_opcode() const override { return Opcode::INDEX_GRAD; }
+        BinaryMode get_mode() const override { return BinaryMode::INDEX; }
+        const std::string &get_opname() const override { return opname; }
+        void backward() const override;
+    };
+
+    // Packs a boolean mask into i32 words of 32 bits, which takes 8x less memory than b8
+    // Element i of the mask in row-major order goes to bit i % 32 of word i / 32 and bits past the last element are 0
+    struct PackMaskOp : public UnaryOp {
+    public:
+        static constexpr std::string opname = "pack_mask";
+        PackMaskOp(LazyPtr lazy, OpPtr operand) : UnaryOp(lazy, operand, false) { grad_enabled = false; }
+        Opcode get_opcode() const override { return Opcode::PACK_MASK; }
+        const std::string &get_opname() const override { return opname; }
+        void enable_grad(bool enabled) override { grad_enabled = false; }
+    };
+
+    // Number of set bits in a packed mask, counted by popcount on whole words
+    struct CountMaskOp : public UnaryOp {
+    public:
+        static constexpr std::string opname = "count_mask";
+        CountMaskOp(LazyPtr lazy, OpPtr operand) : UnaryOp(lazy, operand, false) { grad_enabled = false; }
+        Opcode get_opcode() const override { return Opcode::COUNT_MASK; }
+        const std::string &get_opname() const override { return opname; }
+        void enable_grad(bool enabled) override { grad_enabled = false; }
+    };
+
+    // Keeps lhs where the packed mask in rhs is set and zeroes it elsewhere
+    // out[i] = bit i of rhs ? lhs[i] : 0, with i the row-major index into lhs
+    struct MaskMulOp : public BinaryOp {
+    public:
+        static constexpr std::string opname = "mask_mul";
+        MaskMulOp(LazyPtr lazy, OpPtr lhs, OpPtr rhs) : BinaryOp(lazy, lhs, rhs) {
+            save_for_backward(rhs->get_lazy());
+        }
+        Opcode get_opcode() const override { return Opcode::MASK_MUL; }
+        BinaryMode get_mode() const override { return BinaryMode::MASK; }
+        const std::string &get_opname() const override { return opname; }
+        void backward() const override;
+    };
+
+    // Gradient of softmax from its output in lhs and the output gradient in rhs
+    // out = lhs * (rhs - sum(rhs * lhs)) with the sum taken over the last dimension
+    struct SoftmaxGradOp : public BinaryOp {
+    public:
+        static constexpr std::string opname = "softmax_grad";
+        SoftmaxGradOp(LazyPtr lazy, OpPtr lhs, OpPtr rhs) : BinaryOp(lazy, lhs, rhs) {}
+        Opcode get_opcode() const override { return Opcode::SOFTMAX_GRAD; }
+        BinaryMode get_mode() const override { return BinaryMode::ROW; }
+        const std::string &get_opname() const override { return opname; }
+    };
+
+    // Gradient of log-softmax from its output in lhs and the output gradient in rhs
+    // out = rhs - exp(lhs) * sum(rhs) with the sum taken over the last dimension
+    struct LogSoftmaxGradOp : public BinaryOp {
+    public:
+        static constexpr std::string opname = "logsoftmax_grad";
+        LogSoftmaxGradOp(LazyPtr lazy, OpPtr lhs, OpPtr rhs) : BinaryOp(lazy, lhs, rhs) {}
+        Opcode get_opcode() const override { return Opcode::LOG_SOFTMAX_GRAD; }
+        BinaryMode get_mode() const override { return BinaryMode::ROW; }
+        const std::string &get_opname() const override { return opname; }
+    };
+
+    // Convolutions of NCHW inputs with (C_out, C_in / groups, KH, KW) weights and their gradients
+    struct ConvOp : public BinaryOp {
+    protected:
+        Conv2dParams params;
+
+    public:
+        ConvOp(LazyPtr lazy, OpPtr lhs, OpPtr rhs, const Conv2dParams &params) : BinaryOp(lazy, lhs, rhs), params(params) {}
+        BinaryMode get_mode() const override { return BinaryMode::CONV; }
+        const Conv2dParams &get_params() const { return params; }
+        const std::string str() const override { return BinaryOp::str() + ", " + params.str(); }
+    };
+
+    // Cross-correlation of the input in lhs with the weight in rhs
+    struct Conv2dOp : public ConvOp {
+    public:
+        static constexpr std::string opname = "conv2d";
+        Conv2dOp(LazyPtr lazy, OpPtr lhs, OpPtr rhs, const Conv2dParams &params) : ConvOp(lazy, lhs, rhs, params) {
+            save_for_backward(lhs->get_lazy());
+            save_for_backward(rhs->get_lazy());
+        }
+        Opcode get_opcode() const override { return Opcode::CONV2D; }
+        const std::string &get_opname() const override { return opname; }
+        void backward() const override;
+    };
+
+    // Gradient w.r.t. the input from the output gradient in lhs and the weight in rhs
+    struct Conv2dInputGradOp : public ConvOp {
+    public:
+        static constexpr std::string opname = "conv2d_in_grad";
+        Conv2dInputGradOp(LazyPtr lazy, OpPtr lhs, OpPtr rhs, const Conv2dParams &params) : ConvOp(lazy, lhs, rhs, params) {}
+        Opcode get_opcode() const override { return Opcode::CONV2D_INPUT_GRAD; }
+        const std::string &get_opname() const override { return opname; }
+    };
+
+    // Gradient w.r.t. the weight from the input in lhs and the output gradient in rhs
+    struct Conv2dWeightGradOp : public ConvOp {
+    public:
+        static constexpr std::string opname = "conv2d_w_grad";
+        Conv2dWeightGradOp(LazyPtr lazy, OpPtr lhs, OpPtr rhs, const Conv2dParams &params) : ConvOp(lazy, lhs, rhs, params) {}
+        Opcode get_opcode() const override { return Opcode::CONV2D_WEIGHT_GRAD; }
+        const std::string &get_opname() const override { return opname; }
+    };
+
+    // Gradients of activations from their saved operand in lhs and the output gradient in rhs
+    // ReLU reads its output instead since it is positive exactly where the operand is
+    struct ReluGradOp : public ElmwiseBinaryOp {
+    public:
+        static constexpr std::string opname = "relu_grad";
+        ReluGradOp(LazyPtr lazy, OpPtr lhs, OpPtr rhs) : ElmwiseBinaryOp(lazy, lhs, rhs, false) {}
+        Opcode get_opcode() const override { return Opcode::RELU_GRAD; }
+        const std::string &get_opname() const override { return opname; }
+    };
+
+    struct GeluGradOp : public ElmwiseBinaryOp {
+    public:
+        static constexpr std::string opname = "gelu_grad";
+        GeluGradOp(LazyPtr lazy, OpPtr lhs, OpPtr rhs) : ElmwiseBinaryOp(lazy, lhs, rhs, false) {}
+        Opcode get_opcode() const override { return Opcode::GELU_GRAD; }
+        const std::string &get_opname() const override { return opname; }
+    };
+
+    struct SiluGradOp : public ElmwiseBinaryOp {
+    public:
+        static constexpr std::string opname = "silu_grad";
+        SiluGradOp(LazyPtr lazy, OpPtr lhs, OpPtr rhs) : ElmwiseBinaryOp(lazy, lhs, rhs, false) {}
+        Opcode get_opcode() const override { return Opcode::SILU_GRAD; }
+        const std::string &get_opname() const override { return opname; }
+    };
+
+    // Cross-entropy of each row of logits in lhs against its i32 class label in rhs
+    // out = logsumexp(lhs) - lhs[rhs] with the target logit gathered in the same pass over the row
+    struct CrossEntropyOp : public BinaryOp {
+    public:
+        static constexpr std::string opname = "xentropy";
+        CrossEntropyOp(LazyPtr lazy, OpPtr lhs, OpPtr rhs) : BinaryOp(lazy, lhs, rhs) {
+            save_for_backward(lhs->get_lazy());
+            save_for_backward(rhs->get_lazy());
+        }
+        Opcode get_opcode() const override { return Opcode::CROSS_ENTROPY; }
+        BinaryMode get_mode() const override { return BinaryMode::ROW; }
+        const std::string &get_opname() const override { return opname; }
+        void backward() const override;
+    };
+
     struct SqOp : public UnaryOp {
     public:
         static constexpr std::string opname = "sq";
-        SqOp(LazyPtr lazy, OpPtr operand, bool in_place) : UnaryOp(lazy, operand, in_place) {}
+        SqOp(LazyPtr lazy, OpPtr operand, bool in_place) : UnaryOp(lazy, operand, in_place) {
+            save_for_backward(operand->get_lazy());
+        }
         Opcode get_opcode() const override { return Opcode::SQ; }
         const std::string &get_opname() const override { return opname; }
         void backward() const override;
@@ -373,7 +785,9 @@ namespace ax::graph {
     struct SqrtOp : public UnaryOp {
     public:
         static constexpr std::string opname = "sqrt";
-        SqrtOp(LazyPtr lazy, OpPtr operand, bool in_place) : UnaryOp(lazy, operand, in_place) {}
+        SqrtOp(LazyPtr lazy, OpPtr operand, bool in_place) : UnaryOp(lazy, operand, in_place) {
+            save_for_backward(lazy);
+        }
         Opcode get_opcode() const override { return Opcode::SQRT; }
         const std::string &get_opname() const override { return opname; }
         void backward() const override;
@@ -400,16 +814,43 @@ namespace ax::graph {
     struct ExpOp : public UnaryOp {
     public:
         static constexpr std::string opname = "exp";
-        ExpOp(LazyPtr lazy, OpPtr operand, bool in_place) : UnaryOp(lazy, operand, in_place) {}
+        ExpOp(LazyPtr lazy, OpPtr operand, bool in_place) : UnaryOp(lazy, operand, in_place) {
+            save_for_backward(lazy);
+        }
         Opcode get_opcode() const override { return Opcode::EXP; }
         const std::string &get_opname() const override { return opname; }
         void backward() const override;
     };
 
+    // GELU with the tanh approximation since Metal has no erf
+    struct GeluOp : public UnaryOp {
+    public:
+        static constexpr std::string opname = "gelu";
+        GeluOp(LazyPtr lazy, OpPtr operand, bool in_place) : UnaryOp(lazy, operand, in_place) {
+            save_for_backward(operand->get_lazy());
+        }
+        Opcode get_opcode() const override { return Opcode::GELU; }
+        const std::string &get_opname() const override { return opname; }
+        void backward() const override;
+    };
+
+    struct SiluOp : public UnaryOp {
+    public:
+        static constexpr std::string opname = "silu";
+        SiluOp(LazyPtr lazy, OpPtr operand, bool in_place) : UnaryOp(lazy, operand, in_place) {
+            save_for_backward(operand->get_lazy());
+        }
+        Opcode get_opcode() const override { return Opcode::SILU; }
+        const std::string &get_opname() const override { return opname; }
+        void backward() const override;
+    };
+
     struct LogOp : public UnaryOp {
     public:
         static constexpr std::string opname = "log";
-        LogOp(LazyPtr lazy, OpPtr operand, bool in_place) : UnaryOp(lazy, operand, in_place) {}
+        LogOp(LazyPtr lazy, OpPtr operand, bool in_place) : UnaryOp(lazy, operand, in_place) {
+            save_for_backward(operand->get_lazy());
+        }
         Opcode get_opcode() const override { return Opcode::LOG; }
         const std::string &get_opname() const override { return opname; }
         void backward() const override;
@@ -418,19 +859,57 @@ namespace ax::graph {
     struct RecipOp : public UnaryOp {
     public:
         static constexpr std::string opname = "recip";
-        RecipOp(LazyPtr lazy, OpPtr operand, bool in_place) : UnaryOp(lazy, operand, in_place) {}
+        RecipOp(LazyPtr lazy, OpPtr operand, bool in_place) : UnaryOp(lazy, operand, in_place) {
+            save_for_backward(lazy);
+        }
         Opcode get_opcode() const override { return Opcode::RECIP; }
         const std::string &get_opname() const override { return opname; }
         void backward() const override;
     };
 
+    // Softmax, log-softmax and logsumexp run over the last dimension with one threadgroup per row
+    // Each row is scanned once for a running max along with the sum of exponentials rescaled to it
+    struct SoftmaxOp : public UnaryOp {
+    public:
+        static constexpr std::string opname = "softmax";
+        SoftmaxOp(LazyPtr lazy, OpPtr operand) : UnaryOp(lazy, operand, false) {
+            save_for_backward(lazy);
+        }
+        Opcode get_opcode() const override { return Opcode::SOFTMAX; }
+        const std::string &get_opname() const override { return opname; }
+        void backward() const override;
+    };
+
+    struct LogSoftmaxOp : public UnaryOp {
+    public:
+        static constexpr std::string opname = "log_softmax";
+        LogSoftmaxOp(LazyPtr lazy, OpPtr operand) : UnaryOp(lazy, operand, false) {
+            save_for_backward(lazy);
+        }
+        Opcode get_opcode() const override { return Opcode::LOG_SOFTMAX; }
+        const std::string &get_opname() const override { return opname; }
+        void backward() const override;
+    };
+
+    // Reduces the last dimension to a single element holding log(sum(exp(x)))
+    struct LogsumexpOp : public UnaryOp {
+    public:
+        static constexpr std::string opname = "logsumexp";
+        LogsumexpOp(LazyPtr lazy, OpPtr operand) : UnaryOp(lazy, operand, false) {
+            save_for_backward(operand->get_lazy());
+        }
+        Opcode get_opcode() const override { return Opcode::LOGSUMEXP; }
+        const std::string &get_opname() const override { return opname; }
+        void backward() const override;
+    };
+
     struct ReshapeOp : public TransformOp {
     private:
         ShapeView view;
 
     public:
         static constexpr std::string opname = "reshape";
-        ReshapeOp(LazyPtr lazy, OpPtr operand, const ShapeView &view) : TransformOp(lazy, operand), view(view) {}
+        ReshapeOp(LazyPtr lazy, OpPtr operand, const ShapeView &view) : TransformOp(lazy, operand, operand != nullptr && !operand->get_lazy()->copy_when_reshape(view)), view(view) {}
         const ShapeView &get_view() const { return view; }
         Opcode get_opcode() const override { return Opcode::RESHAPE; }
         const std::string &get_opname() const override { return opname; }
@@ -520,12 +999,15 @@ namespace ax::graph {
 
     public:
         static constexpr std::string opname = "astype";
-        AstypeOp(LazyPtr lazy, OpPtr operand, DtypePtr dtype) : TransformOp(lazy, operand), dtype(dtype) { grad_enabled = false; }
-        void enable_grad(bool enabled) override { grad_enabled = false; }
+        // Only casts between floating-point types carry gradients, e.g. autocasts of f32 weights
+        AstypeOp(LazyPtr lazy, OpPtr operand, DtypePtr dtype) : TransformOp(lazy, operand, false), dtype(dtype) { grad_enabled = grad_enabled && is_float_cast(); }
+        void enable_grad(bool enabled) override { grad_enabled = enabled && tracked && is_float_cast(); }
+        bool is_float_cast() const { return operand != nullptr && operand->get_lazy()->get_dtype()->get_type() == DtypeType::FLOAT && dtype->get_type() == DtypeType::FLOAT; }
         DtypePtr get_dtype() const { return dtype; }
         Opcode get_opcode() const override { return Opcode::ASTYPE; }
         const std::string &get_opname() const override { return opname; }
         const std::string str() const override { return TransformOp::str() + ", dtype: " + dtype->str(); }
+        void backward() const override;
     };
 
     struct SumOp : public ReduceOp {
@@ -538,24 +1020,40 @@ namespace ax::graph {
         void backward() const override;
     };
 
-    struct MaxOp : public ReduceOp {
+    // Tracked floating-point max and min also record the index of each extremum in the same kernel
+    // so that backward scatters gradients without reading the operand again
+    struct ExtremumOp : public ReduceOp {
+    protected:
+        LazyPtr index = nullptr;
+
+    public:
+        ExtremumOp(LazyPtr lazy, OpPtr operand, const ShapeDims &dims) : ReduceOp(lazy, operand, dims) {
+            if (tracked && lazy->get_dtype()->get_type() == DtypeType::FLOAT) {
+                index = Lazy::empty(Shape(lazy->get_view()), &i32, lazy->get_device());
+            }
+        }
+
+        LazyPtr get_index() const { return index; }
+        void set_index(LazyPtr index) { this->index = index; }
+        void backward() const override;
+    };
+
+    struct MaxOp : public ExtremumOp {
     public:
         static constexpr std::string opname = "max";
-        MaxOp(LazyPtr lazy, OpPtr operand, const ShapeDims &dims) : ReduceOp(lazy, operand, dims) {}
+        MaxOp(LazyPtr lazy, OpPtr operand, const ShapeDims &dims) : ExtremumOp(lazy, operand, dims) {}
         Opcode get_opcode() const override { return Opcode::MAX; }
         const std::string &get_opname() const override { return opname; }
         ReduceMode get_mode() const override { return ReduceMode::VALUE; }
-        void backward() const override;
     };
 
-    struct MinOp : public ReduceOp {
+    struct MinOp : public ExtremumOp {
     public:
         static constexpr std::string opname = "min";
-        MinOp(LazyPtr lazy, OpPtr operand, const ShapeDims &dims) : ReduceOp(lazy, operand, dims) {}
+        MinOp(LazyPtr lazy, OpPtr operand, const ShapeDims &dims) : ExtremumOp(lazy, operand, dims) {}
         Opcode get_opcode() const override { return Opcode::MIN; }
         const std::string &get_opname() const override { return opname; }
         ReduceMode get_mode() const override { return ReduceMode::VALUE; }
-        void backward() const override;
     };
 
     struct ArgmaxOp : public ReduceOp {
@@ -600,6 +1098,9 @@ namespace ax::graph {
     OpPtr mul(OpPtr lop, OpPtr rop);
     OpPtr div(OpPtr lop, OpPtr rop);
     OpPtr matmul(OpPtr lop, OpPtr rop);
+    OpPtr quantize(OpPtr in_op, OpPtr scale_op);
+    OpPtr dequantize(OpPtr in_op, OpPtr scale_op);
+    OpPtr qmatmul(OpPtr lop, OpPtr rop, OpPtr scale_op);
     OpPtr inplace_add(OpPtr lop, OpPtr rop);
     OpPtr inplace_sub(OpPtr lop, OpPtr rop);
     OpPtr inplace_mul(OpPtr lop, OpPtr rop);
@@ -612,11 +1113,36 @@ namespace ax::graph {
     OpPtr geq(OpPtr lop, OpPtr rop);
     OpPtr minimum(OpPtr lop, OpPtr rop);
     OpPtr maximum(OpPtr lop, OpPtr rop);
+    OpPtr maximum_grad(OpPtr lop, OpPtr rop, OpPtr grad_op);
+    OpPtr minimum_grad(OpPtr lop, OpPtr rop, OpPtr grad_op);
+    OpPtr index_grad(OpPtr idx_op, OpPtr grad_op, const ShapeView &view);
+    OpPtr pack_mask(OpPtr in_op);
+    OpPtr count_mask(OpPtr mask_op);
+    OpPtr mask_mul(OpPtr lop, OpPtr mask_op);
+    OpPtr count_nonzero(OpPtr in_op);
+    OpPtr any(OpPtr in_op);
+    OpPtr all(OpPtr in_op);
+    OpPtr softmax(OpPtr in_op);
+    OpPtr log_softmax(OpPtr in_op);
+    OpPtr logsumexp(OpPtr in_op);
+    OpPtr softmax_grad(OpPtr out_op, OpPtr grad_op);
+    OpPtr log_softmax_grad(OpPtr out_op, OpPtr grad_op);
+    OpPtr cross_entropy(OpPtr logits_op, OpPtr labels_op);
+    OpPtr cross_entropy_grad(OpPtr logits_op, OpPtr labels_op, OpPtr grad_op);
+    OpPtr linear(OpPtr in_op, OpPtr weight_op, OpPtr bias_op, Activation activation);
+    OpPtr relu_grad(OpPtr out_op, OpPtr grad_op);
+    OpPtr gelu_grad(OpPtr in_op, OpPtr grad_op);
+    OpPtr silu_grad(OpPtr in_op, OpPtr grad_op);
+    OpPtr conv2d(OpPtr in_op, OpPtr weight_op, const Conv2dParams &params);
+    OpPtr conv2d_input_grad(OpPtr grad_op, OpPtr weight_op, const ShapeView &in_view, const Conv2dParams &params);
+    OpPtr conv2d_weight_grad(OpPtr in_op, OpPtr grad_op, const ShapeView &weight_view, const Conv2dParams &params);
     OpPtr sq(OpPtr in_op, bool in_place = false);
     OpPtr sqrt(OpPtr in_op, bool in_place = false);
     OpPtr neg(OpPtr in_op, bool in_place = false);
     OpPtr copy(OpPtr in_op);
     OpPtr exp(OpPtr in_op, bool in_place = false);
+    OpPtr gelu(OpPtr in_op, bool in_place = false);
+    OpPtr silu(OpPtr in_op, bool in_place = false);
     OpPtr log(OpPtr in_op, bool in_place = false);
     OpPtr recip(OpPtr in_op, bool in_place = false);
     OpPtr reshape(OpPtr in_op, const ShapeView &view);
@@ -629,6 +1155,8 @@ namespace ax::graph {
     OpPtr min(OpPtr in_op, const ShapeDims &dims = {});
     OpPtr argmax(OpPtr in_op, const ShapeDims &dims = {});
     OpPtr argmin(OpPtr in_op, const ShapeDims &dims = {});
+    OpPtr autocast(OpPtr op);
+    DtypePtr autocast_accum_dtype(DtypePtr dtype);
 
     template <typename T>
     concept Numeric = std::is_arithmetic_v<T>;
@@ -641,7 +1169,7 @@ namespace ax::graph {
     template <Numeric T>
     OpPtr full(const ShapeView &view, T c, DtypePtr dtype, DevicePtr device) {
         LazyPtr lazy = Lazy::empty(Shape(view), dtype, device);
-        OpPtr op = std::make_shared<FullOp>(lazy, view, dtype_cast_down(c, dtype), dtype);
+        OpPtr op = make_node<FullOp>(lazy, view, dtype_cast_down(c, dtype), dtype);
         return op;
     }
 
@@ -730,17 +1258,19 @@ namespace ax::graph {
         if (!llazy->get_shape().broadcastable(rview)) {
             throw IncompatShapesForOp(O::opname, vnumstr(lview), vnumstr(rview));
         }
-        if (!binary_dtypes.contains(ldtype) || ldtype != rdtype) {
+        if (!binary_dtypes.contains(ldtype) || !binary_dtypes.contains(rdtype)) {
             throw IncompatDtypesForOp(O::opname, ldtype->str(), rdtype->str());
         }
         if (ldevice != rdevice) {
             throw IncompatDevicesForOp(O::opname, ldevice->str(), rdevice->str());
         }
 
+        // Mixed operands are converted by the kernel instead of being cast beforehand
+        // Half outputs of autocast ops therefore combine with f32 arrays in f32 rather than dragging them down
         OpPtr broadcasted_lop = broadcast(lop, rview);
         OpPtr broadcasted_rop = broadcast(rop, lview);
-        LazyPtr out_lazy = Lazy::empty(Shape(broadcasted_lop->get_lazy()->get_view()), ldtype, ldevice);
-        OpPtr out_op = std::make_shared<O>(out_lazy, broadcasted_lop, broadcasted_rop, false);
+        LazyPtr out_lazy = Lazy::empty(Shape(broadcasted_lop->get_lazy()->get_view()), promote_dtypes(ldtype, rdtype), ldevice);
+        OpPtr out_op = make_node<O>(out_lazy, broadcasted_lop, broadcasted_rop, false);
         return out_op;
     }
 
@@ -759,7 +1289,8 @@ namespace ax::graph {
         if (!llazy->get_shape().broadcastable(rview)) {
             throw IncompatShapesForOp(O::opname, vnumstr(lview), vnumstr(rview));
         }
-        if (!binary_dtypes.contains(ldtype) || ldtype != rdtype) {
+        // The output keeps the lhs dtype so rhs must not need a wider one
+        if (!binary_dtypes.contains(ldtype) || !binary_dtypes.contains(rdtype) || promote_dtypes(ldtype, rdtype) != ldtype) {
             throw IncompatDtypesForOp(O::opname, ldtype->str(), rdtype->str());
         }
         if (ldevice != rdevice) {
@@ -768,7 +1299,7 @@ namespace ax::graph {
 
         OpPtr broadcasted_rop = broadcast_to(rop, lview);
         LazyPtr out_lazy = Lazy::empty(lshape, ldtype, ldevice);
-        OpPtr out_op = std::make_shared<O>(out_lazy, lop, broadcasted_rop, true);
+        OpPtr out_op = make_node<O>(out_lazy, lop, broadcasted_rop, true);
         return out_op;
     }
 
@@ -782,12 +1313,15 @@ namespace ax::graph {
         }
 
         LazyPtr out_lazy = Lazy::empty(Shape(in_lazy->get_view()), in_dtype, in_lazy->get_device());
-        OpPtr out_op = std::make_shared<O>(out_lazy, in_op, in_place);
+        OpPtr out_op = make_node<O>(out_lazy, in_op, in_place);
         return out_op;
     }
 
     template <class O>
     OpPtr unary_float(OpPtr in_op, bool in_place) {
+        if (!in_place) {
+            in_op = astype(in_op, autocast_accum_dtype(in_op->get_lazy()->get_dtype()));
+        }
         LazyPtr in_lazy = in_op->get_lazy();
         DtypePtr in_dtype = in_lazy->get_dtype();
 
@@ -805,7 +1339,7 @@ namespace ax::graph {
         }
 
         LazyPtr out_lazy = Lazy::empty(Shape(in_lazy->get_view()), result_dtype->second, in_lazy->get_device());
-        OpPtr out_op = std::make_shared<O>(out_lazy, in_op, in_place);
+        OpPtr out_op = make_node<O>(out_lazy, in_op, in_place);
         return out_op;
     }
 
@@ -823,7 +1357,9 @@ namespace ax::graph {
         if (!llazy->get_shape().broadcastable(rview)) {
             throw IncompatShapesForOp(O::opname, vnumstr(lview), vnumstr(rview));
         }
-        if (!valid_dtypes.contains(ldtype) || ldtype != rdtype) {
+        // Only numeric operands can be compared across dtypes
+        bool promotable = ldtype == rdtype || (binary_dtypes.contains(ldtype) && binary_dtypes.contains(rdtype));
+        if (!valid_dtypes.contains(ldtype) || !valid_dtypes.contains(rdtype) || !promotable) {
             throw IncompatDtypesForOp(O::opname, ldtype->str(), rdtype->str());
         }
         if (ldevice != rdevice) {
@@ -833,7 +1369,36 @@ namespace ax::graph {
         OpPtr broadcasted_lop = broadcast(lop, rview);
         OpPtr broadcasted_rop = broadcast(rop, lview);
         LazyPtr out_lazy = Lazy::empty(Shape(broadcasted_lop->get_lazy()->get_view()), &b8, ldevice);
-        OpPtr out_op = std::make_shared<O>(out_lazy, broadcasted_lop, broadcasted_rop);
+        OpPtr out_op = make_node<O>(out_lazy, broadcasted_lop, broadcasted_rop);
+        return out_op;
+    }
+
+    template <class O>
+    OpPtr elmwise_ternary(OpPtr first_op, OpPtr second_op, OpPtr third_op) {
+        LazyPtr first_lazy = first_op->get_lazy();
+        LazyPtr second_lazy = second_op->get_lazy();
+        LazyPtr third_lazy = third_op->get_lazy();
+        const ShapeView &first_view = first_lazy->get_view();
+        DtypePtr first_dtype = first_lazy->get_dtype();
+        DevicePtr first_device = first_lazy->get_device();
+
+        for (auto &lazy : {second_lazy, third_lazy}) {
+            if (lazy->get_view() != first_view) {
+                throw IncompatShapesForOp(O::opname, vnumstr(first_view), vnumstr(lazy->get_view()));
+            }
+            if (lazy->get_device() != first_device) {
+                throw IncompatDevicesForOp(O::opname, first_device->str(), lazy->get_device()->str());
+            }
+        }
+        if (!binary_dtypes.contains(first_dtype) || second_lazy->get_dtype() != first_dtype) {
+            throw IncompatDtypesForOp(O::opname, first_dtype->str(), second_lazy->get_dtype()->str());
+        }
+        if (third_lazy->get_dtype() != first_dtype) {
+            throw IncompatDtypesForOp(O::opname, first_dtype->str(), third_lazy->get_dtype()->str());
+        }
+
+        LazyPtr out_lazy = Lazy::empty(Shape(first_view), first_dtype, first_device);
+        OpPtr out_op = make_node<O>(out_lazy, first_op, second_op, third_op);
         return out_op;
     }
 
@@ -854,7 +1419,7 @@ namespace ax::graph {
         if (dims.size() == 0) {
             // Reduce to one element
             reduction_arr = Lazy::empty(Shape({1}), result_dtype, in_device);
-            reduction_op = std::make_shared<O>(reduction_arr, in_op, dims);
+            reduction_op = make_node<O>(reduction_arr, in_op, dims);
             return reduction_op;
         }
 
@@ -896,7 +1461,7 @@ namespace ax::graph {
         OpPtr reshape_op_before_reduction = reshape(permutation_op, {kept_numel, reduction_numel});
         // Reduce the array
         reduction_arr = Lazy::empty(Shape({kept_numel, 1}), result_dtype, in_device);
-        reduction_op = std::make_shared<O>(reduction_arr, reshape_op_before_reduction, dims);
+        reduction_op = make_node<O>(reduction_arr, reshape_op_before_reduction, dims);
         // Reshape the array back to the shape without reduced dimensions(except for 1 at the end)
         kept_view.emplace_back(1);
         OpPtr reshape_op_after_reduction = reshape(reduction_op, kept_view);
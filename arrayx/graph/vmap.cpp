@@ -0,0 +1,318 @@
+#include "vmap.h"
+
+namespace ax::graph {
+    void BatchRewriter::bind(OpPtr placeholder, OpPtr batched_input) {
+        ShapeView batched_view = {batch_size};
+        const ShapeView &view = placeholder->get_lazy()->get_view();
+        batched_view.insert(batched_view.end(), view.begin(), view.end());
+        if (batched_input->get_lazy()->get_view() != batched_view) {
+            throw IncompatShapesForOp("vmap", vnumstr(batched_input->get_lazy()->get_view()), vnumstr(batched_view));
+        }
+        batched[placeholder->get_lazy()->get_id()] = batched_input;
+    }
+
+    OpPtr BatchRewriter::operator()(OpPtr out_op) {
+        OpPtr batched_out = rewrite(out_op);
+        if (batched_out != nullptr) {
+            return batched_out;
+        }
+        // The output does not depend on the batch so every example gets the same value
+        ShapeView batched_view = {batch_size};
+        const ShapeView &view = out_op->get_lazy()->get_view();
+        batched_view.insert(batched_view.end(), view.begin(), view.end());
+        return broadcast_to(unsqueeze(out_op, {0}), batched_view);
+    }
+
+    OpPtr BatchRewriter::rewrite(OpPtr op) {
+        const Id &id = op->get_lazy()->get_id();
+        if (batched.contains(id)) {
+            return batched[id];
+        }
+
+        OpPtr batched_op = nullptr;
+        switch (op->get_optype()) {
+        case Optype::INITIALIZER: {
+            // Constants and captured arrays are shared by all examples
+            break;
+        }
+        case Optype::UNARY: {
+            OpPtr operand = rewrite(static_pointer_cast<UnaryOp>(op)->get_operand());
+            if (operand != nullptr) {
+                batched_op = rewrite_unary(op, operand);
+            }
+            break;
+        }
+        case Optype::BINARY: {
+            NodePtr<BinaryOp> binary_op = static_pointer_cast<BinaryOp>(op);
+            OpPtr lhs = rewrite(binary_op->get_lhs());
+            OpPtr rhs = rewrite(binary_op->get_rhs());
+            if (lhs != nullptr || rhs != nullptr) {
+                batched_op = rewrite_binary(op, lhs, rhs);
+            }
+            break;
+        }
+        case Optype::TERNARY: {
+            // Ternary ops are either gradient ops or quantized matmuls, which are not batched
+            // except for linear layers applying shared parameters to a batch of inputs
+            NodePtr<TernaryOp> ternary_op = static_pointer_cast<TernaryOp>(op);
+            OpPtr first = rewrite(ternary_op->get_first());
+            if (rewrite(ternary_op->get_second()) != nullptr || rewrite(ternary_op->get_third()) != nullptr) {
+                throw UnbatchableOp(op->get_opname());
+            }
+            if (first != nullptr) {
+                if (op->get_opcode() != Opcode::LINEAR) {
+                    throw UnbatchableOp(op->get_opname());
+                }
+                NodePtr<LinearOp> linear_op = static_pointer_cast<LinearOp>(op);
+                batched_op = linear(first, linear_op->get_second(), linear_op->get_third(), linear_op->get_activation());
+            }
+            break;
+        }
+        case Optype::TRANSFORM: {
+            OpPtr operand = rewrite(static_pointer_cast<TransformOp>(op)->get_operand());
+            if (operand != nullptr) {
+                batched_op = rewrite_transform(op, operand);
+            }
+            break;
+        }
+        default: {
+            OpPtr operand = rewrite(static_pointer_cast<ReduceOp>(op)->get_operand());
+            if (operand != nullptr) {
+                batched_op = rewrite_reduce(op, operand);
+            }
+            break;
+        }
+        }
+
+        batched[id] = batched_op;
+        return batched_op;
+    }
+
+    OpPtr BatchRewriter::align(OpPtr op, OpPtr batched_op, isize ndim) {
+        // Unbatched operands are broadcast from the right like any other operand
+        if (batched_op == nullptr) {
+            return op;
+        }
+        isize op_ndim = op->get_lazy()->get_ndim();
+        if (op_ndim >= ndim) {
+            return batched_op;
+        }
+        // Insert singleton dimensions after the batch dimension so that the batch stays first
+        ShapeDims dims(ndim - op_ndim);
+        std::iota(dims.begin(), dims.end(), 1);
+        return unsqueeze(batched_op, dims);
+    }
+
+    OpPtr BatchRewriter::rewrite_unary(OpPtr op, OpPtr operand) {
+        bool in_place = op->is_in_place();
+        switch (op->get_opcode()) {
+        case Opcode::SQ:
+            return sq(operand, in_place);
+        case Opcode::SQRT:
+            return sqrt(operand, in_place);
+        case Opcode::NEG:
+            return neg(operand, in_place);
+        case Opcode::COPY:
+            return copy(operand);
+        case Opcode::EXP:
+            return exp(operand, in_place);
+        case Opcode::LOG:
+            return log(operand, in_place);
+        case Opcode::RECIP:
+            return recip(operand, in_place);
+        case Opcode::SOFTMAX:
+            return softmax(operand);
+        case Opcode::LOG_SOFTMAX:
+            return log_softmax(operand);
+        case Opcode::GELU:
+            return gelu(operand, in_place);
+        case Opcode::SILU:
+            return silu(operand, in_place);
+        case Opcode::LOGSUMEXP:
+            return logsumexp(operand);
+        default:
+            throw UnbatchableOp(op->get_opname());
+        }
+    }
+
+    OpPtr BatchRewriter::rewrite_binary(OpPtr op, OpPtr lhs, OpPtr rhs) {
+        NodePtr<BinaryOp> binary_op = static_pointer_cast<BinaryOp>(op);
+        OpPtr lop = binary_op->get_lhs();
+        OpPtr rop = binary_op->get_rhs();
+
+        switch (binary_op->get_mode()) {
+        case BinaryMode::MATMUL:
+            // Per-example operands are already 3D so the batch folds into the batch dimension of the matmul
+            return matmul(lhs == nullptr ? lop : lhs, rhs == nullptr ? rop : rhs);
+        case BinaryMode::INDEX:
+        case BinaryMode::MASK:
+            // Packed masks are flat so their words cannot be split by example
+            throw UnbatchableOp(op->get_opname());
+        case BinaryMode::CONV: {
+            // Examples of a batched input fold into the batch of images when the weight is shared
+            if (op->get_opcode() != Opcode::CONV2D || lhs == nullptr || rhs != nullptr) {
+                throw UnbatchableOp(op->get_opname());
+            }
+            ShapeView in_view = lhs->get_lazy()->get_view();
+            ShapeView folded_view(in_view.begin() + 1, in_view.end());
+            folded_view[0] *= batch_size;
+            OpPtr out_op = conv2d(reshape(lhs, folded_view), rop, static_pointer_cast<Conv2dOp>(op)->get_params());
+            ShapeView batched_view = {batch_size};
+            const ShapeView &view = op->get_lazy()->get_view();
+            batched_view.insert(batched_view.end(), view.begin(), view.end());
+            return reshape(out_op, batched_view);
+        }
+        case BinaryMode::ROW:
+            if (op->get_opcode() == Opcode::CROSS_ENTROPY) {
+                // Each row of logits needs its own label so both operands must carry the batch
+                if (lhs == nullptr || rhs == nullptr) {
+                    throw UnbatchableOp(op->get_opname());
+                }
+                return cross_entropy(lhs, rhs);
+            }
+            break;
+        default:
+            break;
+        }
+
+        isize ndim = op->get_lazy()->get_ndim();
+        OpPtr aligned_lhs = align(lop, lhs, ndim);
+        OpPtr aligned_rhs = align(rop, rhs, ndim);
+        bool in_place = op->is_in_place();
+        // An in-place op cannot write a whole batch into an unbatched array
+        if (in_place && lhs == nullptr) {
+            throw UnbatchableOp(op->get_opname());
+        }
+
+        switch (op->get_opcode()) {
+        case Opcode::ADD:
+            return in_place ? inplace_add(aligned_lhs, aligned_rhs) : add(aligned_lhs, aligned_rhs);
+        case Opcode::SUB:
+            return in_place ? inplace_sub(aligned_lhs, aligned_rhs) : sub(aligned_lhs, aligned_rhs);
+        case Opcode::MUL:
+            return in_place ? inplace_mul(aligned_lhs, aligned_rhs) : mul(aligned_lhs, aligned_rhs);
+        case Opcode::DIV:
+            return in_place ? inplace_div(aligned_lhs, aligned_rhs) : div(aligned_lhs, aligned_rhs);
+        case Opcode::EQ:
+            return eq(aligned_lhs, aligned_rhs);
+        case Opcode::NEQ:
+            return neq(aligned_lhs, aligned_rhs);
+        case Opcode::LT:
+            return lt(aligned_lhs, aligned_rhs);
+        case Opcode::GT:
+            return gt(aligned_lhs, aligned_rhs);
+        case Opcode::LEQ:
+            return leq(aligned_lhs, aligned_rhs);
+        case Opcode::GEQ:
+            return geq(aligned_lhs, aligned_rhs);
+        case Opcode::MINIMUM:
+            return minimum(aligned_lhs, aligned_rhs);
+        case Opcode::MAXIMUM:
+            return maximum(aligned_lhs, aligned_rhs);
+        case Opcode::QUANTIZE:
+            return quantize(aligned_lhs, aligned_rhs);
+        case Opcode::SOFTMAX_GRAD:
+            return softmax_grad(aligned_lhs, aligned_rhs);
+        case Opcode::LOG_SOFTMAX_GRAD:
+            return log_softmax_grad(aligned_lhs, aligned_rhs);
+        case Opcode::RELU_GRAD:
+            return relu_grad(aligned_lhs, aligned_rhs);
+        case Opcode::GELU_GRAD:
+            return gelu_grad(aligned_lhs, aligned_rhs);
+        case Opcode::SILU_GRAD:
+            return silu_grad(aligned_lhs, aligned_rhs);
+        default:
+            throw UnbatchableOp(op->get_opname());
+        }
+    }
+
+    OpPtr BatchRewriter::rewrite_transform(OpPtr op, OpPtr operand) {
+        ShapeView batched_view = {batch_size};
+        const ShapeView &view = op->get_lazy()->get_view();
+        batched_view.insert(batched_view.end(), view.begin(), view.end());
+
+        switch (op->get_opcode()) {
+        case Opcode::RESHAPE:
+            return reshape(operand, batched_view);
+        case Opcode::SLICE: {
+            RangeVec ranges = {Range(0, batch_size, 1)};
+            const RangeVec &example_ranges = static_pointer_cast<SliceOp>(op)->get_ranges();
+            ranges.insert(ranges.end(), example_ranges.begin(), example_ranges.end());
+            return slice(operand, ranges);
+        }
+        case Opcode::PERMUTE: {
+            ShapeDims dims = {0};
+            for (isize dim : static_pointer_cast<PermuteOp>(op)->get_perm()) {
+                dims.push_back(dim + 1);
+            }
+            return permute(operand, dims);
+        }
+        case Opcode::BROADCAST: {
+            // Broadcasting may prepend dimensions, which must go after the batch dimension
+            OpPtr example_operand = static_pointer_cast<BroadcastOp>(op)->get_operand();
+            return broadcast_to(align(example_operand, operand, view.size()), batched_view);
+        }
+        case Opcode::SQUEEZE: {
+            ShapeDims dims;
+            const ShapeDims &example_dims = static_pointer_cast<SqueezeOp>(op)->get_dims();
+            if (example_dims.empty()) {
+                // Squeezing every singleton dimension must not squeeze a batch of size 1
+                const ShapeView &operand_view = static_pointer_cast<SqueezeOp>(op)->get_operand()->get_lazy()->get_view();
+                for (size_t i = 0; i < operand_view.size(); i++) {
+                    if (operand_view[i] == 1) {
+                        dims.push_back(i + 1);
+                    }
+                }
+                if (dims.empty()) {
+                    return operand;
+                }
+            } else {
+                for (isize dim : example_dims) {
+                    dims.push_back(dim + 1);
+                }
+            }
+            return squeeze(operand, dims);
+        }
+        case Opcode::UNSQUEEZE: {
+            ShapeDims dims;
+            for (isize dim : static_pointer_cast<UnsqueezeOp>(op)->get_dims()) {
+                dims.push_back(dim + 1);
+            }
+            return unsqueeze(operand, dims);
+        }
+        case Opcode::ASTYPE:
+            return astype(operand, static_pointer_cast<AstypeOp>(op)->get_dtype());
+        default:
+            throw UnbatchableOp(op->get_opname());
+        }
+    }
+
+    OpPtr BatchRewriter::rewrite_reduce(OpPtr op, OpPtr operand) {
+        NodePtr<ReduceOp> reduce_op = static_pointer_cast<ReduceOp>(op);
+        ShapeDims dims;
+
+        if (reduce_op->get_dims().empty()) {
+            // Each example is reduced to one element
+            operand = reshape(operand, {batch_size, reduce_op->get_operand()->get_lazy()->get_numel()});
+            dims = {1};
+        } else {
+            // The reduced dimensions of each example were already moved to the last dimension
+            dims = {operand->get_lazy()->get_ndim() - 1};
+        }
+
+        switch (op->get_opcode()) {
+        case Opcode::SUM:
+            return sum(operand, dims);
+        case Opcode::MAX:
+            return max(operand, dims);
+        case Opcode::MIN:
+            return min(operand, dims);
+        case Opcode::ARGMAX:
+            return argmax(operand, dims);
+        case Opcode::ARGMIN:
+            return argmin(operand, dims);
+        default:
+            throw UnbatchableOp(op->get_opname());
+        }
+    }
+} // namespace ax::graph
@@ -0,0 +1,32 @@
+#pragma once
+
+#include "ops.h"
+
+namespace ax::graph {
+    // Rewrites a graph traced on per-example placeholders into a graph over the whole batch
+    // Every batched op keeps the batch dimension first, followed by the per-example dimensions
+    // Ops that do not depend on any placeholder are shared as-is by the batched graph
+    class BatchRewriter {
+    private:
+        isize batch_size;
+        // Batched op of each visited per-example op, null if the op does not depend on the batch
+        std::unordered_map<Id, OpPtr> batched;
+
+        OpPtr rewrite(OpPtr op);
+        OpPtr rewrite_unary(OpPtr op, OpPtr operand);
+        OpPtr rewrite_binary(OpPtr op, OpPtr lhs, OpPtr rhs);
+        OpPtr rewrite_transform(OpPtr op, OpPtr operand);
+        OpPtr rewrite_reduce(OpPtr op, OpPtr operand);
+        // Moves an operand into the batched graph, aligning its per-example dimensions to ndim
+        OpPtr align(OpPtr op, OpPtr batched_op, isize ndim);
+
+    public:
+        BatchRewriter(isize batch_size) : batch_size(batch_size) {}
+        BatchRewriter(const BatchRewriter &) = delete;
+        BatchRewriter &operator=(const BatchRewriter &) = delete;
+        isize get_batch_size() const { return batch_size; }
+        // Binds a per-example placeholder to its batched input whose first dimension is the batch
+        void bind(OpPtr placeholder, OpPtr batched_input);
+        OpPtr operator()(OpPtr out_op);
+    };
+} // namespace ax::graph
@@ -14,7 +14,71 @@ namespace ax::nn {
         return x.matmul(weight.transpose(weight_ndim - 2, weight_ndim - 1));
     }
 
+    inline Array gelu(const Array &x) {
+        return x.gelu();
+    }
+
+    inline Array silu(const Array &x) {
+        return x.silu();
+    }
+
+    // Weight of shape (out_features, in_features) read by the matmul without being transposed
+    // Bias and activation are applied as each output element is written
+    inline Array linear(const Array &x, const Array &weight, const Array &bias, Activation activation) {
+        return x.linear(weight, bias, activation);
+    }
+
     inline Array linear_with_bias(const Array &x, const Array &weight, const Array &bias) {
+        DtypePtr dtype = x.get_dtype();
+        if (weight.get_ndim() == 2 && bias.get_ndim() == 1 && float_dtypes.contains(dtype) && weight.get_dtype() == dtype && bias.get_dtype() == dtype) {
+            return linear(x, weight, bias, Activation::NONE);
+        }
+        // Batched weights, broadcasted biases and mixed dtypes take the unfused path
+        return linear(x, weight) + bias;
+    }
+
+    // Convolution of NCHW inputs with (out_channels, in_channels / groups, KH, KW) weights
+    // The optional bias holds one value per output channel
+    inline Array conv2d(const Array &x, const Array &weight, const std::optional<Array> &bias, const ShapeView &stride, const ShapeView &padding, const ShapeView &dilation, isize groups) {
+        Array out = x.conv2d(weight, stride, padding, dilation, groups);
+        if (!bias.has_value()) {
+            return out;
+        }
+        return out + bias->reshape({bias->get_numel(), 1, 1});
+    }
+
+    // Linear weight stored as i8 along with one f32 scale per output channel
+    // weight: (*, out_features, in_features), scale: (*, out_features, 1)
+    struct QuantizedWeight {
+        Array weight;
+        Array scale;
+    };
+
+    // Symmetric scale mapping the largest magnitude along dims to 127
+    // All-zero inputs get the smallest positive scale so that they quantize to zeros
+    inline Array absmax_scale(const Array &x, const ShapeDims &dims = {}) {
+        Array absmax = x.max(dims).maximum(-x.min(dims));
+        return (absmax / 127.0f).maximum(std::numeric_limits<float>::min());
+    }
+
+    inline QuantizedWeight quantize_weight(const Array &weight) {
+        Array f32_weight = weight.get_dtype() == &f32 ? weight : weight.astype(&f32);
+        Array scale = absmax_scale(f32_weight, {f32_weight.get_ndim() - 1});
+        return {f32_weight.quantize(scale), scale};
+    }
+
+    inline Array linear(const Array &x, const QuantizedWeight &weight) {
+        // Activations are quantized on the fly with a single scale
+        // so that both scales fold into one per output channel
+        Array f32_x = x.get_dtype() == &f32 ? x : x.astype(&f32);
+        Array x_scale = absmax_scale(f32_x);
+        isize weight_ndim = weight.weight.get_ndim();
+        Array scale = weight.scale.transpose(weight_ndim - 2, weight_ndim - 1) * x_scale;
+        Array out = f32_x.quantize(x_scale).qmatmul(weight.weight.transpose(weight_ndim - 2, weight_ndim - 1), scale);
+        return x.get_dtype() == &f32 ? out : out.astype(x.get_dtype());
+    }
+
+    inline Array linear_with_bias(const Array &x, const QuantizedWeight &weight, const Array &bias) {
         return linear(x, weight) + bias;
     }
 
@@ -32,32 +96,14 @@ namespace ax::nn {
     inline Array cross_entropy_loss(const Array &x, const Array &y) {
         /*
         x is logits, y is target
-        compute cross entropy loss -sum(y * log(softmax(x)))
-        softmax(x) = exp(x) / sum(exp(x))
-        log(softmax(x)) = x - log(sum(exp(x)))
-        loss = -sum(y * (x - log(sum(exp(x)))))
-        loss = -sum(y * x) + sum(y * log(sum(exp(x))))
-        sum(y) = 1 and log(sum(exp(x))) is a scalar
-        loss = -sum(y * x) + log(sum(exp(x)))
-        logsumexp trick for numerical stability:
-        log(sum(exp(x))) = max(x) + log(sum(exp(x - max(x))))
+        compute cross entropy loss -sum(onehot(y) * log(softmax(x)))
+        log(softmax(x)) = x - logsumexp(x)
+        loss = -x[y] + logsumexp(x) since onehot(y) only keeps the target logit
         x: (*, N)
-        y: (*, 1) for labels
-        max_x: (*, 1)
-        exp_x: (*, N)
-        sum_exp_x: (*, 1)
-        log_sum_exp_x: (*, 1)
-        onehot_y: (*, N)
-        onehot_y * x: (*, N)
-        loss: (*, 1)
+        y: (*) for labels
+        loss: (*)
+        The target logit is gathered by the logsumexp kernel so the one-hot rows are never built
         */
-        isize x_ndim = x.get_ndim();
-        Array max_x = x.max({x_ndim - 1});
-        Array exp_x = (x - max_x).exp();
-        Array sum_exp_x = exp_x.sum({x_ndim - 1});
-        Array log_sum_exp_x = sum_exp_x.log() + max_x;
-        Array onehot_y = onehot(y).astype(x.get_dtype());
-        Array loss = -(onehot_y * x).sum({x_ndim - 1}) + log_sum_exp_x;
-        return loss.mean();
+        return x.cross_entropy(y).mean();
     }
 } // namespace ax::nn
\ No newline at end of file
@@ -6,19 +6,121 @@ namespace ax::optim {
     using namespace ax::array;
 
     class Optimizer {
+    private:
+        // Persistent gradients are contiguous and live in shared memory
+        template <class T>
+        static bool scale_on_host(LazyPtr grad_lazy, float factor) {
+            T *ptr = reinterpret_cast<T *>(grad_lazy->get_ptr());
+            bool finite = true;
+            for (isize i = 0; i < grad_lazy->get_numel(); i++) {
+                float x = static_cast<float>(ptr[i]) * factor;
+                finite &= std::isfinite(x);
+                ptr[i] = T(x);
+            }
+            return finite;
+        }
+
     protected:
         float lr;
         ArrayVec params;
         ArrayVec grads;
         bool initial_step = false;
+        // Parameter ops that own the persistent gradients
+        std::vector<OpPtr> grad_owners;
+        // Flat buffers backing the gradients of all parameters bound at construction
+        LazyPtrVec grad_buffs;
+        // Gradients allocated before construction that must be zeroed one by one
+        std::vector<OpPtr> loose_grad_owners;
+
+        void bind_grad_buffs() {
+            // Parameters without a gradient yet get views into one flat buffer per dtype and device
+            std::vector<std::vector<OpPtr>> groups;
+            for (OpPtr &op : grad_owners) {
+                LazyPtr lazy = op->get_lazy();
+                if (op->get_persistent_grad() != nullptr || lazy->get_dtype()->get_type() != DtypeType::FLOAT) {
+                    loose_grad_owners.push_back(op);
+                    continue;
+                }
+                auto group = std::find_if(groups.begin(), groups.end(), [&](const std::vector<OpPtr> &g) {
+                    LazyPtr first = g[0]->get_lazy();
+                    return first->get_dtype() == lazy->get_dtype() && first->get_device() == lazy->get_device();
+                });
+                if (group == groups.end()) {
+                    groups.push_back({op});
+                } else {
+                    group->push_back(op);
+                }
+            }
+
+            for (auto &group : groups) {
+                LazyPtr first = group[0]->get_lazy();
+                DtypePtr grad_dtype = float_dtype_by_dtype.at(first->get_dtype());
+                isize numel = 0;
+                for (OpPtr &op : group) {
+                    numel += op->get_lazy()->get_numel();
+                }
+                Array buff(zeros({numel}, grad_dtype, first->get_device()));
+                buff.eval();
+                LazyPtr buff_lazy = buff.get_op()->get_lazy();
+                isize offset = 0;
+                for (OpPtr &op : group) {
+                    LazyPtr lazy = op->get_lazy();
+                    LazyPtr grad_lazy = Lazy::empty(Shape(offset, lazy->get_view()), grad_dtype, lazy->get_device());
+                    grad_lazy->init_buff(buff_lazy->get_buff());
+                    op->set_persistent_grad(grad_lazy);
+                    offset += lazy->get_numel();
+                }
+                grad_buffs.push_back(buff_lazy);
+            }
+        }
 
     public:
-        Optimizer(const ArrayVec &params, float lr = 1e-3) : params(params), lr(lr) {}
+        Optimizer(const ArrayVec &params, float lr = 1e-3) : params(params), lr(lr) {
+            for (const Array &param : params) {
+                grad_owners.push_back(param.get_op());
+            }
+            bind_grad_buffs();
+        }
         virtual ~Optimizer() = default;
         Optimizer(const Optimizer &) = delete;
         Optimizer &operator=(const Optimizer &) = delete;
         virtual void forward() = 0;
 
+        void zero_grad() {
+            // Kernels are synchronous and buffers live in shared memory so they can be cleared from the host
+            for (LazyPtr &buff : grad_buffs) {
+                std::memset(buff->get_buff_ptr(), 0, buff->get_buff_nbytes());
+            }
+            for (OpPtr &op : loose_grad_owners) {
+                LazyPtr grad_lazy = op->get_persistent_grad();
+                if (grad_lazy != nullptr && grad_lazy->get_buff() != nullptr) {
+                    std::memset(grad_lazy->get_ptr(), 0, grad_lazy->get_nbytes());
+                }
+            }
+        }
+
+        // Multiplies every gradient by factor from the host and checks that none of them overflowed
+        bool scale_grads(float factor) {
+            bool finite = true;
+            for (OpPtr &op : grad_owners) {
+                LazyPtr grad_lazy = op->get_persistent_grad();
+                if (grad_lazy == nullptr || grad_lazy->get_buff() == nullptr) {
+                    continue;
+                }
+                DtypePtr dtype = grad_lazy->get_dtype();
+                if (dtype == &f32) {
+                    finite &= scale_on_host<float>(grad_lazy, factor);
+                } else if (dtype == &f16) {
+                    finite &= scale_on_host<Float16>(grad_lazy, factor);
+                } else if (dtype == &bf16) {
+                    finite &= scale_on_host<BFloat16>(grad_lazy, factor);
+                } else {
+                    throw IncompatDtypeForOp("scale_grads", dtype->str());
+                }
+            }
+            return finite;
+        }
+
         void step() {
             // Initialize gradients and parameters if not already initialized
             if (!initial_step) {
@@ -55,4 +157,44 @@ namespace ax::optim {
             }
         }
     };
-} // namespace ax::optim
\ No newline at end of file
+
+    // Dynamic loss scaling for low precision backward passes
+    // The loss is multiplied by a large scale so that small gradients do not flush to zero,
+    // the gradients are unscaled before the update and steps whose gradients overflowed are skipped
+    // The scale backs off after an overflow and grows after growth_interval steps without one
+    class GradScaler {
+    private:
+        float scale;
+        float growth_factor;
+        float backoff_factor;
+        isize growth_interval;
+        isize good_steps = 0;
+
+    public:
+        GradScaler(float init_scale = 65536.0f, float growth_factor = 2.0f, float backoff_factor = 0.5f, isize growth_interval = 2000) : scale(init_scale), growth_factor(growth_factor), backoff_factor(backoff_factor), growth_interval(growth_interval) {
+            if (init_scale <= 0 || growth_factor < 1 || backoff_factor <= 0 || backoff_factor >= 1 || growth_interval <= 0) {
+                throw std::invalid_argument("Invalid gradient scaler settings.");
+            }
+        }
+
+        float get_scale() const { return scale; }
+        Array scale_loss(const Array &loss) const { return loss * scale; }
+
+        // Returns whether the optimizer stepped
+        bool step(Optimizer &optim) {
+            bool finite = optim.scale_grads(1.0f / scale);
+            if (finite) {
+                optim.step();
+                good_steps++;
+                if (good_steps == growth_interval) {
+                    scale *= growth_factor;
+                    good_steps = 0;
+                }
+            } else {
+                scale *= backoff_factor;
+                good_steps = 0;
+            }
+            return finite;
+        }
+    };
+} // namespace ax::optim
@@ -0,0 +1,76 @@
+#pragma once
+
+#include "../array/array.h"
+#include "../graph/vmap.h"
+
+namespace ax::nn {
+    using namespace ax::array;
+
+    // Traces f once on per-example placeholders and rewrites the trace to run on the whole batch
+    // in_dims holds the batch dimension of each input, or nullopt for inputs shared by all examples
+    // A single entry applies to every input
+    inline Array vmap(const std::function<Array(const ArrayVec &)> &f, const ArrayVec &inputs, const std::vector<std::optional<isize>> &in_dims) {
+        if (in_dims.size() != 1 && in_dims.size() != inputs.size()) {
+            throw std::invalid_argument("Expected 1 or " + std::to_string(inputs.size()) + " input dimensions for vmap but received " + std::to_string(in_dims.size()) + ".");
+        }
+
+        std::optional<isize> batch_size = std::nullopt;
+        ArrayVec placeholders;
+        std::vector<std::pair<OpPtr, OpPtr>> bindings;
+
+        for (size_t i = 0; i < inputs.size(); i++) {
+            const Array &input = inputs[i];
+            std::optional<isize> in_dim = in_dims.size() == 1 ? in_dims[0] : in_dims[i];
+            if (!in_dim.has_value()) {
+                placeholders.push_back(input);
+                continue;
+            }
+
+            isize ndim = input.get_ndim();
+            isize dim = in_dim.value() < 0 ? in_dim.value() + ndim : in_dim.value();
+            if (dim < 0 || dim >= ndim) {
+                throw OutOfRange(in_dim.value(), -ndim, ndim);
+            }
+            const ShapeView &view = input.get_view();
+            if (batch_size.has_value() && batch_size.value() != view[dim]) {
+                throw std::invalid_argument("Inputs of vmap have different batch sizes " + std::to_string(batch_size.value()) + " and " + std::to_string(view[dim]) + ".");
+            }
+            batch_size = view[dim];
+
+            // Move the batch dimension first
+            ShapeDims perm = {dim};
+            ShapeView example_view;
+            for (isize d = 0; d < ndim; d++) {
+                if (d != dim) {
+                    perm.push_back(d);
+                    example_view.push_back(view[d]);
+                }
+            }
+            if (example_view.empty()) {
+                // Examples of 1D inputs are singletons
+                example_view.push_back(1);
+            }
+
+            OpPtr batched_input = dim == 0 ? input.get_op() : ax::graph::permute(input.get_op(), perm);
+            if (batched_input->get_lazy()->get_ndim() == 1) {
+                batched_input = ax::graph::unsqueeze(batched_input, {1});
+            }
+            // Placeholders only record the per-example graph and are never evaluated
+            LazyPtr placeholder_lazy = Lazy::empty(Shape(example_view), input.get_dtype(), input.get_device());
+            OpPtr placeholder = make_node<Nop>(placeholder_lazy);
+            placeholders.push_back(Array(placeholder));
+            bindings.emplace_back(placeholder, batched_input);
+        }
+
+        if (!batch_size.has_value()) {
+            throw std::invalid_argument("vmap needs at least one batched input.");
+        }
+
+        Array example_out = f(placeholders);
+        BatchRewriter rewriter(batch_size.value());
+        for (auto &[placeholder, batched_input] : bindings) {
+            rewriter.bind(placeholder, batched_input);
+        }
+        return Array(rewriter(example_out.get_op()));
+    }
+} // namespace ax::nn
@@ -104,8 +104,20 @@ namespace ax::bind {
     axc::DtypePtr dtype_from_nb_dtype(nb::dlpack::dtype nb_dtype) {
         if (nb_dtype == nb::dtype<float>()) {
             return &axc::f32;
+        } else if (nb_dtype == nb::dtype<double>()) {
+            return &axc::f64;
+        } else if (nb_dtype == get_nb_dtype<axc::Float16>()) {
+            return &axc::f16;
+        } else if (nb_dtype == get_nb_dtype<axc::BFloat16>()) {
+            return &axc::bf16;
+        } else if (nb_dtype == nb::dtype<int8_t>()) {
+            return &axc::i8;
+        } else if (nb_dtype == nb::dtype<int16_t>()) {
+            return &axc::i16;
         } else if (nb_dtype == nb::dtype<int>()) {
             return &axc::i32;
+        } else if (nb_dtype == nb::dtype<int64_t>()) {
+            return &axc::i64;
         } else if (nb_dtype == nb::dtype<bool>()) {
             return &axc::b8;
         }
@@ -123,10 +135,25 @@ namespace ax::bind {
 
     nb::ndarray<nb::numpy> array_to_numpy(axr::Array &arr) {
         switch (arr.get_dtype()->get_name()) {
+        case axc::DtypeName::F16:
+            return array_to_numpy_impl<axc::Float16>(arr);
+        case axc::DtypeName::BF16: {
+            // Numpy has no bfloat16 so the values are widened to f32 first
+            nb::object pyarr = nb::cast(arr.astype(&axc::f32));
+            return array_to_numpy_impl<float>(nb::cast<axr::Array &>(pyarr));
+        }
         case axc::DtypeName::F32:
             return array_to_numpy_impl<float>(arr);
+        case axc::DtypeName::F64:
+            return array_to_numpy_impl<double>(arr);
+        case axc::DtypeName::I8:
+            return array_to_numpy_impl<int8_t>(arr);
+        case axc::DtypeName::I16:
+            return array_to_numpy_impl<int16_t>(arr);
         case axc::DtypeName::I32:
             return array_to_numpy_impl<int>(arr);
+        case axc::DtypeName::I64:
+            return array_to_numpy_impl<int64_t>(arr);
         default:
             return array_to_numpy_impl<bool>(arr);
         }
@@ -165,10 +192,22 @@ namespace ax::bind {
 
     nb::ndarray<nb::pytorch> array_to_torch(axr::Array &arr) {
         switch (arr.get_dtype()->get_name()) {
+        case axc::DtypeName::F16:
+            return array_to_torch_impl<axc::Float16>(arr);
+        case axc::DtypeName::BF16:
+            return array_to_torch_impl<axc::BFloat16>(arr);
         case axc::DtypeName::F32:
             return array_to_torch_impl<float>(arr);
+        case axc::DtypeName::F64:
+            return array_to_torch_impl<double>(arr);
+        case axc::DtypeName::I8:
+            return array_to_torch_impl<int8_t>(arr);
+        case axc::DtypeName::I16:
+            return array_to_torch_impl<int16_t>(arr);
         case axc::DtypeName::I32:
             return array_to_torch_impl<int>(arr);
+        case axc::DtypeName::I64:
+            return array_to_torch_impl<int64_t>(arr);
         default:
             return array_to_torch_impl<bool>(arr);
         }
@@ -179,20 +218,30 @@ namespace ax::bind {
         axc::DtypePtr dtype = arr.get_dtype();
 
         switch (dtype->get_name()) {
+        case axc::DtypeName::F16:
+            return nb::cast<float>(static_cast<float>(axc::Float16::from_bits(value)));
+        case axc::DtypeName::BF16:
+            return nb::cast<float>(static_cast<float>(axc::BFloat16::from_bits(value)));
         case axc::DtypeName::F32:
             return nb::cast<float>(std::bit_cast<float>(static_cast<int32_t>(value)));
+        case axc::DtypeName::F64:
+            return nb::cast<double>(std::bit_cast<double>(value));
+        case axc::DtypeName::I8:
+        case axc::DtypeName::I16:
         case axc::DtypeName::I32:
-            return nb::cast<int>(value);
+        case axc::DtypeName::I64:
+            return nb::cast<axc::isize>(value);
         default:
             return nb::cast<bool>(value);
         }
     }
 
     axr::Array full(const axc::ShapeView &view, const nb::object &obj, axc::DtypePtr dtype, const std::string &device_name) {
+        // Python floats and ints are kept at full width so that f64 and i64 arrays get their exact value
         if (nb::isinstance<nb::float_>(obj)) {
-            return axr::Array::full(view, nb::cast<float>(obj), dtype, device_name);
+            return axr::Array::full(view, nb::cast<double>(obj), dtype, device_name);
         } else if (nb::isinstance<nb::int_>(obj)) {
-            return axr::Array::full(view, nb::cast<int>(obj), dtype, device_name);
+            return axr::Array::full(view, nb::cast<axc::isize>(obj), dtype, device_name);
         } else if (nb::isinstance<nb::bool_>(obj)) {
             return axr::Array::full(view, nb::cast<bool>(obj), dtype, device_name);
         }
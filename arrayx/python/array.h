@@ -3,19 +3,44 @@
 #include "bind.h"
 
 namespace ax::bind {
+    // Nanobind has no builtin dtypes for the 16-bit floats
+    template <class T>
+    nb::dlpack::dtype get_nb_dtype() {
+        if constexpr (std::is_same_v<T, axc::Float16>) {
+            return nb::dlpack::dtype{static_cast<uint8_t>(nb::dlpack::dtype_code::Float), 16, 1};
+        } else if constexpr (std::is_same_v<T, axc::BFloat16>) {
+            return nb::dlpack::dtype{static_cast<uint8_t>(nb::dlpack::dtype_code::Bfloat), 16, 1};
+        } else {
+            return nb::dtype<T>();
+        }
+    }
+
+    // Owner of a view exported to numpy or torch
+    // Holding the array keeps its buffer from being donated and the export keeps it from being spilled
+    struct ExportOwner {
+        axr::Array arr;
+        std::shared_ptr<axd::Buffer> buff;
+
+        ExportOwner(axr::Array &arr) : arr(arr), buff(arr.export_buff()) {}
+        ~ExportOwner() { buff->release_export(); }
+    };
+
+    inline nb::capsule make_export_owner(axr::Array &arr) {
+        return nb::capsule(new ExportOwner(arr), [](void *owner) noexcept { delete static_cast<ExportOwner *>(owner); });
+    }
+
     template <class T>
     nb::ndarray<nb::numpy> array_to_numpy_impl(axr::Array &arr) {
-        arr.eval();
-        nb::object pyarr = nb::find(arr);
+        nb::capsule owner = make_export_owner(arr);
         std::vector<size_t> view(arr.get_shape().cbegin(), arr.get_shape().cend());
 
         return nb::ndarray<nb::numpy>(
             arr.get_ptr(),
             arr.get_ndim(),
             view.data(),
-            pyarr.ptr(),
+            owner,
             arr.get_stride().data(),
-            nb::dtype<T>(),
+            get_nb_dtype<T>(),
             // Numpy can only run on the cpu
             nb::device::cpu::value,
             'C');
@@ -23,8 +48,7 @@ namespace ax::bind {
 
     template <class T>
     nb::ndarray<nb::pytorch> array_to_torch_impl(axr::Array &arr) {
-        arr.eval();
-        nb::object pyarr = nb::find(arr);
+        nb::capsule owner = make_export_owner(arr);
         std::vector<size_t> view(arr.get_shape().cbegin(), arr.get_shape().cend());
         int device;
 
@@ -43,9 +67,9 @@ namespace ax::bind {
             arr.get_ptr(),
             arr.get_ndim(),
             view.data(),
-            pyarr.ptr(),
+            owner,
             arr.get_stride().data(),
-            nb::dtype<T>(),
+            get_nb_dtype<T>(),
             device,
             'C');
     }
@@ -63,7 +87,7 @@ namespace ax::bind {
         } else if (nb::isinstance<nb::float_>(obj)) {
             return f(arr, nb::cast<float>(obj));
         } else if (nb::isinstance<nb::int_>(obj)) {
-            return f(arr, nb::cast<int>(obj));
+            return f(arr, nb::cast<axc::isize>(obj));
         } else if (nb::isinstance<nb::bool_>(obj)) {
             return f(arr, nb::cast<bool>(obj));
         }
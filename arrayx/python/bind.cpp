@@ -19,13 +19,25 @@ NB_MODULE(arrayx, m) {
         .def("__str__", &axc::Dtype::str, "String representation of dtype");
 
     // Derived dtype classes
+    nb::class_<axc::F16, axc::Dtype>(m_core, "F16", "16-bit floating point dtype");
+    nb::class_<axc::BF16, axc::Dtype>(m_core, "BF16", "16-bit brain floating point dtype");
     nb::class_<axc::F32, axc::Dtype>(m_core, "F32", "32-bit floating point dtype");
+    nb::class_<axc::F64, axc::Dtype>(m_core, "F64", "64-bit floating point dtype");
+    nb::class_<axc::I8, axc::Dtype>(m_core, "I8", "8-bit integer dtype");
+    nb::class_<axc::I16, axc::Dtype>(m_core, "I16", "16-bit integer dtype");
     nb::class_<axc::I32, axc::Dtype>(m_core, "I32", "32-bit integer dtype");
+    nb::class_<axc::I64, axc::Dtype>(m_core, "I64", "64-bit integer dtype");
     nb::class_<axc::Bool, axc::Dtype>(m_core, "Bool", "Boolean dtype");
 
     // Global dtype instances
+    m_core.attr("f16") = &axc::f16;
+    m_core.attr("bf16") = &axc::bf16;
     m_core.attr("f32") = &axc::f32;
+    m_core.attr("f64") = &axc::f64;
+    m_core.attr("i8") = &axc::i8;
+    m_core.attr("i16") = &axc::i16;
     m_core.attr("i32") = &axc::i32;
+    m_core.attr("i64") = &axc::i64;
     m_core.attr("b8") = &axc::b8;
 
     // Shape class
@@ -48,10 +60,47 @@ NB_MODULE(arrayx, m) {
         .def_prop_ro("name", &axd::Device::get_name, "Get device's name")
         .def("__str__", &axd::Device::str, "String representation of device");
 
+    // Memory stats
+    nb::class_<axd::OpMemory>(m_core, "OpMemory")
+        .def_ro("opname", &axd::OpMemory::opname, "Name of the op that allocated the memory")
+        .def_ro("id", &axd::OpMemory::id, "ID of the op's array")
+        .def_ro("view", &axd::OpMemory::view, "View of the op's array")
+        .def_ro("nbytes", &axd::OpMemory::nbytes, "Live bytes allocated by the op");
+
+    nb::class_<axd::MemoryStats>(m_core, "MemoryStats")
+        .def_ro("current_bytes", &axd::MemoryStats::current_bytes, "Bytes currently allocated")
+        .def_ro("peak_bytes", &axd::MemoryStats::peak_bytes, "Maximum bytes allocated since the last reset")
+        .def_ro("reserved_bytes", &axd::MemoryStats::reserved_bytes, "Bytes held from the system")
+        .def_ro("cached_bytes", &axd::MemoryStats::cached_bytes, "Bytes kept cached for reuse")
+        .def_ro("alloc_count", &axd::MemoryStats::alloc_count, "Number of allocations")
+        .def_ro("free_count", &axd::MemoryStats::free_count, "Number of frees")
+        .def_ro("cache_hits", &axd::MemoryStats::cache_hits, "Number of allocations served from the cache")
+        .def_ro("cache_misses", &axd::MemoryStats::cache_misses, "Number of allocations that needed new memory")
+        .def_prop_ro("cache_hit_rate", &axd::MemoryStats::get_cache_hit_rate, "Fraction of allocations served from the cache")
+        .def_ro("fragmentation", &axd::MemoryStats::fragmentation, "Fraction of cached bytes outside the largest free block")
+        .def_ro("ops", &axd::MemoryStats::ops, "Live bytes grouped by the op that allocated them");
+
     // Backend class
     nb::class_<axr::Backend>(m_core, "Backend")
         .def_static("init", &axr::Backend::init, "Initialize backend")
-        .def_static("cleanup", &axr::Backend::cleanup, "Shutdown backend");
+        .def_static("cleanup", &axr::Backend::cleanup, "Shutdown backend")
+        .def_static("trim_cache", &axr::Backend::trim_cache, "Release cached device memory")
+        .def_static("set_cache_cap", &axr::Backend::set_cache_cap, "nbytes"_a, "Set the maximum number of bytes of device memory kept cached")
+        .def_static("enable_spill", &axr::Backend::enable_spill, "budget"_a, "dir"_a = "", "Spill cold buffers to disk once more than budget bytes are in use")
+        .def_static("disable_spill", &axr::Backend::disable_spill, "Fault spilled buffers back in and stop spilling")
+        .def_static("spilled_bytes", &axr::Backend::get_spilled_bytes, "device"_a = "mps:0", "Get the number of bytes of device buffers spilled to disk")
+        .def_static("memory_stats", &axr::Backend::get_memory_stats, "device"_a = "mps:0", "Get device memory statistics")
+        .def_static("reset_peak_memory_stats", &axr::Backend::reset_peak_memory_stats, "Reset the peak memory of every device to its current usage");
+
+    // Gradient mode
+    m_core.def("is_grad_enabled", &axg::GradMode::is_enabled, "Check if new operations are tracked for gradients");
+    m_core.def("set_grad_enabled", &axg::GradMode::set_enabled, "enabled"_a, "Enable/disable gradient tracking for new operations");
+    m_core.def("is_inference_mode", &axg::GradMode::is_inference, "Check if new operations are created in inference mode");
+    m_core.def("set_inference_mode", &axg::GradMode::set_inference, "enabled"_a, "Enable/disable inference mode for new operations");
+
+    // Autocast mode
+    m_core.def("get_autocast_dtype", &axg::AutocastMode::get_dtype, nb::rv_policy::reference, "Get the low precision dtype new operations are autocast to");
+    m_core.def("set_autocast_dtype", &axg::AutocastMode::set_dtype, "dtype"_a.none(), "Set the low precision dtype new operations are autocast to, None disables autocasting");
 
     // Array class
     nb::class_<axr::Array>(m_core, "Array")
@@ -103,14 +152,24 @@ NB_MODULE(arrayx, m) {
         .def("__imul__", &axb::inplace_mul, "rhs"_a, "In-place multiply two arrays element-wise")
         .def("__itruediv__", &axb::inplace_div, "rhs"_a, "In-place divide two arrays element-wise")
         .def("__matmul__", &axr::Array::matmul, "rhs"_a, "Matrix multiply two arrays")
+        .def("quantize", &axr::Array::quantize, "scale"_a, "Quantize array to i8 with the given scales")
+        .def("dequantize", &axr::Array::dequantize, "scale"_a, "Dequantize i8 array with the given scales")
+        .def("qmatmul", &axr::Array::qmatmul, "rhs"_a, "scale"_a, "Matrix multiply two i8 arrays and scale the i32 results")
+        .def("linear", &axr::Array::linear, "weight"_a, "bias"_a, "activation"_a = axg::Activation::NONE, "Linear layer with bias and activation fused into the matmul")
+        .def("conv2d", &axr::Array::conv2d, "weight"_a, "stride"_a = axc::ShapeView{1, 1}, "padding"_a = axc::ShapeView{0, 0}, "dilation"_a = axc::ShapeView{1, 1}, "groups"_a = 1, "2D convolution of NCHW array with (out_channels, in_channels / groups, KH, KW) weight")
         .def("detach", &axr::Array::detach, "Detach array from computation graph")
         .def("exp", &axr::Array::exp, "in_place"_a = false, "Compute exponential of array elements")
+        .def("gelu", &axr::Array::gelu, "in_place"_a = false, "Compute GELU of array elements with the tanh approximation")
+        .def("silu", &axr::Array::silu, "in_place"_a = false, "Compute SiLU of array elements")
         .def("log", &axr::Array::log, "in_place"_a = false, "Compute natural logarithm of array elements")
         .def("sqrt", &axr::Array::sqrt, "in_place"_a = false, "Compute square root of array elements")
         .def("sq", &axr::Array::sq, "in_place"_a = false, "Compute square of array elements")
         .def("neg", &axr::Array::neg, "in_place"_a = false, "Compute negative of array elements")
         .def("__neg__", &axb::neg, "Compute negative of array elements")
         .def("recip", &axr::Array::recip, "in_place"_a = false, "Compute reciprocal of array elements")
+        .def("softmax", &axr::Array::softmax, "Softmax over the last dimension")
+        .def("log_softmax", &axr::Array::log_softmax, "Log-softmax over the last dimension")
+        .def("cross_entropy", &axr::Array::cross_entropy, "labels"_a, "Cross-entropy of each row of logits against its integer class label")
 
         // Comparison operations
         .def("__eq__", &axb::eq, "rhs"_a, "Element-wise equality comparison")
@@ -121,6 +180,8 @@ NB_MODULE(arrayx, m) {
         .def("__ge__", &axb::geq, "rhs"_a, "Element-wise greater than or equal comparison")
         .def("minimum", &axb::minimum, "rhs"_a, "Element-wise minimum comparison")
         .def("maximum", &axb::maximum, "rhs"_a, "Element-wise maximum comparison")
+        .def("pack_mask", &axr::Array::pack_mask, "Pack boolean array into i32 words of 32 bits")
+        .def("mask_mul", &axr::Array::mask_mul, "mask"_a, "Zero out elements where the boolean or packed mask is not set")
 
         // Reduction operations
         .def("sum", &axb::sum, "dims"_a = axc::ShapeDims{}, "Sum array elements along specified dimensions")
@@ -129,6 +190,10 @@ NB_MODULE(arrayx, m) {
         .def("min", &axb::min, "dims"_a = axc::ShapeDims{}, "Minimum value along specified dimensions")
         .def("argmax", &axb::argmax, "dims"_a = axc::ShapeDims{}, "Indices of maximum values along specified dimensions")
         .def("argmin", &axb::argmin, "dims"_a = axc::ShapeDims{}, "Indices of minimum values along specified dimensions")
+        .def("logsumexp", &axr::Array::logsumexp, "Log of the sum of exponentials over the last dimension")
+        .def("count_nonzero", &axr::Array::count_nonzero, "Number of nonzero elements")
+        .def("any", &axr::Array::any, "Whether any element is nonzero")
+        .def("all", &axr::Array::all, "Whether all elements are nonzero")
 
         // Shape operations
         .def("broadcast", &axr::Array::broadcast, "view"_a, "Broadcast array to new shape")
@@ -145,9 +210,10 @@ NB_MODULE(arrayx, m) {
         .def("astype", &axr::Array::astype, "dtype"_a, "Cast array to specified dtype")
 
         // Evaluation and backward
-        .def("eval", &axr::Array::eval, "Evaluate array and materialize values")
-        .def("backward", &axr::Array::backward, "Compute gradients through backpropagation")
-        .def("compile", &axr::Array::compile, "Compile array for faster execution")
+        // Running graphs does not touch Python objects so other threads can build and run their own graphs meanwhile
+        .def("eval", &axr::Array::eval, nb::call_guard<nb::gil_scoped_release>(), "Evaluate array and materialize values")
+        .def("backward", &axr::Array::backward, nb::call_guard<nb::gil_scoped_release>(), "Compute gradients through backpropagation")
+        .def("compile", &axr::Array::compile, nb::call_guard<nb::gil_scoped_release>(), "Compile array for faster execution")
 
         // String representation
         .def("__str__", &axr::Array::str, "String representation of array");
@@ -155,14 +221,40 @@ NB_MODULE(arrayx, m) {
     nb::class_<axo::Optimizer, axb::PyOptimizer>(m_optim, "Optimizer")
         .def(nb::init<const axr::ArrayVec &, float>(), "params"_a, "lr"_a = 1e-3, "Base optimizer")
         .def("forward", &axo::Optimizer::forward, "Parameter update function")
-        .def("step", &axo::Optimizer::step, "Update module parameters");
+        .def("step", &axo::Optimizer::step, "Update module parameters")
+        .def("zero_grad", &axo::Optimizer::zero_grad, "Reset accumulated parameter gradients to zero");
 
     nb::class_<axo::GradientDescent, axo::Optimizer>(m_optim, "GradientDescent")
         .def(nb::init<const axr::ArrayVec &, float>(), "params"_a, "lr"_a = 1e-3, "Gradient Descent optimizer");
 
-    m_nn.def("linear", &axnn::linear, "x"_a, "weight"_a, "Functional linear without bias");
-    m_nn.def("linear_with_bias", &axnn::linear_with_bias, "x"_a, "weight"_a, "bias"_a, "Functional linear with bias");
+    nb::class_<axo::GradScaler>(m_optim, "GradScaler")
+        .def(nb::init<float, float, float, axc::isize>(), "init_scale"_a = 65536.0f, "growth_factor"_a = 2.0f, "backoff_factor"_a = 0.5f, "growth_interval"_a = 2000, "Dynamic loss scaler for low precision backward passes")
+        .def_prop_ro("scale", &axo::GradScaler::get_scale, "Current loss scale")
+        .def("scale_loss", &axo::GradScaler::scale_loss, "loss"_a, "Multiply loss by the current scale")
+        .def("step", &axo::GradScaler::step, "optimizer"_a, "Unscale gradients and step the optimizer unless they overflowed");
+
+    nb::enum_<axg::Activation>(m_nn, "Activation")
+        .value("NONE", axg::Activation::NONE)
+        .value("RELU", axg::Activation::RELU)
+        .value("GELU", axg::Activation::GELU)
+        .value("SILU", axg::Activation::SILU);
+
+    nb::class_<axnn::QuantizedWeight>(m_nn, "QuantizedWeight")
+        .def(nb::init<axr::Array, axr::Array>(), "weight"_a, "scale"_a, "Linear weight quantized to i8 with one scale per output channel")
+        .def_rw("weight", &axnn::QuantizedWeight::weight, "Quantized weight")
+        .def_rw("scale", &axnn::QuantizedWeight::scale, "Scale of each output channel");
+
+    m_nn.def("linear", nb::overload_cast<const axr::Array &, const axr::Array &>(&axnn::linear), "x"_a, "weight"_a, "Functional linear without bias");
+    m_nn.def("linear", nb::overload_cast<const axr::Array &, const axnn::QuantizedWeight &>(&axnn::linear), "x"_a, "weight"_a, "Functional linear with quantized weight");
+    m_nn.def("linear", nb::overload_cast<const axr::Array &, const axr::Array &, const axr::Array &, axg::Activation>(&axnn::linear), "x"_a, "weight"_a, "bias"_a, "activation"_a, "Functional linear with bias and activation fused into the matmul")
+    m_nn.def("linear_with_bias", nb::overload_cast<const axr::Array &, const axr::Array &, const axr::Array &>(&axnn::linear_with_bias), "x"_a, "weight"_a, "bias"_a, "Functional linear with bias");
+    m_nn.def("linear_with_bias", nb::overload_cast<const axr::Array &, const axnn::QuantizedWeight &, const axr::Array &>(&axnn::linear_with_bias), "x"_a, "weight"_a, "bias"_a, "Functional linear with quantized weight and bias");
+    m_nn.def("quantize_weight", &axnn::quantize_weight, "weight"_a, "Quantize linear weight to i8 with one scale per output channel");
+    m_nn.def("conv2d", &axnn::conv2d, "x"_a, "weight"_a, "bias"_a = nb::none(), "stride"_a = axc::ShapeView{1, 1}, "padding"_a = axc::ShapeView{0, 0}, "dilation"_a = axc::ShapeView{1, 1}, "groups"_a = 1, "Functional 2D convolution with optional per-channel bias");
     m_nn.def("relu", &axnn::relu, "x"_a, "ReLU activation function");
+    m_nn.def("gelu", &axnn::gelu, "x"_a, "GELU activation function with the tanh approximation");
+    m_nn.def("silu", &axnn::silu, "x"_a, "SiLU activation function");
     m_nn.def("onehot", &axnn::onehot, "x"_a, "num_classes"_a = -1, "One-hot encode input array");
     m_nn.def("cross_entropy_loss", &axnn::cross_entropy_loss, "x"_a, "y"_a, "Compute cross-entropy loss between input x and target y");
+    m_nn.def("vmap", &axnn::vmap, "f"_a, "inputs"_a, "in_dims"_a, "Run a per-example function on a batch of inputs as one batched graph");
 }
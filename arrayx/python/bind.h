@@ -3,21 +3,31 @@
 #include "../nn/jit.h"
 #include "../nn/nn.h"
 #include "../nn/optim.h"
+#include "../nn/vmap.h"
 #include <nanobind/nanobind.h>
 #include <nanobind/ndarray.h>
 #include <nanobind/operators.h>
+#include <nanobind/stl/function.h>
 #include <nanobind/stl/optional.h>
 #include <nanobind/stl/shared_ptr.h>
 #include <nanobind/stl/string.h>
+#include <nanobind/stl/detail/nb_list.h>
 #include <nanobind/stl/vector.h>
 #include <nanobind/trampoline.h>
 
+namespace nanobind::detail {
+    // Shape views and strides convert from and to Python lists like vectors do
+    template <class T, size_t N>
+    struct type_caster<ax::core::SmallVec<T, N>> : list_caster<ax::core::SmallVec<T, N>, T> {};
+} // namespace nanobind::detail
+
 namespace ax::bind {
 }
 
 namespace nb = nanobind;
 namespace axc = ax::core;
 namespace axd = ax::device;
+namespace axg = ax::graph;
 namespace axr = ax::array;
 namespace axnn = ax::nn;
 namespace axo = ax::optim;
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "utils.h"
+
+// Activations are computed in f32 and grad is the derivative w.r.t. the operand
+struct Identity
+{
+    template <class T>
+    float operator()(T x) const { return static_cast<float>(x); }
+};
+
+struct Relu
+{
+    template <class T>
+    float operator()(T x) const { return metal::max(static_cast<float>(x), 0.0f); }
+
+    // Also holds when given the output since it is positive exactly where the operand is
+    template <class T>
+    float grad(T x) const { return static_cast<float>(x) > 0.0f ? 1.0f : 0.0f; }
+};
+
+constant constexpr float sqrt_2_over_pi = 0.7978845608f;
+constant constexpr float gelu_cubic_coeff = 0.044715f;
+
+// Tanh approximation of 0.5 * x * (1 + erf(x / sqrt(2))), Metal having no erf
+struct Gelu
+{
+    template <class T>
+    float operator()(T x) const
+    {
+        float fx = static_cast<float>(x);
+        float t = metal::tanh(sqrt_2_over_pi * (fx + gelu_cubic_coeff * fx * fx * fx));
+        return 0.5f * fx * (1.0f + t);
+    }
+
+    template <class T>
+    float grad(T x) const
+    {
+        float fx = static_cast<float>(x);
+        float t = metal::tanh(sqrt_2_over_pi * (fx + gelu_cubic_coeff * fx * fx * fx));
+        float dt = sqrt_2_over_pi * (1.0f + 3.0f * gelu_cubic_coeff * fx * fx);
+        return 0.5f * (1.0f + t) + 0.5f * fx * (1.0f - t * t) * dt;
+    }
+};
+
+struct Silu
+{
+    template <class T>
+    float operator()(T x) const
+    {
+        float fx = static_cast<float>(x);
+        return fx / (1.0f + metal::exp(-fx));
+    }
+
+    template <class T>
+    float grad(T x) const
+    {
+        float fx = static_cast<float>(x);
+        float sigmoid = 1.0f / (1.0f + metal::exp(-fx));
+        return sigmoid * (1.0f + fx * (1.0f - sigmoid));
+    }
+};
@@ -1,4 +1,4 @@
-#include "utils.h"
+#include "atomic.h"
 
 struct Argmax
 {
@@ -40,43 +40,36 @@ struct Argmin
     static bool cmp(T old_val, T new_val) { return new_val < old_val; }
 };
 
+// Reduces the values and indices held by the threads of a threadgroup, leaving the extremum and its index in the first thread
+// pos and bound place the thread in the reduced row, lpos and lwidth in the threadgroup's share of that row
+// lbase is where the row's scratch starts and slot where the thread's SIMD group writes its partial result
 template <class Op, class T>
-kernel void arg_reduce_all(
-    const constant isize &numel [[buffer(0)]],
-    const constant isize &ndim [[buffer(1)]],
-    const constant isize *offset [[buffer(2)]],
-    const constant isize *shape [[buffer(3)]],
-    const constant isize *stride [[buffer(4)]],
-    const constant bool *strided [[buffer(5)]],
-    const device T *input [[buffer(6)]],
-    device metal::_atomic<uint> *output [[buffer(7)]],
-    threadgroup T *lvalue [[threadgroup(0)]],
-    threadgroup uint *larg [[threadgroup(1)]],
-    uint gid [[thread_position_in_grid]],
-    uint lid [[thread_position_in_threadgroup]],
-    uint lsize [[threads_per_threadgroup]],
-    uint simd_size [[threads_per_simdgroup]],
-    uint simd_lane_id [[thread_index_in_simdgroup]],
-    uint simd_group_id [[simdgroup_index_in_threadgroup]])
+inline void arg_reduce_threadgroup(
+    thread T &val,
+    thread uint &arg_idx,
+    uint pos,
+    uint bound,
+    uint lpos,
+    uint lwidth,
+    uint lbase,
+    uint slot,
+    threadgroup T *lvalue,
+    threadgroup uint *larg,
+    uint simd_size,
+    uint simd_lane_id)
 {
-    // Perform the first level of reduction.
-    // Read from device memory, write to threadgroup memory.
-    // val is stored in thread's register
     Op op;
     T default_val = op.template get_default<T>();
-    isize in_idx = *strided ? strided_idx(gid, ndim, shape, stride) : gid;
-    T val = input[offset[0] + in_idx];
     T shuffled_val;
-    uint arg_idx = gid;
     uint shuffled_arg_idx;
     
-    for (uint s = (lsize + simd_size - 1) / simd_size; s > 1; s /= simd_size)
+    for (uint s = (lwidth + simd_size - 1) / simd_size; s > 1; s /= simd_size)
     {
         // Perform per-SIMD partial reduction -> shuffling within SIMD group.
         // Each thread gets the value from another thread offset lanes above it.
         // Threads with index < offset lanes keep their original values.
         for (uint lanes = simd_size / 2; lanes > 0; lanes /= 2) {
-            if (gid + lanes < numel) {
+            if (pos + lanes < bound) {
                 shuffled_val = metal::simd_shuffle_down(val, lanes);
                 shuffled_arg_idx = metal::simd_shuffle_down(arg_idx, lanes);
                 op(val, shuffled_val, &val, arg_idx, shuffled_arg_idx, &arg_idx);
@@ -85,38 +78,81 @@ kernel void arg_reduce_all(
         
         // Write per-SIMD partial reduction value to threadgroup memory.
         if (simd_lane_id == 0) {
-            lvalue[simd_group_id] = val;
-            larg[simd_group_id] = arg_idx;
+            lvalue[lbase + slot] = val;
+            larg[lbase + slot] = arg_idx;
         }
         
         // Wait for all partial reductions to complete.
         threadgroup_barrier(metal::mem_flags::mem_threadgroup);
-        val = (lid < s) ? lvalue[lid] : default_val;
-        arg_idx = (lid < s) ? larg[lid] : 0;
+        val = (lpos < s) ? lvalue[lbase + lpos] : default_val;
+        arg_idx = (lpos < s) ? larg[lbase + lpos] : 0;
     }
     
     // Perform final per-SIMD partial reduction to calculate the threadgroup partial reduction result.
     for (uint lanes = simd_size / 2; lanes > 0; lanes /= 2) {
-        if (gid + lanes < numel) {
+        if (pos + lanes < bound) {
             shuffled_val = metal::simd_shuffle_down(val, lanes);
             shuffled_arg_idx = metal::simd_shuffle_down(arg_idx, lanes);
             op(val, shuffled_val, &val, arg_idx, shuffled_arg_idx, &arg_idx);
         }
     }
+}
+
+// Atomically swaps in the threadgroup's index unless the recorded one points at an element at least as extreme
+// row_start is the position of the reduced row's first element, to which the recorded indices are relative
+template <class Op, class T>
+inline void update_arg(
+    device metal::_atomic<uint> *output,
+    T val,
+    uint arg_idx,
+    isize row_start,
+    const device T *input,
+    const isize ndim,
+    const constant isize *shape,
+    const constant isize *stride,
+    bool strided)
+{
+    T prev_val;
+    uint prev_arg_idx = metal::atomic_load_explicit(output, metal::memory_order_relaxed);
+    
+    do {
+        isize in_idx = strided ? strided_idx(row_start + prev_arg_idx, ndim, shape, stride) : row_start + prev_arg_idx;
+        prev_val = input[in_idx];
+        
+        if (!Op::cmp(prev_val, val)) {
+            break;
+        }
+    } while (!metal::atomic_compare_exchange_weak_explicit(output, &prev_arg_idx, arg_idx, metal::memory_order_relaxed, metal::memory_order_relaxed));
+}
+
+template <class Op, class T>
+kernel void arg_reduce_all(
+    const constant isize &numel [[buffer(0)]],
+    const constant isize &ndim [[buffer(1)]],
+    const constant isize *offset [[buffer(2)]],
+    const constant isize *shape [[buffer(3)]],
+    const constant isize *stride [[buffer(4)]],
+    const constant bool *strided [[buffer(5)]],
+    const device T *input [[buffer(6)]],
+    device metal::_atomic<uint> *output [[buffer(7)]],
+    threadgroup T *lvalue [[threadgroup(0)]],
+    threadgroup uint *larg [[threadgroup(1)]],
+    uint gid [[thread_position_in_grid]],
+    uint lid [[thread_position_in_threadgroup]],
+    uint lsize [[threads_per_threadgroup]],
+    uint simd_size [[threads_per_simdgroup]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]])
+{
+    // val is stored in thread's register
+    isize in_idx = *strided ? strided_idx(gid, ndim, shape, stride) : gid;
+    T val = input[offset[0] + in_idx];
+    uint arg_idx = gid;
+    arg_reduce_threadgroup<Op, T>(val, arg_idx, gid, numel, lid, lsize, 0, simd_group_id, lvalue, larg, simd_size, simd_lane_id);
     
     // Atomically update the reduction result.
     if (lid == 0) {
-        T prev_val;
-        uint prev_arg_idx = metal::atomic_load_explicit(output + offset[1], metal::memory_order_relaxed);
-        
-        do {
-            in_idx = *strided ? strided_idx(prev_arg_idx, ndim, shape, stride) : prev_arg_idx;
-            prev_val = input[offset[0] + in_idx];
-            
-            if (!Op::cmp(prev_val, val)) {
-                break;
-            }
-        } while (!metal::atomic_compare_exchange_weak_explicit(output + offset[1], &prev_arg_idx, arg_idx, metal::memory_order_relaxed, metal::memory_order_relaxed));
+        update_arg<Op, T>(output + offset[1], val, arg_idx, 0, input + offset[0], ndim, shape, stride, *strided);
     }
 }
 
@@ -147,50 +183,83 @@ kernel void arg_reduce_col(
     T default_val = op.template get_default<T>();
     isize in_idx = *strided ? strided_idx(grow * N + gcol, ndim, shape, stride) : grow * N + gcol;
     T val = gcol < N ? input[offset[0] + in_idx] : default_val;
-    T shuffled_val;
     uint arg_idx = gcol;
-    uint shuffled_arg_idx;
+    arg_reduce_threadgroup<Op, T>(val, arg_idx, gcol, N, lcol, lwidth, lrow * lwidth, lcol / simd_size, lvalue, larg, simd_size, simd_lane_id);
     
-    for (uint s = (lwidth + simd_size - 1) / simd_size; s > 1; s /= simd_size)
-    {
-        for (uint lanes = simd_size/2; lanes > 0; lanes /= 2) {
-            if (gcol + lanes < N) {
-                shuffled_val = metal::simd_shuffle_down(val, lanes);
-                shuffled_arg_idx = metal::simd_shuffle_down(arg_idx, lanes);
-                op(val, shuffled_val, &val, arg_idx, shuffled_arg_idx, &arg_idx);
-            }
-        }
-        
-        if (simd_lane_id == 0) {
-            lvalue[lrow * lwidth + lcol / simd_size] = val;
-            larg[lrow * lwidth + lcol / simd_size] = arg_idx;
-        }
-        
-        threadgroup_barrier(metal::mem_flags::mem_threadgroup);
-        val = (lcol < s) ? lvalue[lrow * lwidth + lcol] : default_val;
-        arg_idx = (lcol < s) ? larg[lrow * lwidth + lcol] : 0;
+    if (lcol == 0) {
+        update_arg<Op, T>(output + offset[1] + grow, val, arg_idx, grow * N, input + offset[0], ndim, shape, stride, *strided);
     }
+}
+
+// Max and min that also record the index of each extremum, used by tracked reductions so that backward needs no second pass
+// Values and indices are updated by separate atomics but every threadgroup offers the same candidate to both,
+// so the reduced value is the one the recorded index points at
+// Narrow floats are reduced into f32 outputs like the plain reductions
+template <class Op, class AtomicOp, class T, class R>
+kernel void indexed_reduce_all(
+    const constant isize &numel [[buffer(0)]],
+    const constant isize &ndim [[buffer(1)]],
+    const constant isize *offset [[buffer(2)]],
+    const constant isize *shape [[buffer(3)]],
+    const constant isize *stride [[buffer(4)]],
+    const constant bool *strided [[buffer(5)]],
+    const device T *input [[buffer(6)]],
+    device metal::_atomic<R> *output [[buffer(7)]],
+    device metal::_atomic<uint> *index [[buffer(8)]],
+    threadgroup T *lvalue [[threadgroup(0)]],
+    threadgroup uint *larg [[threadgroup(1)]],
+    uint gid [[thread_position_in_grid]],
+    uint lid [[thread_position_in_threadgroup]],
+    uint lsize [[threads_per_threadgroup]],
+    uint simd_size [[threads_per_simdgroup]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]])
+{
+    isize in_idx = *strided ? strided_idx(gid, ndim, shape, stride) : gid;
+    T val = input[offset[0] + in_idx];
+    uint arg_idx = gid;
+    arg_reduce_threadgroup<Op, T>(val, arg_idx, gid, numel, lid, lsize, 0, simd_group_id, lvalue, larg, simd_size, simd_lane_id);
     
-    for (uint lanes = simd_size/2; lanes > 0; lanes /= 2) {
-        if (gcol + lanes < N) {
-            shuffled_val = metal::simd_shuffle_down(val, lanes);
-            shuffled_arg_idx = metal::simd_shuffle_down(arg_idx, lanes);
-            op(val, shuffled_val, &val, arg_idx, shuffled_arg_idx, &arg_idx);
-        }
+    if (lid == 0) {
+        AtomicOp()(output, offset[1], static_cast<R>(val));
+        update_arg<Op, T>(index + offset[2], val, arg_idx, 0, input + offset[0], ndim, shape, stride, *strided);
     }
+}
+
+template <class Op, class AtomicOp, class T, class R>
+kernel void indexed_reduce_col(
+    const constant isize &ndim [[buffer(0)]],
+    const constant isize *offset [[buffer(1)]],
+    const constant isize *shape [[buffer(2)]],
+    const constant isize *stride [[buffer(3)]],
+    const constant bool *strided [[buffer(4)]],
+    const device T *input [[buffer(5)]],
+    device metal::_atomic<R> *output [[buffer(6)]],
+    device metal::_atomic<uint> *index [[buffer(7)]],
+    threadgroup T *lvalue [[threadgroup(0)]],
+    threadgroup uint *larg [[threadgroup(1)]],
+    uint2 gid [[thread_position_in_grid]],
+    uint2 lid [[thread_position_in_threadgroup]],
+    uint2 lsize [[threads_per_threadgroup]],
+    uint simd_size [[threads_per_simdgroup]],
+    uint simd_lane_id [[thread_index_in_simdgroup]])
+{
+    const uint grow = gid.y;
+    const uint gcol = gid.x;
+    const uint lrow = lid.y;
+    const uint lcol = lid.x;
+    const uint lwidth = lsize.x;
+    const uint N = shape[1];
+    Op op;
+    T default_val = op.template get_default<T>();
+    isize in_idx = *strided ? strided_idx(grow * N + gcol, ndim, shape, stride) : grow * N + gcol;
+    T val = gcol < N ? input[offset[0] + in_idx] : default_val;
+    uint arg_idx = gcol;
+    arg_reduce_threadgroup<Op, T>(val, arg_idx, gcol, N, lcol, lwidth, lrow * lwidth, lcol / simd_size, lvalue, larg, simd_size, simd_lane_id);
     
     if (lcol == 0) {
-        T prev_val;
-        uint prev_arg_idx = metal::atomic_load_explicit(output + offset[1] + grow, metal::memory_order_relaxed);
-        
-        do {
-            in_idx = *strided ? strided_idx(grow * N + prev_arg_idx, ndim, shape, stride) : grow * N + prev_arg_idx;
-            prev_val = input[offset[0] + in_idx];
-            
-            if (!Op::cmp(prev_val, val)) {
-                break;
-            }
-        } while (!metal::atomic_compare_exchange_weak_explicit(output + offset[1] + grow, &prev_arg_idx, arg_idx, metal::memory_order_relaxed, metal::memory_order_relaxed));
+        AtomicOp()(output, offset[1] + grow, static_cast<R>(val));
+        update_arg<Op, T>(index + offset[2] + grow, val, arg_idx, grow * N, input + offset[0], ndim, shape, stride, *strided);
     }
 }
 
@@ -200,7 +269,25 @@ template [[host_name(#opname "_col_" #dtype)]] [[kernel]] decltype(arg_reduce_co
 
 #define arg_reduce(opname, op)              \
 make_arg_reduce(opname, op, f32, float);    \
-make_arg_reduce(opname, op, i32, int);
+make_arg_reduce(opname, op, f16, half);     \
+make_arg_reduce(opname, op, bf16, bfloat);  \
+make_arg_reduce(opname, op, i8, char);      \
+make_arg_reduce(opname, op, i16, short);    \
+make_arg_reduce(opname, op, i32, int);      \
+make_arg_reduce(opname, op, i64, long);
 
 arg_reduce(argmax, Argmax);
-arg_reduce(argmin, Argmin);
\ No newline at end of file
+arg_reduce(argmin, Argmin);
+
+#define make_indexed_reduce(opname, op, atomic_op, dtype, T, R) \
+template [[host_name(#opname "_all_" #dtype)]] [[kernel]] decltype(indexed_reduce_all<op, atomic_op, T, R>) indexed_reduce_all<op, atomic_op, T, R>;    \
+template [[host_name(#opname "_col_" #dtype)]] [[kernel]] decltype(indexed_reduce_col<op, atomic_op, T, R>) indexed_reduce_col<op, atomic_op, T, R>;
+
+// Only floating-point reductions take gradients
+#define indexed_reduce(opname, op, atomic_op)                   \
+make_indexed_reduce(opname, op, atomic_op, f32, float, float);  \
+make_indexed_reduce(opname, op, atomic_op, f16, half, float);   \
+make_indexed_reduce(opname, op, atomic_op, bf16, bfloat, float);
+
+indexed_reduce(indexed_max, Argmax, AtomicMaxFloat);
+indexed_reduce(indexed_min, Argmin, AtomicMinFloat);
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "utils.h"
+
+// Updates of one output element shared by the threadgroups of a reduction
+struct AtomicSum
+{
+    template <class T, class R>
+    void operator()(volatile device metal::_atomic<R> *output, isize idx, T val)
+    {
+        // memory_order_relaxed guarantees atomicity without ordering or proper synchronization
+        // since we're doing addition, this is somewhat similar to a counter
+        // atomic_fetch_add_explicit runs output += val but atomically
+        metal::atomic_fetch_add_explicit(output + idx, val, metal::memory_order_relaxed);
+    }
+};
+
+struct AtomicSumLong
+{
+    // Metal has no 64-bit atomic addition so each output is added to as two 32-bit words
+    // The carry out of the low word goes into the high word along with the high half of the value
+    // Every wrap of the low word is counted exactly once so the words add up to the 64-bit sum
+    void operator()(volatile device metal::_atomic<uint> *output, isize idx, long val)
+    {
+        ulong bits = as_type<ulong>(val);
+        uint lo = static_cast<uint>(bits);
+        uint hi = static_cast<uint>(bits >> 32);
+        uint old_lo = metal::atomic_fetch_add_explicit(output + 2 * idx, lo, metal::memory_order_relaxed);
+        hi += old_lo + lo < old_lo ? 1 : 0;
+        if (hi != 0) {
+            metal::atomic_fetch_add_explicit(output + 2 * idx + 1, hi, metal::memory_order_relaxed);
+        }
+    }
+};
+
+struct AtomicMaxInt {
+    template <class T, class R>
+    void operator()(volatile device metal::_atomic<R> *output, isize idx, T new_val)
+    {
+        metal::atomic_fetch_max_explicit(output + idx, new_val, metal::memory_order_relaxed);
+    }
+};
+
+struct AtomicMaxFloat
+{
+    template <class T, class R>
+    void operator()(volatile device metal::_atomic<R> *output, isize idx, T new_val)
+    {
+        output += idx;
+        // CAS algorithm
+        // output = max(output, val)
+        // Be cautious when T and R are not the same
+        R old_val = metal::atomic_load_explicit(output, metal::memory_order_relaxed);
+        do {
+            if (old_val >= new_val) {
+                break;
+            }
+        // old_val gets updated by metal::atomic_compare_exchange_weak_explicit if the operation fails
+        // No need for old_val to be in the while loop
+        } while (!metal::atomic_compare_exchange_weak_explicit(output, &old_val, new_val, metal::memory_order_relaxed, metal::memory_order_relaxed));
+    }
+};
+
+struct AtomicMinInt {
+    template <class T, class R>
+    void operator()(volatile device metal::_atomic<R> *output, isize idx, T new_val)
+    {
+        metal::atomic_fetch_min_explicit(output + idx, new_val, metal::memory_order_relaxed);
+    }
+};
+
+struct AtomicMinFloat
+{
+    template <class T, class R>
+    void operator()(volatile device metal::_atomic<R> *output, isize idx, T new_val)
+    {
+        output += idx;
+        // CAS algorithm
+        // output = min(output, val)
+        // Be cautious when T and R are not the same
+        R old_val = metal::atomic_load_explicit(output, metal::memory_order_relaxed);
+        do {
+            if (old_val <= new_val) {
+                break;
+            }
+        // old_val gets updated by metal::atomic_compare_exchange_weak_explicit if the operation fails
+        // No need for old_val to be in the while loop
+        } while (!metal::atomic_compare_exchange_weak_explicit(output, &old_val, new_val, metal::memory_order_relaxed, metal::memory_order_relaxed));
+    }
+};
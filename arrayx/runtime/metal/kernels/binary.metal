@@ -1,4 +1,4 @@
-#include "utils.h"
+#include "activation.h"
 
 struct Add
 {
@@ -72,7 +72,23 @@ struct Maximum
     T operator()(T lhs, T rhs) { return lhs > rhs ? lhs : rhs; }
 };
 
-template <class Op, class T, class R>
+// Rounds to the nearest step of the scale and saturates symmetrically so that -128 is never produced
+struct Quantize
+{
+    template <class T>
+    char operator()(T lhs, T rhs) { return static_cast<char>(metal::clamp(metal::rint(static_cast<float>(lhs) / static_cast<float>(rhs)), -127.0f, 127.0f)); }
+};
+
+// Activation gradients from the saved operand in lhs and the output gradient in rhs
+template <class Act>
+struct ActivationGrad
+{
+    template <class T>
+    T operator()(T lhs, T rhs) { return static_cast<T>(Act().grad(lhs) * static_cast<float>(rhs)); }
+};
+
+// Operands are read in their own dtypes and converted to the common dtype T in registers
+template <class Op, class L, class R, class T, class O>
 kernel void binary(
     const constant isize &ndim [[buffer(0)]],
     const constant isize *offset [[buffer(1)]],
@@ -81,35 +97,105 @@ kernel void binary(
     const constant isize *rstride [[buffer(4)]],
     const constant isize *outstride [[buffer(5)]],
     const constant bool *strided [[buffer(6)]],
-    device T *lhs [[buffer(7)]],
-    device T *rhs [[buffer(8)]],
-    device R *output [[buffer(9)]],
+    device L *lhs [[buffer(7)]],
+    device R *rhs [[buffer(8)]],
+    device O *output [[buffer(9)]],
     uint id [[thread_position_in_grid]])
 {
     isize lidx = strided[0] ? strided_idx(id, ndim, shape, lstride) : id;
     isize ridx = strided[1] ? strided_idx(id, ndim, shape, rstride) : id;
     isize out_idx = strided[2] ? strided_idx(id, ndim, shape, outstride) : id;
-    output[offset[2] + out_idx] = Op()(lhs[offset[0] + lidx], rhs[offset[1] + ridx]);
+    output[offset[2] + out_idx] = Op()(static_cast<T>(lhs[offset[0] + lidx]), static_cast<T>(rhs[offset[1] + ridx]));
 }
 
 #define make_binary(opname, op, dtype, T, R) \
-template [[host_name(#opname "_" #dtype)]] [[kernel]] decltype(binary<op, T, R>) binary<op, T, R>;
+template [[host_name(#opname "_" #dtype)]] [[kernel]] decltype(binary<op, T, T, T, R>) binary<op, T, T, T, R>;
 
 #define make_cmp(opname, op, dtype, T) \
-template [[host_name(#opname "_" #dtype)]] [[kernel]] decltype(binary<op, T, bool>) binary<op, T, bool>;
-
-#define binary(opname, op)                  \
-make_binary(opname, op, f32, float, float); \
-make_binary(opname, op, i32, int, int);
+template [[host_name(#opname "_" #dtype)]] [[kernel]] decltype(binary<op, T, T, T, bool>) binary<op, T, T, T, bool>;
+
+#define make_mixed_binary(opname, op, ldtype, rdtype, L, R, T) \
+template [[host_name(#opname "_" #ldtype "_" #rdtype)]] [[kernel]] decltype(binary<op, L, R, T, T>) binary<op, L, R, T, T>;
+
+#define make_mixed_cmp(opname, op, ldtype, rdtype, L, R, T) \
+template [[host_name(#opname "_" #ldtype "_" #rdtype)]] [[kernel]] decltype(binary<op, L, R, T, bool>) binary<op, L, R, T, bool>;
+
+// Every ordered pair of distinct numeric dtypes with the dtype both operands are promoted to
+#define promoted_pairs(make, opname, op)           \
+make(opname, op, i8, i16, char, short, short);     \
+make(opname, op, i8, i32, char, int, int);         \
+make(opname, op, i8, i64, char, long, long);       \
+make(opname, op, i8, f16, char, half, float);      \
+make(opname, op, i8, bf16, char, bfloat, float);   \
+make(opname, op, i8, f32, char, float, float);     \
+make(opname, op, i16, i8, short, char, short);     \
+make(opname, op, i16, i32, short, int, int);       \
+make(opname, op, i16, i64, short, long, long);     \
+make(opname, op, i16, f16, short, half, float);    \
+make(opname, op, i16, bf16, short, bfloat, float); \
+make(opname, op, i16, f32, short, float, float);   \
+make(opname, op, i32, i8, int, char, int);         \
+make(opname, op, i32, i16, int, short, int);       \
+make(opname, op, i32, i64, int, long, long);       \
+make(opname, op, i32, f16, int, half, float);      \
+make(opname, op, i32, bf16, int, bfloat, float);   \
+make(opname, op, i32, f32, int, float, float);     \
+make(opname, op, i64, i8, long, char, long);       \
+make(opname, op, i64, i16, long, short, long);     \
+make(opname, op, i64, i32, long, int, long);       \
+make(opname, op, i64, f16, long, half, float);     \
+make(opname, op, i64, bf16, long, bfloat, float);  \
+make(opname, op, i64, f32, long, float, float);    \
+make(opname, op, f16, i8, half, char, float);      \
+make(opname, op, f16, i16, half, short, float);    \
+make(opname, op, f16, i32, half, int, float);      \
+make(opname, op, f16, i64, half, long, float);     \
+make(opname, op, f16, bf16, half, bfloat, float);  \
+make(opname, op, f16, f32, half, float, float);    \
+make(opname, op, bf16, i8, bfloat, char, float);   \
+make(opname, op, bf16, i16, bfloat, short, float); \
+make(opname, op, bf16, i32, bfloat, int, float);   \
+make(opname, op, bf16, i64, bfloat, long, float);  \
+make(opname, op, bf16, f16, bfloat, half, float);  \
+make(opname, op, bf16, f32, bfloat, float, float); \
+make(opname, op, f32, i8, float, char, float);     \
+make(opname, op, f32, i16, float, short, float);   \
+make(opname, op, f32, i32, float, int, float);     \
+make(opname, op, f32, i64, float, long, float);    \
+make(opname, op, f32, f16, float, half, float);    \
+make(opname, op, f32, bf16, float, bfloat, float);
+
+#define binary(opname, op)                      \
+make_binary(opname, op, f32, float, float);     \
+make_binary(opname, op, f16, half, half);       \
+make_binary(opname, op, bf16, bfloat, bfloat);  \
+make_binary(opname, op, i8, char, char);        \
+make_binary(opname, op, i16, short, short);     \
+make_binary(opname, op, i32, int, int);         \
+make_binary(opname, op, i64, long, long);
+
+#define float_binary(opname, op)                \
+make_binary(opname, op, f32, float, float);     \
+make_binary(opname, op, f16, half, half);       \
+make_binary(opname, op, bf16, bfloat, bfloat);
 
 #define numeric_cmp(opname, op)     \
 make_cmp(opname, op, f32, float);   \
-make_cmp(opname, op, i32, int);
+make_cmp(opname, op, f16, half);    \
+make_cmp(opname, op, bf16, bfloat); \
+make_cmp(opname, op, i8, char);     \
+make_cmp(opname, op, i16, short);   \
+make_cmp(opname, op, i32, int);     \
+make_cmp(opname, op, i64, long);
 
 #define cmp_all(opname, op)     \
 numeric_cmp(opname, op);        \
 make_cmp(opname, op, b8, bool);
 
+#define mixed_binary(opname, op) promoted_pairs(make_mixed_binary, opname, op)
+
+#define mixed_cmp(opname, op) promoted_pairs(make_mixed_cmp, opname, op)
+
 binary(add, Add);
 binary(sub, Sub);
 binary(mul, Mul);
@@ -122,3 +208,21 @@ numeric_cmp(lt, Lt);
 numeric_cmp(gt, Gt);
 numeric_cmp(leq, Leq);
 numeric_cmp(geq, Geq);
+mixed_binary(add, Add);
+mixed_binary(sub, Sub);
+mixed_binary(mul, Mul);
+mixed_binary(div, Div);
+mixed_binary(minimum, Minimum);
+mixed_binary(maximum, Maximum);
+mixed_cmp(eq, Eq);
+mixed_cmp(neq, Neq);
+mixed_cmp(lt, Lt);
+mixed_cmp(gt, Gt);
+mixed_cmp(leq, Leq);
+mixed_cmp(geq, Geq);
+make_binary(quantize, Quantize, f32, float, char);
+make_binary(quantize, Quantize, f16, half, char);
+make_binary(quantize, Quantize, bf16, bfloat, char);
+float_binary(relu_grad, ActivationGrad<Relu>);
+float_binary(gelu_grad, ActivationGrad<Gelu>);
+float_binary(silu_grad, ActivationGrad<Silu>);
@@ -0,0 +1,206 @@
+#include "utils.h"
+
+// Shapes of contiguous NCHW operands as seen by the forward convolution
+// in: (N, C, H, W), weight: (O, C / groups, KH, KW), out: (N, O, OH, OW)
+// params: stride, padding and dilation as (height, width) pairs followed by the number of groups
+struct ConvShapes
+{
+    isize N, C, H, W;
+    isize O, CG, KH, KW;
+    isize OH, OW;
+    isize stride_h, stride_w, pad_h, pad_w, dil_h, dil_w;
+    isize OG;
+
+    ConvShapes(const constant isize *in_shape, const constant isize *weight_shape, const constant isize *out_shape, const constant isize *params)
+    {
+        N = in_shape[0];
+        C = in_shape[1];
+        H = in_shape[2];
+        W = in_shape[3];
+        O = weight_shape[0];
+        CG = weight_shape[1];
+        KH = weight_shape[2];
+        KW = weight_shape[3];
+        OH = out_shape[2];
+        OW = out_shape[3];
+        stride_h = params[0];
+        stride_w = params[1];
+        pad_h = params[2];
+        pad_w = params[3];
+        dil_h = params[4];
+        dil_w = params[5];
+        OG = O / params[6];
+    }
+
+    isize in_idx(isize n, isize c, isize h, isize w) const { return ((n * C + c) * H + h) * W + w; }
+    isize weight_idx(isize o, isize c, isize kh, isize kw) const { return ((o * CG + c) * KH + kh) * KW + kw; }
+    isize out_idx(isize n, isize o, isize oh, isize ow) const { return ((n * O + o) * OH + oh) * OW + ow; }
+};
+
+// Direct convolution with one thread per output element
+// Each thread walks the channels of its group and the taps of the window, skipping the padding
+template <class T>
+kernel void conv2d(
+    const constant isize *in_shape [[buffer(0)]],
+    const constant isize *weight_shape [[buffer(1)]],
+    const constant isize *out_shape [[buffer(2)]],
+    const constant isize *params [[buffer(3)]],
+    const constant isize *offset [[buffer(4)]],
+    device T *input [[buffer(5)]],
+    device T *weight [[buffer(6)]],
+    device T *output [[buffer(7)]],
+    uint id [[thread_position_in_grid]])
+{
+    const ConvShapes s(in_shape, weight_shape, out_shape, params);
+    const isize ow = id % s.OW;
+    const isize oh = id / s.OW % s.OH;
+    const isize o = id / (s.OW * s.OH) % s.O;
+    const isize n = id / (s.OW * s.OH * s.O);
+    const isize c_start = o / s.OG * s.CG;
+    float sum = 0.0f;
+
+    for (isize c = 0; c < s.CG; c++) {
+        for (isize kh = 0; kh < s.KH; kh++) {
+            const isize ih = oh * s.stride_h - s.pad_h + kh * s.dil_h;
+            if (ih < 0 || ih >= s.H) {
+                continue;
+            }
+            for (isize kw = 0; kw < s.KW; kw++) {
+                const isize iw = ow * s.stride_w - s.pad_w + kw * s.dil_w;
+                if (iw < 0 || iw >= s.W) {
+                    continue;
+                }
+                sum += static_cast<float>(input[offset[0] + s.in_idx(n, c_start + c, ih, iw)]) * static_cast<float>(weight[offset[1] + s.weight_idx(o, c, kh, kw)]);
+            }
+        }
+    }
+
+    output[offset[2] + id] = static_cast<T>(sum);
+}
+
+// Gradient w.r.t. the input with one thread per input element
+// Gathers the output gradients of every window that read the element instead of scattering them with atomics
+template <class T>
+kernel void conv2d_input_grad(
+    const constant isize *in_shape [[buffer(0)]],
+    const constant isize *weight_shape [[buffer(1)]],
+    const constant isize *out_shape [[buffer(2)]],
+    const constant isize *params [[buffer(3)]],
+    const constant isize *offset [[buffer(4)]],
+    device T *grad [[buffer(5)]],
+    device T *weight [[buffer(6)]],
+    device T *in_grad [[buffer(7)]],
+    uint id [[thread_position_in_grid]])
+{
+    const ConvShapes s(in_shape, weight_shape, out_shape, params);
+    const isize iw = id % s.W;
+    const isize ih = id / s.W % s.H;
+    const isize c = id / (s.W * s.H) % s.C;
+    const isize n = id / (s.W * s.H * s.C);
+    const isize group = c / s.CG;
+    const isize group_c = c - group * s.CG;
+    float sum = 0.0f;
+
+    for (isize o = group * s.OG; o < (group + 1) * s.OG; o++) {
+        for (isize kh = 0; kh < s.KH; kh++) {
+            // The window starting at oh * stride_h - pad_h reads ih through tap kh
+            const isize th = ih + s.pad_h - kh * s.dil_h;
+            if (th < 0 || th % s.stride_h != 0 || th / s.stride_h >= s.OH) {
+                continue;
+            }
+            for (isize kw = 0; kw < s.KW; kw++) {
+                const isize tw = iw + s.pad_w - kw * s.dil_w;
+                if (tw < 0 || tw % s.stride_w != 0 || tw / s.stride_w >= s.OW) {
+                    continue;
+                }
+                sum += static_cast<float>(grad[offset[0] + s.out_idx(n, o, th / s.stride_h, tw / s.stride_w)]) * static_cast<float>(weight[offset[1] + s.weight_idx(o, group_c, kh, kw)]);
+            }
+        }
+    }
+
+    in_grad[offset[2] + id] = static_cast<T>(sum);
+}
+
+// Gradient w.r.t. the weight with one threadgroup per weight element
+// The threads of a group stride over the batch and the output positions, so neighbouring threads read neighbouring
+// gradients, and their partial sums are reduced in threadgroup memory
+template <class T>
+kernel void conv2d_weight_grad(
+    const constant isize *in_shape [[buffer(0)]],
+    const constant isize *weight_shape [[buffer(1)]],
+    const constant isize *out_shape [[buffer(2)]],
+    const constant isize *params [[buffer(3)]],
+    const constant isize *offset [[buffer(4)]],
+    device T *input [[buffer(5)]],
+    device T *grad [[buffer(6)]],
+    device T *weight_grad [[buffer(7)]],
+    uint id [[threadgroup_position_in_grid]],
+    uint lid [[thread_position_in_threadgroup]],
+    uint lsize [[threads_per_threadgroup]],
+    uint simd_size [[threads_per_simdgroup]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]])
+{
+    threadgroup float ldata[max_simd_groups];
+    const ConvShapes s(in_shape, weight_shape, out_shape, params);
+    const isize kw = id % s.KW;
+    const isize kh = id / s.KW % s.KH;
+    const isize group_c = id / (s.KW * s.KH) % s.CG;
+    const isize o = id / (s.KW * s.KH * s.CG);
+    const isize c = o / s.OG * s.CG + group_c;
+    float sum = 0.0f;
+
+    for (isize pos = lid; pos < s.N * s.OH * s.OW; pos += lsize) {
+        const isize ow = pos % s.OW;
+        const isize oh = pos / s.OW % s.OH;
+        const isize n = pos / (s.OW * s.OH);
+        const isize ih = oh * s.stride_h - s.pad_h + kh * s.dil_h;
+        const isize iw = ow * s.stride_w - s.pad_w + kw * s.dil_w;
+        if (ih < 0 || ih >= s.H || iw < 0 || iw >= s.W) {
+            continue;
+        }
+        sum += static_cast<float>(grad[offset[1] + s.out_idx(n, o, oh, ow)]) * static_cast<float>(input[offset[0] + s.in_idx(n, c, ih, iw)]);
+    }
+
+    sum = threadgroup_sum(sum, ldata, lsize, simd_size, simd_lane_id, simd_group_id);
+    if (lid == 0) {
+        weight_grad[offset[2] + id] = static_cast<T>(sum);
+    }
+}
+
+// Unfolds the windows of the input into the columns of a (N, C * KH * KW, OH * OW) array with one thread per element
+// The convolution then becomes a matmul of the (O, C * KH * KW) weight with the columns of every example
+// Taps falling in the padding are written as zeros
+template <class T>
+kernel void conv2d_im2col(
+    const constant isize *in_shape [[buffer(0)]],
+    const constant isize *weight_shape [[buffer(1)]],
+    const constant isize *out_shape [[buffer(2)]],
+    const constant isize *params [[buffer(3)]],
+    const constant isize *offset [[buffer(4)]],
+    device T *input [[buffer(5)]],
+    device T *cols [[buffer(6)]],
+    uint id [[thread_position_in_grid]])
+{
+    const ConvShapes s(in_shape, weight_shape, out_shape, params);
+    const isize ow = id % s.OW;
+    const isize oh = id / s.OW % s.OH;
+    const isize kw = id / (s.OW * s.OH) % s.KW;
+    const isize kh = id / (s.OW * s.OH * s.KW) % s.KH;
+    const isize c = id / (s.OW * s.OH * s.KW * s.KH) % s.C;
+    const isize n = id / (s.OW * s.OH * s.KW * s.KH * s.C);
+    const isize ih = oh * s.stride_h - s.pad_h + kh * s.dil_h;
+    const isize iw = ow * s.stride_w - s.pad_w + kw * s.dil_w;
+    const bool inside = ih >= 0 && ih < s.H && iw >= 0 && iw < s.W;
+    cols[offset[1] + id] = inside ? input[offset[0] + s.in_idx(n, c, ih, iw)] : static_cast<T>(0);
+}
+
+#define make_conv2d(dtype, T) \
+template [[host_name("conv2d_" #dtype)]] [[kernel]] decltype(conv2d<T>) conv2d<T>; \
+template [[host_name("conv2d_in_grad_" #dtype)]] [[kernel]] decltype(conv2d_input_grad<T>) conv2d_input_grad<T>; \
+template [[host_name("conv2d_w_grad_" #dtype)]] [[kernel]] decltype(conv2d_weight_grad<T>) conv2d_weight_grad<T>; \
+template [[host_name("conv2d_im2col_" #dtype)]] [[kernel]] decltype(conv2d_im2col<T>) conv2d_im2col<T>;
+
+make_conv2d(f32, float);
+make_conv2d(f16, half);
+make_conv2d(bf16, bfloat);
@@ -14,18 +14,76 @@ kernel void copy(
 {
     isize in_idx = strided[0] ? strided_idx(id, ndim, shape, instride) : id;
     isize out_idx = strided[1] ? strided_idx(id, ndim, shape, outstride) : id;
-    output[offset[1] + out_idx] = input[offset[0] + in_idx];
+    output[offset[1] + out_idx] = static_cast<R>(input[offset[0] + in_idx]);
+}
+
+constant constexpr uint transpose_tile = 32;
+constant constexpr uint transpose_rows = 8;
+
+// Copies a batch of transposed matrices into a contiguous output through threadgroup tiles
+// Row r of a matrix is contiguous in the input while column c is contiguous in the output
+// Each threadgroup reads a tile along r and writes it back along c so that both sides coalesce
+template <class T, class R>
+kernel void copy_transpose(
+    const constant isize &batch_ndim [[buffer(0)]],
+    const constant isize *offset [[buffer(1)]],
+    const constant isize *batch_shape [[buffer(2)]],
+    const constant isize *batch_instride [[buffer(3)]],
+    const constant isize *batch_outstride [[buffer(4)]],
+    // Number of rows and columns, followed by the input stride of a column and the output stride of a row
+    const constant isize *matrix [[buffer(5)]],
+    device T *input [[buffer(6)]],
+    device R *output [[buffer(7)]],
+    uint3 gid [[threadgroup_position_in_grid]],
+    uint3 tid [[thread_position_in_threadgroup]])
+{
+    threadgroup T tile[transpose_tile][transpose_tile + 1];
+    const isize nrow = matrix[0];
+    const isize ncol = matrix[1];
+    const isize in_base = offset[0] + strided_idx(gid.z, batch_ndim, batch_shape, batch_instride);
+    const isize out_base = offset[1] + strided_idx(gid.z, batch_ndim, batch_shape, batch_outstride);
+    const isize row0 = gid.y * transpose_tile;
+    const isize col0 = gid.x * transpose_tile;
+
+    for (uint i = tid.y; i < transpose_tile; i += transpose_rows) {
+        const isize r = row0 + tid.x;
+        const isize c = col0 + i;
+        if (r < nrow && c < ncol) {
+            tile[i][tid.x] = input[in_base + r + c * matrix[2]];
+        }
+    }
+
+    threadgroup_barrier(metal::mem_flags::mem_threadgroup);
+
+    for (uint i = tid.y; i < transpose_tile; i += transpose_rows) {
+        const isize r = row0 + i;
+        const isize c = col0 + tid.x;
+        if (r < nrow && c < ncol) {
+            output[out_base + r * matrix[3] + c] = static_cast<R>(tile[tid.x][i]);
+        }
+    }
 }
 
 #define make_copy(dtype, T, R) \
-template [[host_name("copy_" #dtype)]] [[kernel]] decltype(copy<T, R>) copy<T, R>;
-
-make_copy(f32_f32, float, float);
-make_copy(f32_i32, float, int);
-make_copy(f32_b8, float, bool);
-make_copy(i32_f32, int, float);
-make_copy(i32_i32, int, int);
-make_copy(i32_b8, int, bool);
-make_copy(b8_f32, bool, float);
-make_copy(b8_i32, bool, int);
-make_copy(b8_b8, bool, bool);
\ No newline at end of file
+template [[host_name("copy_" #dtype)]] [[kernel]] decltype(copy<T, R>) copy<T, R>; \
+template [[host_name("copy_transpose_" #dtype)]] [[kernel]] decltype(copy_transpose<T, R>) copy_transpose<T, R>;
+
+#define copy_from(dtype, T)                 \
+make_copy(dtype##_f32, T, float);       \
+make_copy(dtype##_f16, T, half);        \
+make_copy(dtype##_bf16, T, bfloat);     \
+make_copy(dtype##_i8, T, char);         \
+make_copy(dtype##_i16, T, short);       \
+make_copy(dtype##_i32, T, int);         \
+make_copy(dtype##_i64, T, long);        \
+make_copy(dtype##_b8, T, bool);
+
+// Copies from and to f64 are done by the host since Metal has no double
+copy_from(f32, float);
+copy_from(f16, half);
+copy_from(bf16, bfloat);
+copy_from(i8, char);
+copy_from(i16, short);
+copy_from(i32, int);
+copy_from(i64, long);
+copy_from(b8, bool);
\ No newline at end of file
@@ -0,0 +1,77 @@
+#include "utils.h"
+
+struct MaximumGrad
+{
+    template <class T>
+    T operator()(T first, T second, T grad) { return first >= second ? grad : T(0); }
+};
+
+struct MinimumGrad
+{
+    template <class T>
+    T operator()(T first, T second, T grad) { return first <= second ? grad : T(0); }
+};
+
+template <class Op, class T>
+kernel void ternary(
+    const constant isize &ndim [[buffer(0)]],
+    const constant isize *offset [[buffer(1)]],
+    const constant isize *shape [[buffer(2)]],
+    const constant isize *first_stride [[buffer(3)]],
+    const constant isize *second_stride [[buffer(4)]],
+    const constant isize *third_stride [[buffer(5)]],
+    const constant isize *outstride [[buffer(6)]],
+    const constant bool *strided [[buffer(7)]],
+    device T *first [[buffer(8)]],
+    device T *second [[buffer(9)]],
+    device T *third [[buffer(10)]],
+    device T *output [[buffer(11)]],
+    uint id [[thread_position_in_grid]])
+{
+    isize first_idx = strided[0] ? strided_idx(id, ndim, shape, first_stride) : id;
+    isize second_idx = strided[1] ? strided_idx(id, ndim, shape, second_stride) : id;
+    isize third_idx = strided[2] ? strided_idx(id, ndim, shape, third_stride) : id;
+    isize out_idx = strided[3] ? strided_idx(id, ndim, shape, outstride) : id;
+    output[offset[3] + out_idx] = Op()(first[offset[0] + first_idx], second[offset[1] + second_idx], third[offset[2] + third_idx]);
+}
+
+// Scatters one gradient value per row to the column selected by the saved index
+// The indices and gradients are contiguous and the output is freshly allocated
+template <class T>
+kernel void index_grad(
+    const constant isize &ncol [[buffer(0)]],
+    const constant isize *offset [[buffer(1)]],
+    device int *idx [[buffer(2)]],
+    device T *grad [[buffer(3)]],
+    device T *output [[buffer(4)]],
+    uint id [[thread_position_in_grid]])
+{
+    const isize row = id / ncol;
+    const isize col = id % ncol;
+    output[offset[2] + id] = col == idx[offset[0] + row] ? grad[offset[1] + row] : T(0);
+}
+
+#define make_ternary(opname, op, dtype, T) \
+template [[host_name(#opname "_" #dtype)]] [[kernel]] decltype(ternary<op, T>) ternary<op, T>;
+
+#define ternary(opname, op)              \
+make_ternary(opname, op, f32, float);    \
+make_ternary(opname, op, f16, half);     \
+make_ternary(opname, op, bf16, bfloat);  \
+make_ternary(opname, op, i8, char);      \
+make_ternary(opname, op, i16, short);    \
+make_ternary(opname, op, i32, int);      \
+make_ternary(opname, op, i64, long);
+
+#define make_index_grad(dtype, T) \
+template [[host_name("index_grad_" #dtype)]] [[kernel]] decltype(index_grad<T>) index_grad<T>;
+
+ternary(maximum_grad, MaximumGrad);
+ternary(minimum_grad, MinimumGrad);
+make_index_grad(f32, float);
+make_index_grad(f16, half);
+make_index_grad(bf16, bfloat);
+make_index_grad(i8, char);
+make_index_grad(i16, short);
+make_index_grad(i32, int);
+make_index_grad(i64, long);
@@ -16,7 +16,7 @@ kernel void arange(
     device T *output [[buffer(2)]],
     uint id [[thread_position_in_grid]])
 {
-    output[id] = *start + static_cast<int>(id) * *step;
+    output[id] = static_cast<T>(*start + static_cast<int>(id) * *step);
 }
 
 #define make_initializer(opname, op, dtype, T) \
@@ -24,11 +24,18 @@ template [[host_name(#opname "_" #dtype)]] [[kernel]] decltype(op<T>) op<T>;
 
 #define initializer_numeric(opname, op)     \
 make_initializer(opname, op, f32, float);   \
+make_initializer(opname, op, f16, half);    \
+make_initializer(opname, op, bf16, bfloat); \
+make_initializer(opname, op, i8, char);     \
+make_initializer(opname, op, i16, short);   \
 make_initializer(opname, op, i32, int);     \
+make_initializer(opname, op, i64, long);    \
 
 #define initializer_all(opname, op)     \
 initializer_numeric(opname, op);        \
 make_initializer(opname, op, b8, bool);
 
 initializer_all(full, full);
-initializer_numeric(arange, arange);
\ No newline at end of file
+initializer_numeric(arange, arange);
+// Metal has no double so f64 arrays are filled with the bits of the value
+make_initializer(full, full, f64, ulong);
\ No newline at end of file
@@ -0,0 +1,69 @@
+#include "utils.h"
+
+// Each thread packs the 32 booleans of one word, bit i of word w holding element 32 * w + i
+kernel void pack_mask(
+    const constant isize &numel [[buffer(0)]],
+    const constant isize &ndim [[buffer(1)]],
+    const constant isize *offset [[buffer(2)]],
+    const constant isize *shape [[buffer(3)]],
+    const constant isize *stride [[buffer(4)]],
+    const constant bool &strided [[buffer(5)]],
+    device bool *input [[buffer(6)]],
+    device uint *output [[buffer(7)]],
+    uint id [[thread_position_in_grid]])
+{
+    const isize start = static_cast<isize>(id) * 32;
+    const uint nbits = static_cast<uint>(metal::min(numel - start, static_cast<isize>(32)));
+    uint word = 0;
+    for (uint bit = 0; bit < nbits; bit++) {
+        isize idx = start + bit;
+        idx = strided ? strided_idx(static_cast<uint>(idx), ndim, shape, stride) : idx;
+        word |= static_cast<uint>(input[offset[0] + idx]) << bit;
+    }
+    output[offset[1] + id] = word;
+}
+
+// Sums the popcounts of the words within each SIMD group before touching the counter
+kernel void count_mask(
+    const constant isize *offset [[buffer(0)]],
+    device uint *input [[buffer(1)]],
+    volatile device metal::atomic_uint *output [[buffer(2)]],
+    uint id [[thread_position_in_grid]],
+    uint simd_lane_id [[thread_index_in_simdgroup]])
+{
+    uint count = metal::simd_sum(metal::popcount(input[offset[0] + id]));
+    if (simd_lane_id == 0) {
+        metal::atomic_fetch_add_explicit(output + offset[1], count, metal::memory_order_relaxed);
+    }
+}
+
+// Reads the mask bit of every element instead of a byte per element
+template <class T>
+kernel void mask_mul(
+    const constant isize &ndim [[buffer(0)]],
+    const constant isize *offset [[buffer(1)]],
+    const constant isize *shape [[buffer(2)]],
+    const constant isize *lstride [[buffer(3)]],
+    const constant isize *outstride [[buffer(4)]],
+    const constant bool *strided [[buffer(5)]],
+    device T *lhs [[buffer(6)]],
+    device uint *mask [[buffer(7)]],
+    device T *output [[buffer(8)]],
+    uint id [[thread_position_in_grid]])
+{
+    isize lidx = strided[0] ? strided_idx(id, ndim, shape, lstride) : id;
+    isize out_idx = strided[1] ? strided_idx(id, ndim, shape, outstride) : id;
+    bool bit = (mask[offset[1] + id / 32] >> (id % 32)) & 1;
+    output[offset[2] + out_idx] = bit ? lhs[offset[0] + lidx] : static_cast<T>(0);
+}
+
+#define make_mask_mul(dtype, T) \
+template [[host_name("mask_mul_" #dtype)]] [[kernel]] decltype(mask_mul<T>) mask_mul<T>;
+
+make_mask_mul(f32, float);
+make_mask_mul(f16, half);
+make_mask_mul(bf16, bfloat);
+make_mask_mul(i8, char);
+make_mask_mul(i16, short);
+make_mask_mul(i32, int);
+make_mask_mul(i64, long);
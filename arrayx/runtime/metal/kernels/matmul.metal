@@ -1,6 +1,7 @@
-#include "utils.h"
+#include "activation.h"
 
-template <class T, class R>
+// A is the type the dot products are accumulated in
+template <class T, class A>
 kernel void matmul(
     const constant isize &ndim [[buffer(0)]],
     const constant isize *offset [[buffer(1)]],
@@ -11,7 +12,7 @@ kernel void matmul(
     const constant bool *strided [[buffer(6)]],
     device T *lhs [[buffer(7)]],
     device T *rhs [[buffer(8)]],
-    device R *output [[buffer(9)]],
+    device T *output [[buffer(9)]],
     uint3 id [[thread_position_in_grid]])
 {
     const uint batch = id.z;
@@ -27,22 +28,122 @@ kernel void matmul(
         // Calculate output index
         // [batch, row, col] -> batch * (M * N) + row * N + col
         const isize out_idx = offset[2] + batch * M * N + row * N + col;
-        R sum = 0;
+        A sum = 0;
         
         for (isize i = 0; i < K; i++) {
             // [batch, row, k] -> batch * (M * K) + row * K + k
             const isize lidx = offset[0] + (strided[0] ? strided_idx(batch * M * K + row * K + i, ndim, lshape, lstride) : batch * M * K + row * K + i);
             // [batch, k, col] -> batch * (K * N) + k * N + col
             const isize ridx = offset[1] + (strided[1] ? strided_idx(batch * K * N + N * i + col, ndim, rshape, rstride) : batch * K * N + N * i + col);
-            sum += lhs[lidx] * rhs[ridx];
+            sum += static_cast<A>(lhs[lidx]) * static_cast<A>(rhs[ridx]);
         }
         
-        output[out_idx] = sum;
+        output[out_idx] = static_cast<T>(sum);
     }
 }
 
-#define make_matmul(dtype, T, R) \
-template [[host_name("matmul_" #dtype)]] [[kernel]] decltype(matmul<T, R>) matmul<T, R>;
+#define make_matmul(dtype, T, A) \
+template [[host_name("matmul_" #dtype)]] [[kernel]] decltype(matmul<T, A>) matmul<T, A>;
 
 make_matmul(f32, float, float);
-make_matmul(i32, int, int);
\ No newline at end of file
+make_matmul(f16, half, float);
+make_matmul(bf16, bfloat, float);
+make_matmul(i8, char, int);
+make_matmul(i16, short, int);
+make_matmul(i32, int, int);
+make_matmul(i64, long, long);
+
+// Multiplies i8 matrices with int accumulation, which is exact for K below 2^31 / 127^2
+// Each dot product is scaled once in the epilogue and stored as T
+template <class T>
+kernel void qmatmul(
+    const constant isize &ndim [[buffer(0)]],
+    const constant isize *offset [[buffer(1)]],
+    const constant isize *lshape [[buffer(2)]],
+    const constant isize *rshape [[buffer(3)]],
+    const constant isize *outshape [[buffer(4)]],
+    const constant isize *lstride [[buffer(5)]],
+    const constant isize *rstride [[buffer(6)]],
+    const constant isize *scale_stride [[buffer(7)]],
+    const constant bool *strided [[buffer(8)]],
+    device char *lhs [[buffer(9)]],
+    device char *rhs [[buffer(10)]],
+    device T *scale [[buffer(11)]],
+    device T *output [[buffer(12)]],
+    uint3 id [[thread_position_in_grid]])
+{
+    const uint batch = id.z;
+    const uint row = id.y;
+    const uint col = id.x;
+    const isize B = lshape[0];
+    const isize M = lshape[1];
+    const isize N = rshape[2];
+    const isize K = lshape[2];
+
+    if (col < N && row < M && batch < B) {
+        const isize idx = batch * M * N + row * N + col;
+        int sum = 0;
+
+        for (isize i = 0; i < K; i++) {
+            const isize lidx = offset[0] + (strided[0] ? strided_idx(batch * M * K + row * K + i, ndim, lshape, lstride) : batch * M * K + row * K + i);
+            const isize ridx = offset[1] + (strided[1] ? strided_idx(batch * K * N + N * i + col, ndim, rshape, rstride) : batch * K * N + N * i + col);
+            sum += static_cast<int>(lhs[lidx]) * static_cast<int>(rhs[ridx]);
+        }
+
+        // Scales are usually broadcasted from one per output channel
+        const isize scale_idx = offset[2] + (strided[2] ? strided_idx(idx, ndim, outshape, scale_stride) : idx);
+        output[offset[3] + idx] = static_cast<T>(static_cast<float>(sum) * static_cast<float>(scale[scale_idx]));
+    }
+}
+
+#define make_qmatmul(dtype, T) \
+template [[host_name("qmatmul_" #dtype)]] [[kernel]] decltype(qmatmul<T>) qmatmul<T>;
+
+make_qmatmul(f32, float);
+make_qmatmul(f16, half);
+make_qmatmul(bf16, bfloat);
+
+// One thread per output element of a contiguous (M, N) result with the weight read along its rows,
+// so the transposed weight is never materialized
+// Bias and activation are applied to the accumulator before the only store of the element
+template <class T, class Act>
+kernel void linear(
+    const constant isize *dims [[buffer(0)]],
+    const constant isize *offset [[buffer(1)]],
+    device T *input [[buffer(2)]],
+    device T *weight [[buffer(3)]],
+    device T *bias [[buffer(4)]],
+    device T *output [[buffer(5)]],
+    uint2 id [[thread_position_in_grid]])
+{
+    const uint row = id.y;
+    const uint col = id.x;
+    const isize M = dims[0];
+    const isize N = dims[1];
+    const isize K = dims[2];
+
+    if (col < N && row < M) {
+        const device T *in_row = input + offset[0] + row * K;
+        const device T *weight_row = weight + offset[1] + col * K;
+        float sum = 0.0f;
+
+        for (isize i = 0; i < K; i++) {
+            sum += static_cast<float>(in_row[i]) * static_cast<float>(weight_row[i]);
+        }
+
+        output[offset[3] + row * N + col] = static_cast<T>(Act()(sum + static_cast<float>(bias[offset[2] + col])));
+    }
+}
+
+#define make_linear(act, Act, dtype, T) \
+template [[host_name("linear_" #act "_" #dtype)]] [[kernel]] decltype(linear<T, Act>) linear<T, Act>;
+
+#define linear_float(act, Act)              \
+make_linear(act, Act, f32, float);          \
+make_linear(act, Act, f16, half);           \
+make_linear(act, Act, bf16, bfloat);
+
+linear_float(none, Identity);
+linear_float(relu, Relu);
+linear_float(gelu, Gelu);
+linear_float(silu, Silu);
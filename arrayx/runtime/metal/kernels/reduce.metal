@@ -1,4 +1,4 @@
-#include "utils.h"
+#include "atomic.h"
 
 struct Sum
 {
@@ -27,73 +27,8 @@ struct Min
     T get_default() { return Limits<T>::max(); }
 };
 
-struct AtomicSum
-{
-    template <class T, class R>
-    void operator()(volatile device metal::_atomic<R> *output, T val)
-    {
-        // memory_order_relaxed guarantees atomicity without ordering or proper synchronization
-        // since we're doing addition, this is somewhat similar to a counter
-        // atomic_fetch_add_explicit runs output += val but atomically
-        metal::atomic_fetch_add_explicit(output, val, metal::memory_order_relaxed);
-    }
-};
-
-struct AtomicMaxInt {
-    template <class T, class R>
-    void operator()(volatile device metal::_atomic<R> *output, T new_val)
-    {
-        metal::atomic_fetch_max_explicit(output, new_val, metal::memory_order_relaxed);
-    }
-};
-
-struct AtomicMaxFloat
-{
-    template <class T, class R>
-    void operator()(volatile device metal::_atomic<R> *output, T new_val)
-    {
-        // CAS algorithm
-        // output = max(output, val)
-        // Be cautious when T and R are not the same
-        R old_val = metal::atomic_load_explicit(output, metal::memory_order_relaxed);
-        do {
-            if (old_val >= new_val) {
-                break;
-            }
-        // old_val gets updated by metal::atomic_compare_exchange_weak_explicit if the operation fails
-        // No need for old_val to be in the while loop
-        } while (!metal::atomic_compare_exchange_weak_explicit(output, &old_val, new_val, metal::memory_order_relaxed, metal::memory_order_relaxed));
-    }
-};
-
-struct AtomicMinInt {
-    template <class T, class R>
-    void operator()(volatile device metal::_atomic<R> *output, T new_val)
-    {
-        metal::atomic_fetch_min_explicit(output, new_val, metal::memory_order_relaxed);
-    }
-};
-
-struct AtomicMinFloat
-{
-    template <class T, class R>
-    void operator()(volatile device metal::_atomic<R> *output, T new_val)
-    {
-        // CAS algorithm
-        // output = min(output, val)
-        // Be cautious when T and R are not the same
-        R old_val = metal::atomic_load_explicit(output, metal::memory_order_relaxed);
-        do {
-            if (old_val <= new_val) {
-                break;
-            }
-        // old_val gets updated by metal::atomic_compare_exchange_weak_explicit if the operation fails
-        // No need for old_val to be in the while loop
-        } while (!metal::atomic_compare_exchange_weak_explicit(output, &old_val, new_val, metal::memory_order_relaxed, metal::memory_order_relaxed));
-    }
-};
-
-template <class Op, class AtomicOp, class T, class R>
+// A is the atomic type the output is updated through
+template <class Op, class AtomicOp, class T, class R, class A>
 kernel void reduce_all(
     const constant isize &numel [[buffer(0)]],
     const constant isize &ndim [[buffer(1)]],
@@ -102,7 +37,7 @@ kernel void reduce_all(
     const constant isize *stride [[buffer(4)]],
     const constant bool *strided [[buffer(5)]],
     const device T *input [[buffer(6)]],
-    device metal::_atomic<R> *output [[buffer(7)]],
+    device A *output [[buffer(7)]],
     threadgroup R *ldata [[threadgroup(0)]],
     uint gid [[thread_position_in_grid]],
     uint lid [[thread_position_in_threadgroup]],
@@ -117,7 +52,7 @@ kernel void reduce_all(
     Op op;
     R default_val = op.template get_default<R>();
     isize idx = *strided ? strided_idx(gid, ndim, shape, stride) : gid;
-    T val = input[offset[0] + idx];
+    R val = static_cast<R>(input[offset[0] + idx]);
     
     for (uint s = (lsize + simd_size - 1) / simd_size; s > 1; s /= simd_size)
     {
@@ -149,11 +84,11 @@ kernel void reduce_all(
     
     // Atomically update the reduction result.
     if (lid == 0) {
-        AtomicOp()(output + offset[1], val);
+        AtomicOp()(output, offset[1], val);
     }
 }
 
-template <class Op, class AtomicOp, class T, class R>
+template <class Op, class AtomicOp, class T, class R, class A>
 kernel void reduce_col(
     const constant isize &ndim [[buffer(0)]],
     const constant isize *offset [[buffer(1)]],
@@ -161,7 +96,7 @@ kernel void reduce_col(
     const constant isize *stride [[buffer(3)]],
     const constant bool *strided [[buffer(4)]],
     const device T *input [[buffer(5)]],
-    device metal::_atomic<R> *output [[buffer(6)]],
+    device A *output [[buffer(6)]],
     threadgroup R *ldata [[threadgroup(0)]],
     uint2 gid [[thread_position_in_grid]],
     uint2 lid [[thread_position_in_threadgroup]],
@@ -178,7 +113,7 @@ kernel void reduce_col(
     Op op;
     R default_val = op.template get_default<R>();
     isize idx = *strided ? strided_idx(grow * N + gcol, ndim, shape, stride) : grow * N + gcol;
-    T val = gcol < N ? input[offset[0] + idx] : default_val;
+    R val = gcol < N ? static_cast<R>(input[offset[0] + idx]) : default_val;
     
     for (uint s = (lwidth + simd_size - 1) / simd_size; s > 1; s /= simd_size)
     {
@@ -203,18 +138,28 @@ kernel void reduce_col(
     }
     
     if (lcol == 0) {
-        AtomicOp()(output + offset[1] + grow, val);
+        AtomicOp()(output, offset[1] + grow, val);
     }
 }
 
+#define make_atomic_reduce(opname, op, atomic_op, dtype, T, R, A) \
+template [[host_name(#opname "_all_" #dtype)]] [[kernel]] decltype(reduce_all<op, atomic_op, T, R, A>) reduce_all<op, atomic_op, T, R, A>;    \
+template [[host_name(#opname "_col_" #dtype)]] [[kernel]] decltype(reduce_col<op, atomic_op, T, R, A>) reduce_col<op, atomic_op, T, R, A>;
+
 #define make_reduce(opname, op, atomic_op, dtype, T, R) \
-template [[host_name(#opname "_all_" #dtype)]] [[kernel]] decltype(reduce_all<op, atomic_op, T, R>) reduce_all<op, atomic_op, T, R>;    \
-template [[host_name(#opname "_col_" #dtype)]] [[kernel]] decltype(reduce_col<op, atomic_op, T, R>) reduce_col<op, atomic_op, T, R>;
+make_atomic_reduce(opname, op, atomic_op, dtype, T, R, metal::_atomic<R>)
 
+// Metal has no 8 or 16-bit atomics so narrow types are reduced into 32-bit outputs
 #define reduce(opname, op, atomic_op_float, atomic_op_int)      \
 make_reduce(opname, op, atomic_op_float, f32, float, float);    \
+make_reduce(opname, op, atomic_op_float, f16, half, float);     \
+make_reduce(opname, op, atomic_op_float, bf16, bfloat, float);  \
+make_reduce(opname, op, atomic_op_int, i8, char, int);          \
+make_reduce(opname, op, atomic_op_int, i16, short, int);        \
 make_reduce(opname, op, atomic_op_int, i32, int, int);
 
 reduce(sum, Sum, AtomicSum, AtomicSum);
 reduce(max, Max, AtomicMaxFloat, AtomicMaxInt);
-reduce(min, Min, AtomicMinFloat, AtomicMinInt);
\ No newline at end of file
+reduce(min, Min, AtomicMinFloat, AtomicMinInt);
+// i64 maxima and minima are gathered through their indices instead
+make_atomic_reduce(sum, Sum, AtomicSumLong, i64, long, long, metal::_atomic<uint>);
\ No newline at end of file
@@ -0,0 +1,233 @@
+#include "utils.h"
+
+// Running max of a row along with the sum of exponentials rescaled to that max
+struct OnlineStats
+{
+    float max;
+    float sum;
+};
+
+// Merges the statistics of two parts of a row by rescaling both sums to the larger max
+inline OnlineStats merge(OnlineStats lhs, OnlineStats rhs)
+{
+    float max = metal::max(lhs.max, rhs.max);
+    if (max == -INFINITY) {
+        // Both parts are empty or only hold -inf
+        return {max, 0.0f};
+    }
+    return {max, lhs.sum * metal::exp(lhs.max - max) + rhs.sum * metal::exp(rhs.max - max)};
+}
+
+inline OnlineStats simd_merge(OnlineStats stats, uint simd_size)
+{
+    for (uint lanes = simd_size / 2; lanes > 0; lanes /= 2) {
+        OnlineStats other = {metal::simd_shuffle_down(stats.max, lanes), metal::simd_shuffle_down(stats.sum, lanes)};
+        stats = merge(stats, other);
+    }
+    return stats;
+}
+
+// Scans the row once and returns the statistics of the whole row to every thread of the threadgroup
+template <class T>
+OnlineStats row_stats(
+    const device T *row,
+    isize ncol,
+    threadgroup OnlineStats *ldata,
+    uint lid,
+    uint lsize,
+    uint simd_size,
+    uint simd_lane_id,
+    uint simd_group_id)
+{
+    OnlineStats stats = {-INFINITY, 0.0f};
+    for (isize j = lid; j < ncol; j += lsize) {
+        stats = merge(stats, {static_cast<float>(row[j]), 1.0f});
+    }
+    stats = simd_merge(stats, simd_size);
+    if (simd_lane_id == 0) {
+        ldata[simd_group_id] = stats;
+    }
+    threadgroup_barrier(metal::mem_flags::mem_threadgroup);
+    if (simd_group_id == 0) {
+        uint nsimd = (lsize + simd_size - 1) / simd_size;
+        stats = simd_lane_id < nsimd ? ldata[simd_lane_id] : OnlineStats{-INFINITY, 0.0f};
+        stats = simd_merge(stats, simd_size);
+        if (simd_lane_id == 0) {
+            ldata[0] = stats;
+        }
+    }
+    threadgroup_barrier(metal::mem_flags::mem_threadgroup);
+    return ldata[0];
+}
+
+// Writes the row from its statistics, out holding the whole row or a single element for reductions
+struct Softmax
+{
+    template <class T>
+    void operator()(const device T *row, device T *out, isize ncol, uint lid, uint lsize, OnlineStats stats)
+    {
+        for (isize j = lid; j < ncol; j += lsize) {
+            out[j] = static_cast<T>(metal::exp(static_cast<float>(row[j]) - stats.max) / stats.sum);
+        }
+    }
+};
+
+struct LogSoftmax
+{
+    template <class T>
+    void operator()(const device T *row, device T *out, isize ncol, uint lid, uint lsize, OnlineStats stats)
+    {
+        float lse = stats.max + metal::log(stats.sum);
+        for (isize j = lid; j < ncol; j += lsize) {
+            out[j] = static_cast<T>(static_cast<float>(row[j]) - lse);
+        }
+    }
+};
+
+struct Logsumexp
+{
+    template <class T>
+    void operator()(const device T *row, device T *out, isize ncol, uint lid, uint lsize, OnlineStats stats)
+    {
+        if (lid == 0) {
+            *out = static_cast<T>(stats.max + metal::log(stats.sum));
+        }
+    }
+};
+
+// One threadgroup per row of a contiguous input, nout being the number of output elements per row
+template <class Op, class T, uint nout>
+kernel void softmax(
+    const constant isize &ncol [[buffer(0)]],
+    const constant isize *offset [[buffer(1)]],
+    const device T *input [[buffer(2)]],
+    device T *output [[buffer(3)]],
+    uint row [[threadgroup_position_in_grid]],
+    uint lid [[thread_position_in_threadgroup]],
+    uint lsize [[threads_per_threadgroup]],
+    uint simd_size [[threads_per_simdgroup]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]])
+{
+    threadgroup OnlineStats ldata[max_simd_groups];
+    const device T *in_row = input + offset[0] + row * ncol;
+    device T *out_row = output + offset[1] + row * (nout == 0 ? ncol : nout);
+    OnlineStats stats = row_stats(in_row, ncol, ldata, lid, lsize, simd_size, simd_lane_id, simd_group_id);
+    Op()(in_row, out_row, ncol, lid, lsize, stats);
+}
+
+struct SoftmaxGrad
+{
+    // Summed over the row
+    template <class T>
+    float partial(T out, T grad) { return static_cast<float>(out) * static_cast<float>(grad); }
+
+    template <class T>
+    T operator()(T out, T grad, float total) { return static_cast<T>(static_cast<float>(out) * (static_cast<float>(grad) - total)); }
+};
+
+struct LogSoftmaxGrad
+{
+    template <class T>
+    float partial(T out, T grad) { return static_cast<float>(grad); }
+
+    template <class T>
+    T operator()(T out, T grad, float total) { return static_cast<T>(static_cast<float>(grad) - metal::exp(static_cast<float>(out)) * total); }
+};
+
+// Gradients w.r.t. the input of softmax and log-softmax from their outputs and output gradients
+template <class Op, class T>
+kernel void softmax_grad(
+    const constant isize &ncol [[buffer(0)]],
+    const constant isize *offset [[buffer(1)]],
+    const device T *output [[buffer(2)]],
+    const device T *grad [[buffer(3)]],
+    device T *in_grad [[buffer(4)]],
+    uint row [[threadgroup_position_in_grid]],
+    uint lid [[thread_position_in_threadgroup]],
+    uint lsize [[threads_per_threadgroup]],
+    uint simd_size [[threads_per_simdgroup]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]])
+{
+    threadgroup float ldata[max_simd_groups];
+    const device T *out_row = output + offset[0] + row * ncol;
+    const device T *grad_row = grad + offset[1] + row * ncol;
+    device T *in_grad_row = in_grad + offset[2] + row * ncol;
+    Op op;
+    float total = 0.0f;
+    for (isize j = lid; j < ncol; j += lsize) {
+        total += op.partial(out_row[j], grad_row[j]);
+    }
+    total = threadgroup_sum(total, ldata, lsize, simd_size, simd_lane_id, simd_group_id);
+    for (isize j = lid; j < ncol; j += lsize) {
+        in_grad_row[j] = op(out_row[j], grad_row[j], total);
+    }
+}
+
+// Loss of each row of logits against its label, the target logit being read while the row is scanned
+template <class T>
+kernel void cross_entropy(
+    const constant isize &ncol [[buffer(0)]],
+    const constant isize *offset [[buffer(1)]],
+    const device T *logits [[buffer(2)]],
+    const device int *labels [[buffer(3)]],
+    device T *loss [[buffer(4)]],
+    uint row [[threadgroup_position_in_grid]],
+    uint lid [[thread_position_in_threadgroup]],
+    uint lsize [[threads_per_threadgroup]],
+    uint simd_size [[threads_per_simdgroup]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]])
+{
+    threadgroup OnlineStats ldata[max_simd_groups];
+    const device T *in_row = logits + offset[0] + row * ncol;
+    OnlineStats stats = row_stats(in_row, ncol, ldata, lid, lsize, simd_size, simd_lane_id, simd_group_id);
+    if (lid == 0) {
+        int label = labels[offset[1] + row];
+        // Labels out of range have no target logit
+        float target = 0 <= label && label < ncol ? static_cast<float>(in_row[label]) : NAN;
+        loss[offset[2] + row] = static_cast<T>(stats.max + metal::log(stats.sum) - target);
+    }
+}
+
+// Gradient w.r.t. the logits, the softmax being recomputed from the row and the label subtracted in place of a one-hot row
+template <class T>
+kernel void cross_entropy_grad(
+    const constant isize &ncol [[buffer(0)]],
+    const constant isize *offset [[buffer(1)]],
+    const device T *logits [[buffer(2)]],
+    const device int *labels [[buffer(3)]],
+    const device T *grad [[buffer(4)]],
+    device T *in_grad [[buffer(5)]],
+    uint row [[threadgroup_position_in_grid]],
+    uint lid [[thread_position_in_threadgroup]],
+    uint lsize [[threads_per_threadgroup]],
+    uint simd_size [[threads_per_simdgroup]],
+    uint simd_lane_id [[thread_index_in_simdgroup]],
+    uint simd_group_id [[simdgroup_index_in_threadgroup]])
+{
+    threadgroup OnlineStats ldata[max_simd_groups];
+    const device T *in_row = logits + offset[0] + row * ncol;
+    device T *in_grad_row = in_grad + offset[3] + row * ncol;
+    OnlineStats stats = row_stats(in_row, ncol, ldata, lid, lsize, simd_size, simd_lane_id, simd_group_id);
+    int label = labels[offset[1] + row];
+    float row_grad = static_cast<float>(grad[offset[2] + row]);
+    for (isize j = lid; j < ncol; j += lsize) {
+        float prob = metal::exp(static_cast<float>(in_row[j]) - stats.max) / stats.sum;
+        in_grad_row[j] = static_cast<T>(row_grad * (prob - (j == label ? 1.0f : 0.0f)));
+    }
+}
+
+#define make_softmax(dtype, T) \
+template [[host_name("softmax_" #dtype)]] [[kernel]] decltype(softmax<Softmax, T, 0>) softmax<Softmax, T, 0>; \
+template [[host_name("log_softmax_" #dtype)]] [[kernel]] decltype(softmax<LogSoftmax, T, 0>) softmax<LogSoftmax, T, 0>; \
+template [[host_name("logsumexp_" #dtype)]] [[kernel]] decltype(softmax<Logsumexp, T, 1>) softmax<Logsumexp, T, 1>; \
+template [[host_name("softmax_grad_" #dtype)]] [[kernel]] decltype(softmax_grad<SoftmaxGrad, T>) softmax_grad<SoftmaxGrad, T>; \
+template [[host_name("logsoftmax_grad_" #dtype)]] [[kernel]] decltype(softmax_grad<LogSoftmaxGrad, T>) softmax_grad<LogSoftmaxGrad, T>; \
+template [[host_name("xentropy_" #dtype)]] [[kernel]] decltype(cross_entropy<T>) cross_entropy<T>; \
+template [[host_name("xentropy_grad_" #dtype)]] [[kernel]] decltype(cross_entropy_grad<T>) cross_entropy_grad<T>;
+
+make_softmax(f32, float);
+make_softmax(f16, half);
+make_softmax(bf16, bfloat);
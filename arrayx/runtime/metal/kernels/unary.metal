@@ -1,4 +1,4 @@
-#include "utils.h"
+#include "activation.h"
 
 struct Exp
 {
@@ -68,7 +68,7 @@ kernel void unary(
 {
     isize in_idx = strided[0] ? strided_idx(id, ndim, shape, instride) : id;
     isize out_idx = strided[1] ? strided_idx(id, ndim, shape, outstride) : id;
-    output[offset[1] + out_idx] = Op()(input[offset[0] + in_idx]);
+    output[offset[1] + out_idx] = static_cast<R>(Op()(input[offset[0] + in_idx]));
 }
 
 #define make_unary_all(opname, op, dtype, T, R) \
@@ -77,13 +77,24 @@ template [[host_name(#opname "_" #dtype)]] [[kernel]] decltype(unary<op, T, R>)
 #define make_unary_float(opname, op, dtype, T) \
 template [[host_name(#opname "_" #dtype)]] [[kernel]] decltype(unary<op, T, float>) unary<op, T, float>;
 
-#define unary_float(opname, op)             \
-make_unary_float(opname, op, f32, float);   \
-make_unary_float(opname, op, i32, int);
+// 16-bit floats are computed in f32 by the ops and rounded when stored
+#define unary_float(opname, op)                     \
+make_unary_float(opname, op, f32, float);           \
+make_unary_all(opname, op, f16, half, half);        \
+make_unary_all(opname, op, bf16, bfloat, bfloat);   \
+make_unary_float(opname, op, i8, char);             \
+make_unary_float(opname, op, i16, short);           \
+make_unary_float(opname, op, i32, int);             \
+make_unary_float(opname, op, i64, long);
 
-#define unary_all(opname, op)                   \
-make_unary_all(opname, op, f32, float, float);  \
-make_unary_all(opname, op, i32, int, int);
+#define unary_all(opname, op)                       \
+make_unary_all(opname, op, f32, float, float);      \
+make_unary_all(opname, op, f16, half, half);        \
+make_unary_all(opname, op, bf16, bfloat, bfloat);   \
+make_unary_all(opname, op, i8, char, char);         \
+make_unary_all(opname, op, i16, short, short);      \
+make_unary_all(opname, op, i32, int, int);          \
+make_unary_all(opname, op, i64, long, long);
 
 unary_all(exp, Exp);
 unary_float(log, Log);
@@ -91,3 +102,5 @@ unary_all(neg, Neg);
 unary_float(recip, Recip);
 unary_all(sq, Sq);
 unary_float(sqrt, Sqrt);
+unary_float(gelu, Gelu);
+unary_float(silu, Silu);
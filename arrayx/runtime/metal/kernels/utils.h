@@ -4,6 +4,9 @@
 
 typedef int64_t isize;
 
+// Upper bound on the SIMD groups of a threadgroup, sizing the scratch of threadgroup reductions
+constant constexpr uint max_simd_groups = 32;
+
 inline uint strided_idx(const uint id, const isize ndim, const constant isize *shape, const constant isize *stride) {
     isize carry = id;
     isize idx = 0;
@@ -22,4 +25,23 @@ struct Limits {
     static T finite_max() { return metal::numeric_limits<T>::max(); }
     static T min() { return metal::numeric_limits<T>::has_infinity ? -metal::numeric_limits<T>::infinity() : finite_min(); }
     static T max() { return metal::numeric_limits<T>::has_infinity ? metal::numeric_limits<T>::infinity() : finite_max(); }
-};
\ No newline at end of file
+};
+
+// Sums a value over the threadgroup and returns the total to every thread
+inline float threadgroup_sum(float val, threadgroup float *ldata, uint lsize, uint simd_size, uint simd_lane_id, uint simd_group_id)
+{
+    val = metal::simd_sum(val);
+    if (simd_lane_id == 0) {
+        ldata[simd_group_id] = val;
+    }
+    threadgroup_barrier(metal::mem_flags::mem_threadgroup);
+    if (simd_group_id == 0) {
+        uint nsimd = (lsize + simd_size - 1) / simd_size;
+        val = metal::simd_sum(simd_lane_id < nsimd ? ldata[simd_lane_id] : 0.0f);
+        if (simd_lane_id == 0) {
+            ldata[0] = val;
+        }
+    }
+    threadgroup_barrier(metal::mem_flags::mem_threadgroup);
+    return ldata[0];
+}
@@ -21,6 +21,10 @@ namespace ax::runtime::metal {
         encoder.encode_array(rlazy);
         encoder.encode_array(out_lazy);
         std::string kernel_name = name + "_" + llazy->get_dtype()->str();
+        if (rlazy->get_dtype() != llazy->get_dtype()) {
+            // Mixed dtype kernels are named after both operands
+            kernel_name += "_" + rlazy->get_dtype()->str();
+        }
         encoder.set_pipeline_state(kernel_name);
         encoder.dispatch_threads(llazy->get_numel());
         encoder.wait_to_complete();
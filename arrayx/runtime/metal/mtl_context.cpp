@@ -26,7 +26,7 @@ namespace ax::runtime::metal {
     }
 
     void MTLContext::init_unary_kernels() {
-        std::vector<std::string> unary_opstrs = {"exp", "log", "neg", "recip", "sq", "sqrt"};
+        std::vector<std::string> unary_opstrs = {"exp", "log", "neg", "recip", "sq", "sqrt", "gelu", "silu"};
         init_kernels(unary_opstrs, numeric_dtypes);
     }
 
@@ -34,26 +34,75 @@ namespace ax::runtime::metal {
         std::vector<std::string> binary_opstrs = {"add", "sub", "mul", "div", "lt", "gt", "leq", "geq", "minimum", "maximum"};
         std::vector<std::string> eq_opstrs = {"eq", "neq"};
         init_kernels(binary_opstrs, numeric_dtypes);
-        init_kernels(eq_opstrs, all_dtypes);
+        init_kernels(eq_opstrs, eq_dtypes);
+        init_kernels("quantize", quant_dtypes);
+    }
+
+    void MTLContext::init_grad_kernels() {
+        std::vector<std::string> grad_opstrs = {"maximum_grad", "minimum_grad", "index_grad"};
+        init_kernels(grad_opstrs, numeric_dtypes);
+        std::vector<std::string> activation_grad_opstrs = {"relu_grad", "gelu_grad", "silu_grad"};
+        init_kernels(activation_grad_opstrs, float_dtypes);
+    }
+
+    void MTLContext::init_mask_kernels() {
+        init_kernel("pack_mask");
+        init_kernel("count_mask");
+        init_kernels("mask_mul", numeric_dtypes);
+    }
+
+    void MTLContext::init_softmax_kernels() {
+        std::vector<std::string> softmax_opstrs = {"softmax", "log_softmax", "logsumexp", "softmax_grad", "logsoftmax_grad", "xentropy", "xentropy_grad"};
+        init_kernels(softmax_opstrs, float_dtypes);
+    }
+
+    void MTLContext::init_conv_kernels() {
+        std::vector<std::string> conv_opstrs = {"conv2d", "conv2d_in_grad", "conv2d_w_grad", "conv2d_im2col"};
+        init_kernels(conv_opstrs, float_dtypes);
     }
 
     void MTLContext::init_reduce_kernels() {
-        std::vector<std::string> reduce_opstrs = {"sum", "max", "min", "argmax", "argmin"};
+        std::vector<std::string> reduce_opstrs = {"sum", "argmax", "argmin"};
         for (auto &opstr : reduce_opstrs) {
             init_kernels(opstr + "_all", numeric_dtypes);
             init_kernels(opstr + "_col", numeric_dtypes);
         }
+        // i64 maxima and minima are gathered through their indices since Metal has no 64-bit atomic max
+        std::vector<std::string> minmax_opstrs = {"max", "min"};
+        for (auto &dtype : numeric_dtypes) {
+            if (dtype == &i64) {
+                continue;
+            }
+            for (auto &opstr : minmax_opstrs) {
+                init_kernel(opstr + "_all_" + dtype->get_name_str());
+                init_kernel(opstr + "_col_" + dtype->get_name_str());
+            }
+        }
+        // Tracked floating-point maxima and minima also record the indices of their extrema
+        std::vector<std::string> indexed_opstrs = {"indexed_max", "indexed_min"};
+        for (auto &opstr : indexed_opstrs) {
+            init_kernels(opstr + "_all", float_dtypes);
+            init_kernels(opstr + "_col", float_dtypes);
+        }
     }
 
     void MTLContext::init_matmul_kernels() {
         init_kernels("matmul", numeric_dtypes);
+        init_kernels("qmatmul", quant_dtypes);
+        std::vector<std::string> linear_opstrs = {"linear_none", "linear_relu", "linear_gelu", "linear_silu"};
+        init_kernels(linear_opstrs, float_dtypes);
     }
 
     void MTLContext::init_copy_kernels() {
         for (auto &dtype1 : all_dtypes) {
             for (auto &dtype2 : all_dtypes) {
-                const std::string name = "copy_" + dtype1->get_name_str() + "_" + dtype2->get_name_str();
-                init_kernel(name);
+                // Copies from and to f64 are done by the host
+                if (dtype1 == &f64 || dtype2 == &f64) {
+                    continue;
+                }
+                const std::string dtype_str = dtype1->get_name_str() + "_" + dtype2->get_name_str();
+                init_kernel("copy_" + dtype_str);
+                init_kernel("copy_transpose_" + dtype_str);
             }
         }
     }
@@ -72,16 +121,41 @@ namespace ax::runtime::metal {
         init_initializer_kernels();
         init_unary_kernels();
         init_binary_kernels();
+        init_grad_kernels();
+        init_mask_kernels();
+        init_softmax_kernels();
+        init_conv_kernels();
         init_reduce_kernels();
         init_matmul_kernels();
         init_copy_kernels();
     }
 
     bool MTLContext::register_kernel(const std::string &name, std::shared_ptr<MTLKernel> kernel) {
+        std::unique_lock<std::shared_mutex> lock(kernel_mutex);
         if (kernel_by_name.contains(name)) {
             return false;
         }
         kernel_by_name.insert(std::make_pair(name, kernel));
         return true;
     }
+
+    std::shared_ptr<MTLKernel> MTLContext::get_kernel(const std::string &name) {
+        {
+            std::shared_lock<std::shared_mutex> lock(kernel_mutex);
+            auto iter = kernel_by_name.find(name);
+            if (iter != kernel_by_name.end()) {
+                return iter->second;
+            }
+        }
+        // Kernels over pairs of dtypes, such as mixed dtype binary ops, are too many to build upfront
+        // so they are built the first time they are dispatched
+        auto kernel = std::make_shared<MTLKernel>(name);
+        kernel->init(device, lib);
+        if (kernel->get_function().get() == nullptr) {
+            throw std::out_of_range("Kernel " + name + " does not exist.");
+        }
+        register_kernel(name, kernel);
+        std::shared_lock<std::shared_mutex> lock(kernel_mutex);
+        return kernel_by_name.at(name);
+    }
 } // namespace ax::runtime::metal
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "../../device/metal/mtl_allocator.h"
 #include "../../graph/metal/mtl_kernel.h"
 #include "../runner_context.h"
+#include <shared_mutex>
 
 namespace ax::runtime::metal {
     using namespace ax::core;
@@ -17,6 +18,8 @@ namespace ax::runtime::metal {
         NS::SharedPtr<MTL::Library> lib;
         NS::SharedPtr<MTL::CommandQueue> cmd_queue;
         std::unordered_map<std::string, std::shared_ptr<MTLKernel>> kernel_by_name;
+        // Kernels may be registered while other threads dispatch
+        mutable std::shared_mutex kernel_mutex;
 
         void init_kernel(const std::string &name);
         void init_kernels(const std::vector<std::string> &opstrs, DtypePtrSet &dtypes);
@@ -24,6 +27,10 @@ namespace ax::runtime::metal {
         void init_initializer_kernels();
         void init_unary_kernels();
         void init_binary_kernels();
+        void init_grad_kernels();
+        void init_mask_kernels();
+        void init_softmax_kernels();
+        void init_conv_kernels();
         void init_reduce_kernels();
         void init_matmul_kernels();
         void init_copy_kernels();
@@ -37,9 +44,7 @@ namespace ax::runtime::metal {
             return allocator;
         }
 
-        std::shared_ptr<MTLKernel> get_kernel(const std::string &name) const {
-            return kernel_by_name.at(name);
-        }
+        std::shared_ptr<MTLKernel> get_kernel(const std::string &name);
 
         NS::SharedPtr<MTL::Device> get_device() const {
             return device;
@@ -0,0 +1,138 @@
+#include "mtl_runner.h"
+
+namespace ax::runtime::metal {
+    enum struct ConvAlgo {
+        DIRECT,
+        GEMM
+    };
+
+    // Windows shorter than this are cheaper to walk in place than to unfold into memory first
+    static constexpr isize min_gemm_window = 64;
+    // Largest unfolded input materialized by the GEMM path, bigger convolutions run directly
+    static constexpr isize max_im2col_nbytes = 256 << 20;
+
+    // Pointwise convolutions read the input as it is laid out so they need no unfolding
+    static bool is_pointwise(const ShapeView &weight_view, const Conv2dParams &params) {
+        return weight_view[2] == 1 && weight_view[3] == 1 &&
+               params.stride[0] == 1 && params.stride[1] == 1 &&
+               params.padding[0] == 0 && params.padding[1] == 0;
+    }
+
+    // Forward convolutions are lowered to a matmul of the weight with the unfolded input when the windows are long enough
+    // The matmul multiplies every example with the same weight, so grouped convolutions always run directly
+    static ConvAlgo select_conv2d_algo(LazyPtr in_lazy, LazyPtr weight_lazy, LazyPtr out_lazy, const Conv2dParams &params) {
+        const ShapeView &weight_view = weight_lazy->get_view();
+        const ShapeView &out_view = out_lazy->get_view();
+        if (params.groups != 1) {
+            return ConvAlgo::DIRECT;
+        }
+        if (is_pointwise(weight_view, params)) {
+            return ConvAlgo::GEMM;
+        }
+        isize window = weight_view[1] * weight_view[2] * weight_view[3];
+        isize cols_nbytes = out_view[0] * window * out_view[2] * out_view[3] * in_lazy->get_itemsize();
+        return window >= min_gemm_window && cols_nbytes <= max_im2col_nbytes ? ConvAlgo::GEMM : ConvAlgo::DIRECT;
+    }
+
+    // Every kernel is given the shapes of the forward input, weight and output whichever of them it computes
+    static void encode_conv_shapes(CommandEncoder &encoder, LazyPtr in_lazy, LazyPtr weight_lazy, LazyPtr out_lazy, const Conv2dParams &params) {
+        isize conv_params[] = {
+            params.stride[0], params.stride[1],
+            params.padding[0], params.padding[1],
+            params.dilation[0], params.dilation[1],
+            params.groups};
+        encoder.encode_view(in_lazy);
+        encoder.encode_view(weight_lazy);
+        encoder.encode_view(out_lazy);
+        encoder.encode_buffer(conv_params, sizeof(isize) * 7);
+    }
+
+    // One threadgroup per weight element made of whole SIMD groups reducing over the batch and the output positions
+    static void dispatch_weight_grad(CommandEncoder &encoder, isize weight_numel, isize npos) {
+        const isize max_threadgroup_size = encoder.get_kernel()->get_state()->maxTotalThreadsPerThreadgroup();
+        const isize simd_size = encoder.get_kernel()->get_state()->threadExecutionWidth();
+        const isize threadgroup_size = std::min((npos + simd_size - 1) / simd_size * simd_size, max_threadgroup_size);
+        encoder.dispatch_threadgroups(MTL::Size::Make(weight_numel, 1, 1), MTL::Size::Make(threadgroup_size, 1, 1));
+    }
+
+    void MTLRunner::run_conv2d_gemm(OpPtr in_op, OpPtr weight_op, OpPtr out_op, const Conv2dParams &params) {
+        LazyPtr in_lazy = in_op->get_lazy();
+        LazyPtr weight_lazy = weight_op->get_lazy();
+        LazyPtr out_lazy = out_op->get_lazy();
+        const ShapeView &weight_view = weight_lazy->get_view();
+        const ShapeView &out_view = out_lazy->get_view();
+        isize batch_size = out_view[0];
+        isize window = weight_view[1] * weight_view[2] * weight_view[3];
+        isize npos = out_view[2] * out_view[3];
+        LazyPtr cols_lazy;
+        if (is_pointwise(weight_view, params)) {
+            cols_lazy = Lazy::empty(Shape(in_lazy->get_offset(), {batch_size, window, npos}), in_lazy->get_dtype(), in_lazy->get_device());
+            alloc(cols_lazy, in_lazy);
+        } else {
+            cols_lazy = Lazy::empty(Shape({batch_size, window, npos}), in_lazy->get_dtype(), in_lazy->get_device());
+            alloc(cols_lazy);
+            NS::AutoreleasePool *pool = NS::AutoreleasePool::alloc()->init();
+            CommandEncoder encoder(ctx);
+            isize offset[] = {in_lazy->get_offset(), cols_lazy->get_offset()};
+            encode_conv_shapes(encoder, in_lazy, weight_lazy, out_lazy, params);
+            encoder.encode_buffer(offset, sizeof(isize) * 2);
+            encoder.encode_array(in_lazy);
+            encoder.encode_array(cols_lazy);
+            encoder.set_pipeline_state("conv2d_im2col_" + in_lazy->get_dtype()->str());
+            encoder.dispatch_threads(cols_lazy->get_numel());
+            encoder.wait_to_complete();
+            pool->release();
+        }
+        // The weight is read as (O, C * KH * KW) and shared by every example through a zero batch stride
+        LazyPtr lhs_lazy = Lazy::empty(Shape(weight_lazy->get_offset(), {batch_size, weight_view[0], window}, {0, window, 1}), weight_lazy->get_dtype(), weight_lazy->get_device());
+        alloc(lhs_lazy, weight_lazy);
+        // (N, O, OH * OW) products are the NCHW output as it is laid out
+        LazyPtr mm_out_lazy = Lazy::empty(Shape(out_lazy->get_offset(), {batch_size, weight_view[0], npos}), out_lazy->get_dtype(), out_lazy->get_device());
+        alloc(mm_out_lazy, out_lazy);
+        run_matmul_kernel(make_node<Nop>(lhs_lazy), make_node<Nop>(cols_lazy), make_node<Nop>(mm_out_lazy));
+    }
+
+    void MTLRunner::run_conv2d_kernel(const std::string &name, OpPtr lop, OpPtr rop, OpPtr out_op, const Conv2dParams &params) {
+        LazyPtr llazy = lop->get_lazy();
+        LazyPtr rlazy = rop->get_lazy();
+        LazyPtr out_lazy = out_op->get_lazy();
+        LazyPtr in_lazy = llazy;
+        LazyPtr weight_lazy = rlazy;
+        LazyPtr conv_out_lazy = out_lazy;
+        switch (out_op->get_opcode()) {
+        case Opcode::CONV2D_INPUT_GRAD:
+            in_lazy = out_lazy;
+            conv_out_lazy = llazy;
+            break;
+        case Opcode::CONV2D_WEIGHT_GRAD:
+            weight_lazy = out_lazy;
+            conv_out_lazy = rlazy;
+            break;
+        default:
+            if (select_conv2d_algo(in_lazy, weight_lazy, out_lazy, params) == ConvAlgo::GEMM) {
+                run_conv2d_gemm(lop, rop, out_op, params);
+                return;
+            }
+            break;
+        }
+        NS::AutoreleasePool *pool = NS::AutoreleasePool::alloc()->init();
+        CommandEncoder encoder(ctx);
+        isize offset[] = {llazy->get_offset(), rlazy->get_offset(), out_lazy->get_offset()};
+        encode_conv_shapes(encoder, in_lazy, weight_lazy, conv_out_lazy, params);
+        encoder.encode_buffer(offset, sizeof(isize) * 3);
+        encoder.encode_array(llazy);
+        encoder.encode_array(rlazy);
+        encoder.encode_array(out_lazy);
+        std::string kernel_name = name + "_" + llazy->get_dtype()->str();
+        encoder.set_pipeline_state(kernel_name);
+        if (out_op->get_opcode() == Opcode::CONV2D_WEIGHT_GRAD) {
+            const ShapeView &conv_out_view = conv_out_lazy->get_view();
+            dispatch_weight_grad(encoder, out_lazy->get_numel(), conv_out_view[0] * conv_out_view[2] * conv_out_view[3]);
+        } else {
+            // One thread per element of the computed array
+            encoder.dispatch_threads(out_lazy->get_numel());
+        }
+        encoder.wait_to_complete();
+        pool->release();
+    }
+} // namespace ax::runtime::metal
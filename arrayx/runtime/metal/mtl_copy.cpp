@@ -1,13 +1,181 @@
 #include "mtl_runner.h"
 
 namespace ax::runtime::metal {
+    // Copy into a contiguous output seen as a batch of matrix transposes
+    struct TransposePlan {
+        ShapeView batch_view;
+        ShapeStride batch_instride;
+        ShapeStride batch_outstride;
+        // Rows are contiguous in the input and columns are contiguous in the output
+        isize matrix[4];
+    };
+
+    static std::optional<TransposePlan> plan_transpose(LazyPtr in_lazy, LazyPtr out_lazy) {
+        if (in_lazy->is_contiguous() || !out_lazy->is_contiguous()) {
+            return std::nullopt;
+        }
+        // Drop singleton dims and merge dims that are contiguous with each other in the input
+        // The output is contiguous so any dims merged in the input are merged in the output as well
+        const ShapeView &in_view = in_lazy->get_view();
+        const ShapeStride &in_stride = in_lazy->get_stride();
+        const ShapeStride &out_stride = out_lazy->get_stride();
+        ShapeView view;
+        ShapeStride instride;
+        ShapeStride outstride;
+        for (size_t i = 0; i < in_view.size(); i++) {
+            if (in_view[i] == 1) {
+                continue;
+            }
+            if (!view.empty() && instride.back() == in_stride[i] * in_view[i]) {
+                view.back() *= in_view[i];
+                instride.back() = in_stride[i];
+                outstride.back() = out_stride[i];
+                continue;
+            }
+            view.push_back(in_view[i]);
+            instride.push_back(in_stride[i]);
+            outstride.push_back(out_stride[i]);
+        }
+
+        isize col_dim = view.size() - 1;
+        if (col_dim < 1 || instride[col_dim] == 1) {
+            return std::nullopt;
+        }
+        auto row_iter = std::find(instride.begin(), instride.end() - 1, 1);
+        if (row_iter == instride.end() - 1) {
+            return std::nullopt;
+        }
+        isize row_dim = row_iter - instride.begin();
+
+        TransposePlan plan;
+        plan.matrix[0] = view[row_dim];
+        plan.matrix[1] = view[col_dim];
+        plan.matrix[2] = instride[col_dim];
+        plan.matrix[3] = outstride[row_dim];
+        for (isize i = 0; i < col_dim; i++) {
+            if (i != row_dim) {
+                plan.batch_view.push_back(view[i]);
+                plan.batch_instride.push_back(instride[i]);
+                plan.batch_outstride.push_back(outstride[i]);
+            }
+        }
+        // Keeps the batch arrays non-empty so that they can be bound as buffers
+        if (plan.batch_view.empty()) {
+            plan.batch_view.push_back(1);
+            plan.batch_instride.push_back(0);
+            plan.batch_outstride.push_back(0);
+        }
+        return plan;
+    }
+
+    static double load_scalar(DtypePtr dtype, const uint8_t *ptr) {
+        switch (dtype->get_name()) {
+        case DtypeName::F16:
+            return *reinterpret_cast<const Float16 *>(ptr);
+        case DtypeName::BF16:
+            return *reinterpret_cast<const BFloat16 *>(ptr);
+        case DtypeName::F32:
+            return *reinterpret_cast<const float *>(ptr);
+        case DtypeName::F64:
+            return *reinterpret_cast<const double *>(ptr);
+        case DtypeName::I8:
+            return *reinterpret_cast<const int8_t *>(ptr);
+        case DtypeName::I16:
+            return *reinterpret_cast<const int16_t *>(ptr);
+        case DtypeName::I32:
+            return *reinterpret_cast<const int32_t *>(ptr);
+        case DtypeName::I64:
+            return *reinterpret_cast<const int64_t *>(ptr);
+        default:
+            return *reinterpret_cast<const bool *>(ptr);
+        }
+    }
+
+    static void store_scalar(DtypePtr dtype, uint8_t *ptr, double val) {
+        switch (dtype->get_name()) {
+        case DtypeName::F16:
+            *reinterpret_cast<Float16 *>(ptr) = Float16(static_cast<float>(val));
+            break;
+        case DtypeName::BF16:
+            *reinterpret_cast<BFloat16 *>(ptr) = BFloat16(static_cast<float>(val));
+            break;
+        case DtypeName::F32:
+            *reinterpret_cast<float *>(ptr) = static_cast<float>(val);
+            break;
+        case DtypeName::F64:
+            *reinterpret_cast<double *>(ptr) = val;
+            break;
+        case DtypeName::I8:
+            *reinterpret_cast<int8_t *>(ptr) = static_cast<int8_t>(val);
+            break;
+        case DtypeName::I16:
+            *reinterpret_cast<int16_t *>(ptr) = static_cast<int16_t>(val);
+            break;
+        case DtypeName::I32:
+            *reinterpret_cast<int32_t *>(ptr) = static_cast<int32_t>(val);
+            break;
+        case DtypeName::I64:
+            *reinterpret_cast<int64_t *>(ptr) = static_cast<int64_t>(val);
+            break;
+        default:
+            *reinterpret_cast<bool *>(ptr) = val != 0;
+            break;
+        }
+    }
+
+    // Metal has no double so copies from and to f64 run on the host over the shared buffers
+    static void copy_on_host(LazyPtr in_lazy, LazyPtr out_lazy) {
+        DtypePtr in_dtype = in_lazy->get_dtype();
+        DtypePtr out_dtype = out_lazy->get_dtype();
+        for (isize k = 0; k < in_lazy->get_numel(); k++) {
+            uint8_t *in_ptr = in_lazy->strided_elm_ptr(k);
+            uint8_t *out_ptr = out_lazy->strided_elm_ptr(k);
+            if (in_dtype == out_dtype) {
+                std::memcpy(out_ptr, in_ptr, in_dtype->get_size());
+            } else {
+                store_scalar(out_dtype, out_ptr, load_scalar(in_dtype, in_ptr));
+            }
+        }
+    }
+
     void MTLRunner::run_copy_kernel(OpPtr in_op, OpPtr out_op) {
-        NS::AutoreleasePool *pool = NS::AutoreleasePool::alloc()->init();
-        CommandEncoder encoder(ctx);
         LazyPtr in_lazy = in_op->get_lazy();
         LazyPtr out_lazy = out_op->get_lazy();
-        isize ndim = in_lazy->get_ndim();
+        if (in_lazy->get_dtype() == &f64 || out_lazy->get_dtype() == &f64) {
+            copy_on_host(in_lazy, out_lazy);
+            return;
+        }
+
+        NS::AutoreleasePool *pool = NS::AutoreleasePool::alloc()->init();
+        CommandEncoder encoder(ctx);
         isize offset[] = {in_lazy->get_offset(), out_lazy->get_offset()};
+        std::string dtype_str = in_lazy->get_dtype()->str() + "_" + out_lazy->get_dtype()->str();
+
+        // Transposes copied one element at a time miss the cache on every read, so they go through tiles instead
+        if (std::optional<TransposePlan> plan = plan_transpose(in_lazy, out_lazy)) {
+            isize batch_ndim = plan->batch_view.size();
+            isize batch_size = std::accumulate(plan->batch_view.begin(), plan->batch_view.end(), 1, std::multiplies<isize>());
+            encoder.encode_buffer(&batch_ndim, sizeof(isize));
+            encoder.encode_buffer(offset, sizeof(isize) * 2);
+            encoder.encode_buffer(plan->batch_view.data(), sizeof(isize) * batch_ndim);
+            encoder.encode_buffer(plan->batch_instride.data(), sizeof(isize) * batch_ndim);
+            encoder.encode_buffer(plan->batch_outstride.data(), sizeof(isize) * batch_ndim);
+            encoder.encode_buffer(plan->matrix, sizeof(isize) * 4);
+            encoder.encode_array(in_lazy);
+            encoder.encode_array(out_lazy);
+            encoder.set_pipeline_state("copy_transpose_" + dtype_str);
+            // Must match the tile and row counts of the kernel
+            const isize tile = 32;
+            const isize rows = 8;
+            auto threadgroup_count = MTL::Size::Make((plan->matrix[1] + tile - 1) / tile, (plan->matrix[0] + tile - 1) / tile, batch_size);
+            auto threadgroup_size = MTL::Size::Make(tile, rows, 1);
+            encoder.dispatch_threadgroups(threadgroup_count, threadgroup_size);
+            encoder.wait_to_complete();
+            pool->release();
+            return;
+        }
+
+        isize ndim = in_lazy->get_ndim();
         bool strided[] = {!in_lazy->is_contiguous(), !out_lazy->is_contiguous()};
         encoder.encode_buffer(&ndim, sizeof(isize));
         encoder.encode_buffer(offset, sizeof(isize) * 2);
@@ -17,10 +185,9 @@ namespace ax::runtime::metal {
         encoder.encode_buffer(strided, sizeof(bool) * 2);
         encoder.encode_array(in_lazy);
         encoder.encode_array(out_lazy);
-        std::string kernel_name = "copy_" + in_lazy->get_dtype()->str() + "_" + out_lazy->get_dtype()->str();
-        encoder.set_pipeline_state(kernel_name);
+        encoder.set_pipeline_state("copy_" + dtype_str);
         encoder.dispatch_threads(in_lazy->get_numel());
         encoder.wait_to_complete();
         pool->release();
     }
-} // namespace ax::runtime::metal
\ No newline at end of file
+} // namespace ax::runtime::metal
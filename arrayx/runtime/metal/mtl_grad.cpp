@@ -0,0 +1,53 @@
+#include "mtl_runner.h"
+
+namespace ax::runtime::metal {
+    void MTLRunner::run_ternary_kernel(const std::string &name, OpPtr first_op, OpPtr second_op, OpPtr third_op, OpPtr out_op) {
+        NS::AutoreleasePool *pool = NS::AutoreleasePool::alloc()->init();
+        CommandEncoder encoder(ctx);
+        LazyPtr first_lazy = first_op->get_lazy();
+        LazyPtr second_lazy = second_op->get_lazy();
+        LazyPtr third_lazy = third_op->get_lazy();
+        LazyPtr out_lazy = out_op->get_lazy();
+        isize ndim = first_lazy->get_ndim();
+        isize offset[] = {first_lazy->get_offset(), second_lazy->get_offset(), third_lazy->get_offset(), out_lazy->get_offset()};
+        bool strided[] = {!first_lazy->is_contiguous(), !second_lazy->is_contiguous(), !third_lazy->is_contiguous(), !out_lazy->is_contiguous()};
+        encoder.encode_buffer(&ndim, sizeof(isize));
+        encoder.encode_buffer(offset, sizeof(isize) * 4);
+        encoder.encode_view(first_lazy);
+        encoder.encode_stride(first_lazy);
+        encoder.encode_stride(second_lazy);
+        encoder.encode_stride(third_lazy);
+        encoder.encode_stride(out_lazy);
+        encoder.encode_buffer(strided, sizeof(bool) * 4);
+        encoder.encode_array(first_lazy);
+        encoder.encode_array(second_lazy);
+        encoder.encode_array(third_lazy);
+        encoder.encode_array(out_lazy);
+        std::string kernel_name = name + "_" + first_lazy->get_dtype()->str();
+        encoder.set_pipeline_state(kernel_name);
+        encoder.dispatch_threads(first_lazy->get_numel());
+        encoder.wait_to_complete();
+        pool->release();
+    }
+
+    void MTLRunner::run_index_grad_kernel(OpPtr idx_op, OpPtr grad_op, OpPtr out_op) {
+        NS::AutoreleasePool *pool = NS::AutoreleasePool::alloc()->init();
+        CommandEncoder encoder(ctx);
+        LazyPtr idx_lazy = idx_op->get_lazy();
+        LazyPtr grad_lazy = grad_op->get_lazy();
+        LazyPtr out_lazy = out_op->get_lazy();
+        // Number of elements in each reduced row of the output
+        isize ncol = out_lazy->get_numel() / grad_lazy->get_numel();
+        isize offset[] = {idx_lazy->get_offset(), grad_lazy->get_offset(), out_lazy->get_offset()};
+        encoder.encode_buffer(&ncol, sizeof(isize));
+        encoder.encode_buffer(offset, sizeof(isize) * 3);
+        encoder.encode_array(idx_lazy);
+        encoder.encode_array(grad_lazy);
+        encoder.encode_array(out_lazy);
+        std::string kernel_name = IndexGradOp::opname + "_" + grad_lazy->get_dtype()->str();
+        encoder.set_pipeline_state(kernel_name);
+        encoder.dispatch_threads(out_lazy->get_numel());
+        encoder.wait_to_complete();
+        pool->release();
+    }
+} // namespace ax::runtime::metal
@@ -0,0 +1,67 @@
+#include "mtl_runner.h"
+
+namespace ax::runtime::metal {
+    void MTLRunner::run_pack_mask_kernel(OpPtr in_op, OpPtr out_op) {
+        NS::AutoreleasePool *pool = NS::AutoreleasePool::alloc()->init();
+        CommandEncoder encoder(ctx);
+        LazyPtr in_lazy = in_op->get_lazy();
+        LazyPtr out_lazy = out_op->get_lazy();
+        isize numel = in_lazy->get_numel();
+        isize ndim = in_lazy->get_ndim();
+        isize offset[] = {in_lazy->get_offset(), out_lazy->get_offset()};
+        bool strided = !in_lazy->is_contiguous();
+        encoder.encode_buffer(&numel, sizeof(isize));
+        encoder.encode_buffer(&ndim, sizeof(isize));
+        encoder.encode_buffer(offset, sizeof(isize) * 2);
+        encoder.encode_view(in_lazy);
+        encoder.encode_stride(in_lazy);
+        encoder.encode_buffer(&strided, sizeof(bool));
+        encoder.encode_array(in_lazy);
+        encoder.encode_array(out_lazy);
+        encoder.set_pipeline_state(PackMaskOp::opname);
+        // One thread per word
+        encoder.dispatch_threads(out_lazy->get_numel());
+        encoder.wait_to_complete();
+        pool->release();
+    }
+
+    void MTLRunner::run_count_mask_kernel(OpPtr mask_op, OpPtr out_op) {
+        NS::AutoreleasePool *pool = NS::AutoreleasePool::alloc()->init();
+        CommandEncoder encoder(ctx);
+        LazyPtr mask_lazy = mask_op->get_lazy();
+        LazyPtr out_lazy = out_op->get_lazy();
+        isize offset[] = {mask_lazy->get_offset(), out_lazy->get_offset()};
+        encoder.encode_buffer(offset, sizeof(isize) * 2);
+        encoder.encode_array(mask_lazy);
+        encoder.encode_array(out_lazy);
+        encoder.set_pipeline_state(CountMaskOp::opname);
+        encoder.dispatch_threads(mask_lazy->get_numel());
+        encoder.wait_to_complete();
+        pool->release();
+    }
+
+    void MTLRunner::run_mask_mul_kernel(OpPtr lop, OpPtr mask_op, OpPtr out_op) {
+        NS::AutoreleasePool *pool = NS::AutoreleasePool::alloc()->init();
+        CommandEncoder encoder(ctx);
+        LazyPtr llazy = lop->get_lazy();
+        LazyPtr mask_lazy = mask_op->get_lazy();
+        LazyPtr out_lazy = out_op->get_lazy();
+        isize ndim = llazy->get_ndim();
+        isize offset[] = {llazy->get_offset(), mask_lazy->get_offset(), out_lazy->get_offset()};
+        bool strided[] = {!llazy->is_contiguous(), !out_lazy->is_contiguous()};
+        encoder.encode_buffer(&ndim, sizeof(isize));
+        encoder.encode_buffer(offset, sizeof(isize) * 3);
+        encoder.encode_view(llazy);
+        encoder.encode_stride(llazy);
+        encoder.encode_stride(out_lazy);
+        encoder.encode_buffer(strided, sizeof(bool) * 2);
+        encoder.encode_array(llazy);
+        encoder.encode_array(mask_lazy);
+        encoder.encode_array(out_lazy);
+        std::string kernel_name = MaskMulOp::opname + "_" + llazy->get_dtype()->str();
+        encoder.set_pipeline_state(kernel_name);
+        encoder.dispatch_threads(llazy->get_numel());
+        encoder.wait_to_complete();
+        pool->release();
+    }
+} // namespace ax::runtime::metal
@@ -1,6 +1,28 @@
 #include "mtl_runner.h"
 
 namespace ax::runtime::metal {
+    // One thread per output element of the (B, M, N) result
+    static void dispatch_matmul(CommandEncoder &encoder, LazyPtr llazy, LazyPtr rlazy) {
+        const ShapeView &lview = llazy->get_view();
+        const ShapeView &rview = rlazy->get_view();
+        const isize batch_size = lview[0];
+        const isize nrow = lview[1];
+        const isize ncol = rview[2];
+        const isize x_threads_per_group = 8;
+        const isize y_threads_per_group = 8;
+        const isize z_threads_per_group = 4;
+        // Even if matrix is smaller than one threadgroup, we still need at least 1 group
+        const isize x_group_count = std::max(1ll, (ncol + x_threads_per_group - 1) / x_threads_per_group);
+        const isize y_group_count = std::max(1ll, (nrow + y_threads_per_group - 1) / y_threads_per_group);
+        const isize z_group_count = std::max(1ll, (batch_size + z_threads_per_group - 1) / z_threads_per_group);
+        // Compute # threadgroups and threadgroup size
+        auto threadgroup_count = MTL::Size::Make(x_group_count, y_group_count, z_group_count);
+        auto threadgroup_size = MTL::Size::Make(x_threads_per_group, y_threads_per_group, z_threads_per_group);
+
+        // Dispatch kernel
+        encoder.dispatch_threadgroups(threadgroup_count, threadgroup_size);
+    }
+
     void MTLRunner::run_matmul_kernel(OpPtr lop, OpPtr rop, OpPtr out_op) {
         NS::AutoreleasePool *pool = NS::AutoreleasePool::alloc()->init();
         CommandEncoder encoder(ctx);
@@ -23,25 +45,69 @@ namespace ax::runtime::metal {
         std::string kernel_name = "matmul_" + llazy->get_dtype()->str();
         encoder.set_pipeline_state(kernel_name);
 
-        const ShapeView &lview = llazy->get_view();
-        const ShapeView &rview = rlazy->get_view();
-        const isize batch_size = lview[0];
-        const isize nrow = lview[1];
-        const isize ncol = rview[2];
+        dispatch_matmul(encoder, llazy, rlazy);
+        encoder.wait_to_complete();
+        pool->release();
+    }
+
+    void MTLRunner::run_qmatmul_kernel(OpPtr lop, OpPtr rop, OpPtr scale_op, OpPtr out_op) {
+        NS::AutoreleasePool *pool = NS::AutoreleasePool::alloc()->init();
+        CommandEncoder encoder(ctx);
+        LazyPtr llazy = lop->get_lazy();
+        LazyPtr rlazy = rop->get_lazy();
+        LazyPtr scale_lazy = scale_op->get_lazy();
+        LazyPtr out_lazy = out_op->get_lazy();
+        isize ndim = llazy->get_ndim();
+        isize offset[] = {llazy->get_offset(), rlazy->get_offset(), scale_lazy->get_offset(), out_lazy->get_offset()};
+        bool strided[] = {!llazy->is_contiguous(), !rlazy->is_contiguous(), !scale_lazy->is_contiguous()};
+        encoder.encode_buffer(&ndim, sizeof(isize));
+        encoder.encode_buffer(offset, sizeof(isize) * 4);
+        encoder.encode_view(llazy);
+        encoder.encode_view(rlazy);
+        encoder.encode_view(out_lazy);
+        encoder.encode_stride(llazy);
+        encoder.encode_stride(rlazy);
+        encoder.encode_stride(scale_lazy);
+        encoder.encode_buffer(strided, sizeof(bool) * 3);
+        encoder.encode_array(llazy);
+        encoder.encode_array(rlazy);
+        encoder.encode_array(scale_lazy);
+        encoder.encode_array(out_lazy);
+        // Kernels are named after the scales, which are also the output's type
+        std::string kernel_name = "qmatmul_" + out_lazy->get_dtype()->str();
+        encoder.set_pipeline_state(kernel_name);
+        dispatch_matmul(encoder, llazy, rlazy);
+        encoder.wait_to_complete();
+        pool->release();
+    }
+
+    void MTLRunner::run_linear_kernel(OpPtr in_op, OpPtr weight_op, OpPtr bias_op, OpPtr out_op, Activation activation) {
+        NS::AutoreleasePool *pool = NS::AutoreleasePool::alloc()->init();
+        CommandEncoder encoder(ctx);
+        LazyPtr in_lazy = in_op->get_lazy();
+        LazyPtr weight_lazy = weight_op->get_lazy();
+        LazyPtr bias_lazy = bias_op->get_lazy();
+        LazyPtr out_lazy = out_op->get_lazy();
+        const isize nrow = in_lazy->get_view()[0];
+        const isize ncol = weight_lazy->get_view()[0];
+        isize dims[] = {nrow, ncol, in_lazy->get_view()[1]};
+        isize offset[] = {in_lazy->get_offset(), weight_lazy->get_offset(), bias_lazy->get_offset(), out_lazy->get_offset()};
+        encoder.encode_buffer(dims, sizeof(isize) * 3);
+        encoder.encode_buffer(offset, sizeof(isize) * 4);
+        encoder.encode_array(in_lazy);
+        encoder.encode_array(weight_lazy);
+        encoder.encode_array(bias_lazy);
+        encoder.encode_array(out_lazy);
+        std::string kernel_name = "linear_" + activation_str(activation) + "_" + in_lazy->get_dtype()->str();
+        encoder.set_pipeline_state(kernel_name);
+
+        // One thread per output element of the (M, N) result
         const isize x_threads_per_group = 8;
         const isize y_threads_per_group = 8;
-        const isize z_threads_per_group = 4;
-        // Even if matrix is smaller than one threadgroup, we still need at least 1 group
         const isize x_group_count = std::max(1ll, (ncol + x_threads_per_group - 1) / x_threads_per_group);
         const isize y_group_count = std::max(1ll, (nrow + y_threads_per_group - 1) / y_threads_per_group);
-        const isize z_group_count = std::max(1ll, (batch_size + z_threads_per_group - 1) / z_threads_per_group);
-        // Compute # threadgroups and threadgroup size
-        auto threadgroup_count = MTL::Size::Make(x_group_count, y_group_count, z_group_count);
-        auto threadgroup_size = MTL::Size::Make(x_threads_per_group, y_threads_per_group, z_threads_per_group);
-
-        // Dispatch kernel
-        encoder.dispatch_threadgroups(threadgroup_count, threadgroup_size);
+        encoder.dispatch_threadgroups(MTL::Size::Make(x_group_count, y_group_count, 1), MTL::Size::Make(x_threads_per_group, y_threads_per_group, 1));
         encoder.wait_to_complete();
         pool->release();
     }
-} // namespace ax::runtime::metal
\ No newline at end of file
+} // namespace ax::runtime::metal
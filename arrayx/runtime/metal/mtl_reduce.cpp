@@ -1,28 +1,40 @@
 #include "mtl_runner.h"
 
 namespace ax::runtime::metal {
+    // Index array that a tracked max or min records its extrema into, if any
+    static LazyPtr get_recorded_index(OpPtr out_op) {
+        if (out_op->get_opcode() != Opcode::MAX && out_op->get_opcode() != Opcode::MIN) {
+            return nullptr;
+        }
+        return static_pointer_cast<ExtremumOp>(out_op)->get_index();
+    }
+
     void MTLRunner::run_reduce_all_kernel(const std::string &name, OpPtr in_op, OpPtr out_op) {
         // Initialize Metal autorelease pool and encoder
         NS::AutoreleasePool *pool = NS::AutoreleasePool::alloc()->init();
         CommandEncoder encoder(ctx);
         LazyPtr in_lazy = in_op->get_lazy();
         LazyPtr out_lazy = out_op->get_lazy();
+        LazyPtr idx_lazy = get_recorded_index(out_op);
         isize numel = in_lazy->get_numel();
         isize ndim = in_lazy->get_ndim();
-        isize offset[] = {in_lazy->get_offset(), out_lazy->get_offset()};
+        isize offset[] = {in_lazy->get_offset(), out_lazy->get_offset(), idx_lazy != nullptr ? idx_lazy->get_offset() : 0};
         bool strided = !in_lazy->is_contiguous();
         encoder.encode_buffer(&numel, sizeof(isize));
         encoder.encode_buffer(&ndim, sizeof(isize));
-        encoder.encode_buffer(offset, sizeof(isize) * 2);
+        encoder.encode_buffer(offset, sizeof(isize) * 3);
         encoder.encode_view(in_lazy);
         encoder.encode_stride(in_lazy);
         encoder.encode_buffer(&strided, sizeof(bool));
         encoder.encode_array(in_lazy);
         encoder.encode_array(out_lazy);
+        if (idx_lazy != nullptr) {
+            encoder.encode_array(idx_lazy);
+        }
 
         // Configure kernel
         DtypePtr dtype = in_lazy->get_dtype();
-        std::string kernel_name = name + "_all_" + dtype->str();
+        std::string kernel_name = (idx_lazy != nullptr ? "indexed_" + name : name) + "_all_" + dtype->str();
         encoder.set_pipeline_state(kernel_name);
 
         // Calculate optimal thread configuration
@@ -30,11 +42,13 @@ namespace ax::runtime::metal {
         const isize simd_size = encoder.get_kernel()->get_state()->threadExecutionWidth();
         const isize threadgroup_size = std::min(numel, max_threadgroup_size);
         // Set threadgroup memory size
-        const isize val_threadgroup_nbytes = threadgroup_size * dtype->get_size();
+        // Partial values are kept in the wider of the input and output types
+        const isize val_nbytes = std::max(in_lazy->get_itemsize(), out_lazy->get_itemsize());
+        const isize val_threadgroup_nbytes = threadgroup_size * val_nbytes;
         encoder.get_internal_encoder()->setThreadgroupMemoryLength(val_threadgroup_nbytes, 0);
-        std::shared_ptr<ReduceOp> reduce_op = std::static_pointer_cast<ReduceOp>(out_op);
+        NodePtr<ReduceOp> reduce_op = static_pointer_cast<ReduceOp>(out_op);
 
-        if (reduce_op->get_mode() == ReduceMode::ARG) {
+        if (reduce_op->get_mode() == ReduceMode::ARG || idx_lazy != nullptr) {
             const isize arg_threadgroup_nbytes = threadgroup_size * sizeof(uint);
             encoder.get_internal_encoder()->setThreadgroupMemoryLength(arg_threadgroup_nbytes, 1);
         }
@@ -51,20 +65,24 @@ namespace ax::runtime::metal {
         CommandEncoder encoder(ctx);
         LazyPtr in_lazy = in_op->get_lazy();
         LazyPtr out_lazy = out_op->get_lazy();
+        LazyPtr idx_lazy = get_recorded_index(out_op);
         isize ndim = in_lazy->get_ndim();
-        isize offset[] = {in_lazy->get_offset(), out_lazy->get_offset()};
+        isize offset[] = {in_lazy->get_offset(), out_lazy->get_offset(), idx_lazy != nullptr ? idx_lazy->get_offset() : 0};
         bool strided = !in_lazy->is_contiguous();
         encoder.encode_buffer(&ndim, sizeof(isize));
-        encoder.encode_buffer(offset, sizeof(isize) * 2);
+        encoder.encode_buffer(offset, sizeof(isize) * 3);
         encoder.encode_view(in_lazy);
         encoder.encode_stride(in_lazy);
         encoder.encode_buffer(&strided, sizeof(bool));
         encoder.encode_array(in_lazy);
         encoder.encode_array(out_lazy);
+        if (idx_lazy != nullptr) {
+            encoder.encode_array(idx_lazy);
+        }
 
         // Configure kernel
         DtypePtr dtype = in_lazy->get_dtype();
-        std::string kernel_name = name + "_col_" + dtype->str();
+        std::string kernel_name = (idx_lazy != nullptr ? "indexed_" + name : name) + "_col_" + dtype->str();
         encoder.set_pipeline_state(kernel_name);
 
         // Calculate optimal thread configuration
@@ -75,13 +93,14 @@ namespace ax::runtime::metal {
         const isize ncol = (view[1] + simd_size - 1) / simd_size * simd_size;
         const isize col_threadgroup_size = std::min(ncol, max_threadgroup_size);
         const isize row_threadgroup_size = std::min(nrow, max_threadgroup_size / col_threadgroup_size);
-        const isize val_threadgroup_nbytes = col_threadgroup_size * row_threadgroup_size * dtype->get_size();
+        const isize val_nbytes = std::max(in_lazy->get_itemsize(), out_lazy->get_itemsize());
+        const isize val_threadgroup_nbytes = col_threadgroup_size * row_threadgroup_size * val_nbytes;
         encoder.get_internal_encoder()->setThreadgroupMemoryLength(val_threadgroup_nbytes, 0);
         MTL::Size grid_size = MTL::Size::Make(ncol, nrow, 1);
         MTL::Size threadgroup_size = MTL::Size::Make(col_threadgroup_size, row_threadgroup_size, 1);
-        std::shared_ptr<ReduceOp> reduce_op = std::static_pointer_cast<ReduceOp>(out_op);
+        NodePtr<ReduceOp> reduce_op = static_pointer_cast<ReduceOp>(out_op);
 
-        if (reduce_op->get_mode() == ReduceMode::ARG) {
+        if (reduce_op->get_mode() == ReduceMode::ARG || idx_lazy != nullptr) {
             const isize arg_threadgroup_nbytes = col_threadgroup_size * row_threadgroup_size * sizeof(uint);
             encoder.get_internal_encoder()->setThreadgroupMemoryLength(arg_threadgroup_nbytes, 1);
         }
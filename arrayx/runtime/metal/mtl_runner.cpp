@@ -6,67 +6,129 @@ namespace ax::runtime::metal {
         switch (op->get_opcode()) {
         case Opcode::FULL: {
             alloc(lazy);
-            std::shared_ptr<FullOp> full_op = std::static_pointer_cast<FullOp>(op);
+            NodePtr<FullOp> full_op = static_pointer_cast<FullOp>(op);
             run_full_kernel(op, full_op->get_const());
             break;
         }
         case Opcode::ARANGE: {
             alloc(lazy);
-            std::shared_ptr<ArangeOp> arange_op = std::static_pointer_cast<ArangeOp>(op);
+            NodePtr<ArangeOp> arange_op = static_pointer_cast<ArangeOp>(op);
             run_arange_kernel(op, arange_op->get_start(), arange_op->get_step());
             break;
         }
+        case Opcode::NOP: {
+            // Leaves that already own a buffer, e.g. parameters and inputs, are left as they are
+            if (lazy->get_buff() != nullptr) {
+                break;
+            }
+            LazyPtr source = static_pointer_cast<Nop>(op)->get_source();
+            if (source == nullptr) {
+                // Persistent gradients are allocated zeroed the first time they are accumulated into
+                alloc(lazy, true);
+            } else if (source->get_buff() != nullptr) {
+                alloc(lazy, source);
+            } else {
+                throw std::runtime_error("Array " + lazy->get_id().str() + " was detached from array " + source->get_id().str() + " before it was evaluated.");
+            }
+            break;
+        }
         default:
             break;
         }
     }
 
     void MTLRunner::run_unary_op(OpPtr op) {
-        std::shared_ptr<UnaryOp> unary_op = std::static_pointer_cast<UnaryOp>(op);
+        NodePtr<UnaryOp> unary_op = static_pointer_cast<UnaryOp>(op);
         LazyPtr out_lazy = unary_op->get_lazy();
         OpPtr operand = unary_op->get_operand();
 
         if (unary_op->is_in_place()) {
             alloc(out_lazy, operand->get_lazy());
+        } else if (unary_op->get_buff_donor() != nullptr) {
+            alloc(out_lazy, unary_op->get_buff_donor());
         } else {
-            alloc(out_lazy);
+            // Counts are accumulated into zeros
+            alloc(out_lazy, unary_op->get_opcode() == Opcode::COUNT_MASK);
         }
 
-        if (unary_op->get_opcode() == Opcode::COPY) {
+        switch (unary_op->get_opcode()) {
+        case Opcode::COPY:
             run_copy_kernel(operand, op);
-        } else {
+            break;
+        case Opcode::PACK_MASK:
+            run_pack_mask_kernel(operand, op);
+            break;
+        case Opcode::COUNT_MASK:
+            run_count_mask_kernel(operand, op);
+            break;
+        case Opcode::SOFTMAX:
+        case Opcode::LOG_SOFTMAX:
+        case Opcode::LOGSUMEXP:
+            run_softmax_kernel(unary_op->get_opname(), operand, op);
+            break;
+        default:
             run_unary_kernel(unary_op->get_opname(), operand, op);
+            break;
         }
     }
 
     void MTLRunner::run_binary_op(OpPtr op) {
-        std::shared_ptr<BinaryOp> binary_op = std::static_pointer_cast<BinaryOp>(op);
+        NodePtr<BinaryOp> binary_op = static_pointer_cast<BinaryOp>(op);
         LazyPtr out_lazy = binary_op->get_lazy();
         OpPtr lop = binary_op->get_lhs();
         OpPtr rop = binary_op->get_rhs();
 
         if (binary_op->get_mode() == BinaryMode::ELMWISE) {
-            std::shared_ptr<ElmwiseBinaryOp> elmwise_op = std::static_pointer_cast<ElmwiseBinaryOp>(binary_op);
+            NodePtr<ElmwiseBinaryOp> elmwise_op = static_pointer_cast<ElmwiseBinaryOp>(binary_op);
             if (elmwise_op->is_in_place()) {
                 alloc(out_lazy, lop->get_lazy());
+            } else if (elmwise_op->get_buff_donor() != nullptr) {
+                alloc(out_lazy, elmwise_op->get_buff_donor());
             } else {
                 alloc(out_lazy);
             }
+        } else if (binary_op->get_buff_donor() != nullptr) {
+            alloc(out_lazy, binary_op->get_buff_donor());
         } else {
             alloc(out_lazy);
         }
 
         if (binary_op->get_mode() == BinaryMode::MATMUL) {
             run_matmul_kernel(lop, rop, op);
+        } else if (binary_op->get_mode() == BinaryMode::INDEX) {
+            run_index_grad_kernel(lop, rop, op);
+        } else if (binary_op->get_mode() == BinaryMode::MASK) {
+            run_mask_mul_kernel(lop, rop, op);
+        } else if (binary_op->get_mode() == BinaryMode::CONV) {
+            run_conv2d_kernel(binary_op->get_opname(), lop, rop, op, static_pointer_cast<ConvOp>(op)->get_params());
+        } else if (binary_op->get_opcode() == Opcode::CROSS_ENTROPY) {
+            run_cross_entropy_kernel(lop, rop, op);
+        } else if (binary_op->get_mode() == BinaryMode::ROW) {
+            run_softmax_grad_kernel(binary_op->get_opname(), lop, rop, op);
         } else {
             run_binary_kernel(binary_op->get_opname(), lop, rop, op);
         }
     }
 
+    void MTLRunner::run_ternary_op(OpPtr op) {
+        NodePtr<TernaryOp> ternary_op = static_pointer_cast<TernaryOp>(op);
+        alloc(ternary_op->get_lazy());
+        if (ternary_op->get_opcode() == Opcode::QMATMUL) {
+            run_qmatmul_kernel(ternary_op->get_first(), ternary_op->get_second(), ternary_op->get_third(), op);
+        } else if (ternary_op->get_opcode() == Opcode::LINEAR) {
+            NodePtr<LinearOp> linear_op = static_pointer_cast<LinearOp>(op);
+            run_linear_kernel(linear_op->get_first(), linear_op->get_second(), linear_op->get_third(), op, linear_op->get_activation());
+        } else if (ternary_op->get_opcode() == Opcode::CROSS_ENTROPY_GRAD) {
+            run_cross_entropy_grad_kernel(ternary_op->get_first(), ternary_op->get_second(), ternary_op->get_third(), op);
+        } else {
+            run_ternary_kernel(ternary_op->get_opname(), ternary_op->get_first(), ternary_op->get_second(), ternary_op->get_third(), op);
+        }
+    }
+
     void MTLRunner::run_transform_op(OpPtr op) {
         switch (op->get_opcode()) {
         case Opcode::RESHAPE: {
-            std::shared_ptr<ReshapeOp> reshape_op = std::static_pointer_cast<ReshapeOp>(op);
+            NodePtr<ReshapeOp> reshape_op = static_pointer_cast<ReshapeOp>(op);
             LazyPtr out_lazy = reshape_op->get_lazy();
             OpPtr operand = reshape_op->get_operand();
             LazyPtr in_lazy = operand->get_lazy();
@@ -99,7 +161,7 @@ namespace ax::runtime::metal {
             break;
         }
         case Opcode::ASTYPE: {
-            std::shared_ptr<AstypeOp> as_type_op = std::static_pointer_cast<AstypeOp>(op);
+            NodePtr<AstypeOp> as_type_op = static_pointer_cast<AstypeOp>(op);
             OpPtr operand = as_type_op->get_operand();
             alloc(as_type_op->get_lazy());
             run_copy_kernel(operand, op);
@@ -110,20 +172,74 @@ namespace ax::runtime::metal {
         }
     }
 
+    // Same reduction as the op but writing into the given array
+    // Extrema keep recording their indices into the op's own index array
+    static OpPtr make_accum_op(NodePtr<ReduceOp> reduce_op, LazyPtr accum_lazy) {
+        NodePtr<ExtremumOp> accum_op;
+        switch (reduce_op->get_opcode()) {
+        case Opcode::MAX:
+            accum_op = make_node<MaxOp>(accum_lazy, reduce_op->get_operand(), reduce_op->get_dims());
+            break;
+        case Opcode::MIN:
+            accum_op = make_node<MinOp>(accum_lazy, reduce_op->get_operand(), reduce_op->get_dims());
+            break;
+        default:
+            return make_node<SumOp>(accum_lazy, reduce_op->get_operand(), reduce_op->get_dims());
+        }
+        accum_op->set_index(static_pointer_cast<ExtremumOp>(reduce_op)->get_index());
+        return accum_op;
+    }
+
     void MTLRunner::run_reduce_op(OpPtr op) {
-        std::shared_ptr<ReduceOp> reduce_op = std::static_pointer_cast<ReduceOp>(op);
+        NodePtr<ReduceOp> reduce_op = static_pointer_cast<ReduceOp>(op);
         LazyPtr lazy = reduce_op->get_lazy();
         OpPtr operand = reduce_op->get_operand();
-        alloc(lazy);
+        auto accum_dtype = accum_dtype_by_dtype.find(lazy->get_dtype());
+        bool extremum = reduce_op->get_opcode() == Opcode::MAX || reduce_op->get_opcode() == Opcode::MIN;
+
+        if (reduce_op->get_mode() == ReduceMode::VALUE && accum_dtype != accum_dtype_by_dtype.end()) {
+            // Reduce into a wider scratch array and round it into the output once all partial results are in
+            LazyPtr accum_lazy = Lazy::empty(Shape(lazy->get_view()), accum_dtype->second, lazy->get_device());
+            OpPtr accum_op = make_accum_op(reduce_op, accum_lazy);
+            run_reduce_op(accum_op);
+            alloc(lazy);
+            run_copy_kernel(accum_op, op);
+            return;
+        }
+        if (lazy->get_dtype() == &i64 && reduce_op->get_opcode() != Opcode::SUM && reduce_op->get_mode() == ReduceMode::VALUE) {
+            // Metal has no 64-bit atomic max so the extrema are located by index and gathered by the host
+            LazyPtr idx_lazy = Lazy::empty(Shape(lazy->get_view()), &i32, lazy->get_device());
+            OpPtr idx_op;
+            if (reduce_op->get_opcode() == Opcode::MAX) {
+                idx_op = make_node<ArgmaxOp>(idx_lazy, operand, reduce_op->get_dims());
+            } else {
+                idx_op = make_node<ArgminOp>(idx_lazy, operand, reduce_op->get_dims());
+            }
+            run_reduce_op(idx_op);
+            alloc(lazy);
+            LazyPtr in_lazy = operand->get_lazy();
+            // Column reductions see the input as rows of columns and index within each row
+            isize ncol = reduce_op->get_dims().empty() ? 0 : in_lazy->get_view()[1];
+            const int32_t *idx = reinterpret_cast<const int32_t *>(idx_lazy->get_ptr());
+            for (isize row = 0; row < lazy->get_numel(); row++) {
+                std::memcpy(lazy->get_ptr() + row * lazy->get_itemsize(), in_lazy->strided_elm_ptr(row * ncol + idx[row]), lazy->get_itemsize());
+            }
+            return;
+        }
+        // Sums accumulate into zeros and arg operations use 0s as the default indices
+        // Max and min fill up the array with their own default value instead
+        alloc(lazy, reduce_op->get_opcode() == Opcode::SUM || reduce_op->get_mode() == ReduceMode::ARG);
 
-        // Fill up array with default value
-        // With arg operations, the array is already filled up with 0s, which are also the default indices
-        // Hence, arg operations do not need to fill up array
         if (reduce_op->get_opcode() == Opcode::MAX) {
             run_full_kernel(op, reduce_op->get_lazy()->get_dtype()->min());
         } else if (reduce_op->get_opcode() == Opcode::MIN) {
             run_full_kernel(op, reduce_op->get_lazy()->get_dtype()->max());
         }
+        // Tracked extrema record their indices, which start at the first element of each row
+        LazyPtr idx_lazy = extremum ? static_pointer_cast<ExtremumOp>(reduce_op)->get_index() : nullptr;
+        if (idx_lazy != nullptr) {
+            alloc(idx_lazy, true);
+        }
 
         if (reduce_op->get_dims().size() == 0) {
             // Reduce to one item
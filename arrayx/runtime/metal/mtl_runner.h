@@ -12,6 +12,20 @@ namespace ax::runtime::metal {
         void run_arange_kernel(OpPtr op, isize start, isize step) override;
         void run_binary_kernel(const std::string &name, OpPtr lop, OpPtr rop, OpPtr out_op) override;
         void run_matmul_kernel(OpPtr lop, OpPtr rop, OpPtr out_op) override;
+        void run_qmatmul_kernel(OpPtr lop, OpPtr rop, OpPtr scale_op, OpPtr out_op) override;
+        void run_linear_kernel(OpPtr in_op, OpPtr weight_op, OpPtr bias_op, OpPtr out_op, Activation activation) override;
+        void run_conv2d_kernel(const std::string &name, OpPtr lop, OpPtr rop, OpPtr out_op, const Conv2dParams &params) override;
+        // Runs a forward convolution as a matmul of the weight with the unfolded input
+        void run_conv2d_gemm(OpPtr in_op, OpPtr weight_op, OpPtr out_op, const Conv2dParams &params);
+        void run_index_grad_kernel(OpPtr idx_op, OpPtr grad_op, OpPtr out_op) override;
+        void run_pack_mask_kernel(OpPtr in_op, OpPtr out_op) override;
+        void run_count_mask_kernel(OpPtr mask_op, OpPtr out_op) override;
+        void run_mask_mul_kernel(OpPtr lop, OpPtr mask_op, OpPtr out_op) override;
+        void run_softmax_kernel(const std::string &name, OpPtr in_op, OpPtr out_op) override;
+        void run_softmax_grad_kernel(const std::string &name, OpPtr out_op, OpPtr grad_op, OpPtr in_grad_op) override;
+        void run_cross_entropy_kernel(OpPtr logits_op, OpPtr labels_op, OpPtr out_op) override;
+        void run_cross_entropy_grad_kernel(OpPtr logits_op, OpPtr labels_op, OpPtr grad_op, OpPtr in_grad_op) override;
+        void run_ternary_kernel(const std::string &name, OpPtr first_op, OpPtr second_op, OpPtr third_op, OpPtr out_op) override;
         void run_unary_kernel(const std::string &name, OpPtr in_op, OpPtr out_op) override;
         void run_copy_kernel(OpPtr in_op, OpPtr out_op) override;
         void run_reduce_all_kernel(const std::string &name, OpPtr in_op, OpPtr out_op) override;
@@ -19,20 +33,22 @@ namespace ax::runtime::metal {
         void run_initializer_op(OpPtr op) override;
         void run_unary_op(OpPtr op) override;
         void run_binary_op(OpPtr op) override;
+        void run_ternary_op(OpPtr op) override;
         void run_transform_op(OpPtr op) override;
 
         template <class O>
         void run_simple_transform_op(OpPtr op) {
-            auto transform_op = std::static_pointer_cast<O>(op);
+            auto transform_op = static_pointer_cast<O>(op);
             OpPtr operand = transform_op->get_operand();
             alloc(op->get_lazy(), operand->get_lazy());
         }
 
         void run_reduce_op(OpPtr op) override;
-        void alloc(LazyPtr lazy) override { lazy->init_buff(std::make_shared<Buffer>(ctx->get_allocator(), lazy->get_nbytes())); }
+        void alloc(LazyPtr lazy, bool zeroed = false) override { lazy->init_buff(make_node<Buffer>(ctx->get_allocator(), lazy->get_nbytes(), zeroed)); }
         void alloc(LazyPtr out_lazy, LazyPtr in_lazy) override { out_lazy->init_buff(in_lazy->get_buff()); }
 
     public:
         MTLRunner(std::shared_ptr<MTLContext> ctx) : ctx(ctx) {}
+        std::shared_ptr<Allocator> get_allocator() const override { return ctx->get_allocator(); }
     };
 } // namespace ax::runtime::metal
\ No newline at end of file
@@ -0,0 +1,91 @@
+#include "mtl_runner.h"
+
+namespace ax::runtime::metal {
+    // One threadgroup per row made of whole SIMD groups so that every lane takes part in the shuffles
+    static void dispatch_rows(CommandEncoder &encoder, isize nrow, isize ncol) {
+        const isize max_threadgroup_size = encoder.get_kernel()->get_state()->maxTotalThreadsPerThreadgroup();
+        const isize simd_size = encoder.get_kernel()->get_state()->threadExecutionWidth();
+        const isize threadgroup_size = std::min((ncol + simd_size - 1) / simd_size * simd_size, max_threadgroup_size);
+        encoder.dispatch_threadgroups(MTL::Size::Make(nrow, 1, 1), MTL::Size::Make(threadgroup_size, 1, 1));
+    }
+
+    void MTLRunner::run_softmax_kernel(const std::string &name, OpPtr in_op, OpPtr out_op) {
+        NS::AutoreleasePool *pool = NS::AutoreleasePool::alloc()->init();
+        CommandEncoder encoder(ctx);
+        LazyPtr in_lazy = in_op->get_lazy();
+        LazyPtr out_lazy = out_op->get_lazy();
+        isize ncol = in_lazy->get_view().back();
+        isize offset[] = {in_lazy->get_offset(), out_lazy->get_offset()};
+        encoder.encode_buffer(&ncol, sizeof(isize));
+        encoder.encode_buffer(offset, sizeof(isize) * 2);
+        encoder.encode_array(in_lazy);
+        encoder.encode_array(out_lazy);
+        std::string kernel_name = name + "_" + in_lazy->get_dtype()->str();
+        encoder.set_pipeline_state(kernel_name);
+        dispatch_rows(encoder, in_lazy->get_numel() / ncol, ncol);
+        encoder.wait_to_complete();
+        pool->release();
+    }
+
+    void MTLRunner::run_softmax_grad_kernel(const std::string &name, OpPtr out_op, OpPtr grad_op, OpPtr in_grad_op) {
+        NS::AutoreleasePool *pool = NS::AutoreleasePool::alloc()->init();
+        CommandEncoder encoder(ctx);
+        LazyPtr out_lazy = out_op->get_lazy();
+        LazyPtr grad_lazy = grad_op->get_lazy();
+        LazyPtr in_grad_lazy = in_grad_op->get_lazy();
+        isize ncol = out_lazy->get_view().back();
+        isize offset[] = {out_lazy->get_offset(), grad_lazy->get_offset(), in_grad_lazy->get_offset()};
+        encoder.encode_buffer(&ncol, sizeof(isize));
+        encoder.encode_buffer(offset, sizeof(isize) * 3);
+        encoder.encode_array(out_lazy);
+        encoder.encode_array(grad_lazy);
+        encoder.encode_array(in_grad_lazy);
+        std::string kernel_name = name + "_" + out_lazy->get_dtype()->str();
+        encoder.set_pipeline_state(kernel_name);
+        dispatch_rows(encoder, out_lazy->get_numel() / ncol, ncol);
+        encoder.wait_to_complete();
+        pool->release();
+    }
+
+    void MTLRunner::run_cross_entropy_kernel(OpPtr logits_op, OpPtr labels_op, OpPtr out_op) {
+        NS::AutoreleasePool *pool = NS::AutoreleasePool::alloc()->init();
+        CommandEncoder encoder(ctx);
+        LazyPtr logits_lazy = logits_op->get_lazy();
+        LazyPtr labels_lazy = labels_op->get_lazy();
+        LazyPtr out_lazy = out_op->get_lazy();
+        isize ncol = logits_lazy->get_view().back();
+        isize offset[] = {logits_lazy->get_offset(), labels_lazy->get_offset(), out_lazy->get_offset()};
+        encoder.encode_buffer(&ncol, sizeof(isize));
+        encoder.encode_buffer(offset, sizeof(isize) * 3);
+        encoder.encode_array(logits_lazy);
+        encoder.encode_array(labels_lazy);
+        encoder.encode_array(out_lazy);
+        std::string kernel_name = CrossEntropyOp::opname + "_" + logits_lazy->get_dtype()->str();
+        encoder.set_pipeline_state(kernel_name);
+        dispatch_rows(encoder, labels_lazy->get_numel(), ncol);
+        encoder.wait_to_complete();
+        pool->release();
+    }
+
+    void MTLRunner::run_cross_entropy_grad_kernel(OpPtr logits_op, OpPtr labels_op, OpPtr grad_op, OpPtr in_grad_op) {
+        NS::AutoreleasePool *pool = NS::AutoreleasePool::alloc()->init();
+        CommandEncoder encoder(ctx);
+        LazyPtr logits_lazy = logits_op->get_lazy();
+        LazyPtr labels_lazy = labels_op->get_lazy();
+        LazyPtr grad_lazy = grad_op->get_lazy();
+        LazyPtr in_grad_lazy = in_grad_op->get_lazy();
+        isize ncol = logits_lazy->get_view().back();
+        isize offset[] = {logits_lazy->get_offset(), labels_lazy->get_offset(), grad_lazy->get_offset(), in_grad_lazy->get_offset()};
+        encoder.encode_buffer(&ncol, sizeof(isize));
+        encoder.encode_buffer(offset, sizeof(isize) * 4);
+        encoder.encode_array(logits_lazy);
+        encoder.encode_array(labels_lazy);
+        encoder.encode_array(grad_lazy);
+        encoder.encode_array(in_grad_lazy);
+        std::string kernel_name = CrossEntropyGradOp::opname + "_" + logits_lazy->get_dtype()->str();
+        encoder.set_pipeline_state(kernel_name);
+        dispatch_rows(encoder, labels_lazy->get_numel(), ncol);
+        encoder.wait_to_complete();
+        pool->release();
+    }
+} // namespace ax::runtime::metal
@@ -1,7 +1,57 @@
 #include "runner.h"
 
 namespace ax::runtime {
+    std::vector<OpPtr> Runner::get_operands(OpPtr op) {
+        switch (op->get_optype()) {
+        case Optype::INITIALIZER:
+            return {};
+        case Optype::UNARY:
+            return {static_pointer_cast<UnaryOp>(op)->get_operand()};
+        case Optype::BINARY: {
+            NodePtr<BinaryOp> binary_op = static_pointer_cast<BinaryOp>(op);
+            return {binary_op->get_lhs(), binary_op->get_rhs()};
+        }
+        case Optype::TERNARY: {
+            NodePtr<TernaryOp> ternary_op = static_pointer_cast<TernaryOp>(op);
+            return {ternary_op->get_first(), ternary_op->get_second(), ternary_op->get_third()};
+        }
+        case Optype::TRANSFORM:
+            return {static_pointer_cast<TransformOp>(op)->get_operand()};
+        default:
+            return {static_pointer_cast<ReduceOp>(op)->get_operand()};
+        }
+    }
+
+    void Runner::prefetch(OpPtr op) {
+        std::shared_ptr<SpillManager> manager = get_spill_manager();
+        if (manager == nullptr) {
+            return;
+        }
+        for (auto &operand : get_operands(op)) {
+            manager->prefetch(operand->get_lazy()->get_buff());
+        }
+    }
+
+    void Runner::set_spill_manager(std::shared_ptr<SpillManager> spill_manager) {
+        std::shared_ptr<SpillManager> prev_manager = this->spill_manager.exchange(spill_manager);
+        if (prev_manager != nullptr) {
+            prev_manager->restore();
+        }
+    }
+
     void Runner::run(OpPtr op) {
+        // Attributes the buffers allocated while running the op to it
+        LazyPtr lazy = op->get_lazy();
+        AllocationScope scope(AllocationTag{op->get_opname(), lazy->get_id().get_data(), lazy->get_view().data(), lazy->get_view().size()});
+        // Kernels must read operands from resident memory
+        std::shared_ptr<SpillManager> manager = get_spill_manager();
+        std::vector<std::shared_ptr<Buffer>> in_buffs;
+        if (manager != nullptr) {
+            for (auto &operand : get_operands(op)) {
+                in_buffs.push_back(operand->get_lazy()->get_buff());
+            }
+        }
+        PinScope pins(manager, std::move(in_buffs));
         switch (op->get_optype()) {
         case Optype::INITIALIZER: {
             run_initializer_op(op);
@@ -15,6 +65,10 @@ namespace ax::runtime {
             run_binary_op(op);
             break;
         }
+        case Optype::TERNARY: {
+            run_ternary_op(op);
+            break;
+        }
         case Optype::TRANSFORM: {
             run_transform_op(op);
             break;
@@ -24,16 +78,24 @@ namespace ax::runtime {
             break;
         }
         }
+        pins.release(lazy->get_buff());
     }
 
     void Runner::forward(std::shared_ptr<ComputeGraph> graph) {
         for (auto iter = graph->cbegin(); iter != graph->cend(); ++iter) {
+            // Overlaps reading the next op's spilled operands with running the current op
+            if (std::next(iter) != graph->cend()) {
+                prefetch(*std::next(iter));
+            }
             run(*iter);
         }
     }
 
     void Runner::backward(std::shared_ptr<ComputeGraph> graph) {
         for (auto iter = graph->crbegin(); iter != graph->crend(); ++iter) {
+            if (std::next(iter) != graph->crend()) {
+                prefetch(*std::next(iter));
+            }
             run(*iter);
         }
     }
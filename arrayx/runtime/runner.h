@@ -1,18 +1,39 @@
 #pragma once
 
-#include "../device/buffer.h"
+#include "../device/spill_manager.h"
 #include "../graph/compute_graph.h"
+#include <atomic>
 
 namespace ax::runtime {
     using namespace ax::graph;
     using namespace ax::device;
 
     class Runner {
+    private:
+        // Swapped atomically since ops may be running on other threads
+        std::atomic<std::shared_ptr<SpillManager>> spill_manager;
+
+        static std::vector<OpPtr> get_operands(OpPtr op);
+        // Starts reading the spilled operands of the op from disk
+        void prefetch(OpPtr op);
+
     protected:
         virtual void run_full_kernel(OpPtr op, isize c) = 0;
         virtual void run_arange_kernel(OpPtr op, isize start, isize step) = 0;
         virtual void run_binary_kernel(const std::string &name, OpPtr lop, OpPtr rop, OpPtr out_op) = 0;
         virtual void run_matmul_kernel(OpPtr lop, OpPtr rop, OpPtr out_op) = 0;
+        virtual void run_qmatmul_kernel(OpPtr lop, OpPtr rop, OpPtr scale_op, OpPtr out_op) = 0;
+        virtual void run_linear_kernel(OpPtr in_op, OpPtr weight_op, OpPtr bias_op, OpPtr out_op, Activation activation) = 0;
+        virtual void run_conv2d_kernel(const std::string &name, OpPtr lop, OpPtr rop, OpPtr out_op, const Conv2dParams &params) = 0;
+        virtual void run_index_grad_kernel(OpPtr idx_op, OpPtr grad_op, OpPtr out_op) = 0;
+        virtual void run_pack_mask_kernel(OpPtr in_op, OpPtr out_op) = 0;
+        virtual void run_count_mask_kernel(OpPtr mask_op, OpPtr out_op) = 0;
+        virtual void run_mask_mul_kernel(OpPtr lop, OpPtr mask_op, OpPtr out_op) = 0;
+        virtual void run_softmax_kernel(const std::string &name, OpPtr in_op, OpPtr out_op) = 0;
+        virtual void run_softmax_grad_kernel(const std::string &name, OpPtr out_op, OpPtr grad_op, OpPtr in_grad_op) = 0;
+        virtual void run_cross_entropy_kernel(OpPtr logits_op, OpPtr labels_op, OpPtr out_op) = 0;
+        virtual void run_cross_entropy_grad_kernel(OpPtr logits_op, OpPtr labels_op, OpPtr grad_op, OpPtr in_grad_op) = 0;
+        virtual void run_ternary_kernel(const std::string &name, OpPtr first_op, OpPtr second_op, OpPtr third_op, OpPtr out_op) = 0;
         virtual void run_unary_kernel(const std::string &name, OpPtr in_op, OpPtr out_op) = 0;
         virtual void run_copy_kernel(OpPtr in_op, OpPtr out_op) = 0;
         virtual void run_reduce_all_kernel(const std::string &name, OpPtr in_op, OpPtr out_op) = 0;
@@ -20,9 +41,11 @@ namespace ax::runtime {
         virtual void run_initializer_op(OpPtr op) = 0;
         virtual void run_unary_op(OpPtr op) = 0;
         virtual void run_binary_op(OpPtr op) = 0;
+        virtual void run_ternary_op(OpPtr op) = 0;
         virtual void run_transform_op(OpPtr op) = 0;
         virtual void run_reduce_op(OpPtr op) = 0;
-        virtual void alloc(LazyPtr lazy) = 0;
+        // Kernels that accumulate into their output ask for a zeroed buffer
+        virtual void alloc(LazyPtr lazy, bool zeroed = false) = 0;
         virtual void alloc(LazyPtr out_lazy, LazyPtr in_lazy) = 0;
         void run(OpPtr op);
 
@@ -31,6 +54,10 @@ namespace ax::runtime {
         Runner(const Runner &) = delete;
         virtual ~Runner() = default;
         Runner &operator=(const Runner &) = delete;
+        virtual std::shared_ptr<Allocator> get_allocator() const = 0;
+        std::shared_ptr<SpillManager> get_spill_manager() const { return spill_manager.load(); }
+        // Spills cold buffers to disk once those in use exceed the budget, or disables spilling if null
+        void set_spill_manager(std::shared_ptr<SpillManager> spill_manager);
         void forward(std::shared_ptr<ComputeGraph> graph);
         void backward(std::shared_ptr<ComputeGraph> graph);
     };
@@ -4,6 +4,7 @@
 #include <bit>
 #include <cmath>
 #include <cstdlib>
+#include <cstring>
 #include <functional>
 #include <iomanip>
 #include <iostream>
@@ -19,16 +20,18 @@
 
 namespace ax::core {
     class Lazy;
-    using LazyPtr = std::shared_ptr<Lazy>;
+    template <class T>
+    class NodePtr;
+    using LazyPtr = NodePtr<Lazy>;
     using isize = int64_t;
 
-    template <class T>
-    inline uint64_t vsize(const std::vector<T> &v) {
-        return v.size() * sizeof(T);
+    template <class V>
+    inline uint64_t vsize(const V &v) {
+        return v.size() * sizeof(typename V::value_type);
     }
 
-    template <class T>
-    inline const std::string vstr(const std::vector<T> &v, const std::function<std::string(T)> &f) {
+    template <class T, class V>
+    inline const std::string vstr(const V &v, const std::function<std::string(T)> &f) {
         std::string s = "";
         for (size_t i = 0; i < v.size(); i++) {
             s += f(v[i]);
@@ -39,8 +42,9 @@ namespace ax::core {
         return s;
     }
 
-    template <class T>
-    inline const std::string vnumstr(const std::vector<T> &v) {
+    template <class V>
+    inline const std::string vnumstr(const V &v) {
+        using T = typename V::value_type;
         return vstr<T>(v, [](T a) { return std::to_string(a); });
     }
 } // namespace ax::core
\ No newline at end of file
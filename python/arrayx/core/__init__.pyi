@@ -1,6 +1,8 @@
 from collections.abc import Sequence
 import enum
 
+import arrayx.nn
+
 from numpy.typing import ArrayLike
 
 
@@ -27,19 +29,49 @@ class Dtype:
     def __str__(self) -> str:
         """String representation of dtype"""
 
+class F16(Dtype):
+    """16-bit floating point dtype"""
+
+class BF16(Dtype):
+    """16-bit brain floating point dtype"""
+
 class F32(Dtype):
     """32-bit floating point dtype"""
 
+class F64(Dtype):
+    """64-bit floating point dtype"""
+
+class I8(Dtype):
+    """8-bit integer dtype"""
+
+class I16(Dtype):
+    """16-bit integer dtype"""
+
 class I32(Dtype):
     """32-bit integer dtype"""
 
+class I64(Dtype):
+    """64-bit integer dtype"""
+
 class Bool(Dtype):
     """Boolean dtype"""
 
+f16: F16 = ...
+
+bf16: BF16 = ...
+
 f32: F32 = ...
 
+f64: F64 = ...
+
+i8: I8 = ...
+
+i16: I16 = ...
+
 i32: I32 = ...
 
+i64: I64 = ...
+
 b8: Bool = ...
 
 class Shape:
@@ -87,6 +119,68 @@ class Device:
     def __str__(self) -> str:
         """String representation of device"""
 
+class OpMemory:
+    @property
+    def opname(self) -> str:
+        """Name of the op that allocated the memory"""
+
+    @property
+    def id(self) -> int:
+        """ID of the op's array"""
+
+    @property
+    def view(self) -> list[int]:
+        """View of the op's array"""
+
+    @property
+    def nbytes(self) -> int:
+        """Live bytes allocated by the op"""
+
+class MemoryStats:
+    @property
+    def current_bytes(self) -> int:
+        """Bytes currently allocated"""
+
+    @property
+    def peak_bytes(self) -> int:
+        """Maximum bytes allocated since the last reset"""
+
+    @property
+    def reserved_bytes(self) -> int:
+        """Bytes held from the system"""
+
+    @property
+    def cached_bytes(self) -> int:
+        """Bytes kept cached for reuse"""
+
+    @property
+    def alloc_count(self) -> int:
+        """Number of allocations"""
+
+    @property
+    def free_count(self) -> int:
+        """Number of frees"""
+
+    @property
+    def cache_hits(self) -> int:
+        """Number of allocations served from the cache"""
+
+    @property
+    def cache_misses(self) -> int:
+        """Number of allocations that needed new memory"""
+
+    @property
+    def cache_hit_rate(self) -> float:
+        """Fraction of allocations served from the cache"""
+
+    @property
+    def fragmentation(self) -> float:
+        """Fraction of cached bytes outside the largest free block"""
+
+    @property
+    def ops(self) -> list[OpMemory]:
+        """Live bytes grouped by the op that allocated them"""
+
 class Backend:
     @staticmethod
     def init() -> None:
@@ -96,6 +190,52 @@ class Backend:
     def cleanup() -> None:
         """Shutdown backend"""
 
+    @staticmethod
+    def trim_cache() -> None:
+        """Release cached device memory"""
+
+    @staticmethod
+    def set_cache_cap(nbytes: int) -> None:
+        """Set the maximum number of bytes of device memory kept cached"""
+
+    @staticmethod
+    def enable_spill(budget: int, dir: str = '') -> None:
+        """Spill cold buffers to disk once more than budget bytes are in use"""
+
+    @staticmethod
+    def disable_spill() -> None:
+        """Fault spilled buffers back in and stop spilling"""
+
+    @staticmethod
+    def spilled_bytes(device: str = 'mps:0') -> int:
+        """Get the number of bytes of device buffers spilled to disk"""
+
+    @staticmethod
+    def memory_stats(device: str = 'mps:0') -> MemoryStats:
+        """Get device memory statistics"""
+
+    @staticmethod
+    def reset_peak_memory_stats() -> None:
+        """Reset the peak memory of every device to its current usage"""
+
+def is_grad_enabled() -> bool:
+    """Check if new operations are tracked for gradients"""
+
+def set_grad_enabled(enabled: bool) -> None:
+    """Enable/disable gradient tracking for new operations"""
+
+def is_inference_mode() -> bool:
+    """Check if new operations are created in inference mode"""
+
+def set_inference_mode(enabled: bool) -> None:
+    """Enable/disable inference mode for new operations"""
+
+def get_autocast_dtype() -> Dtype | None:
+    """Get the low precision dtype new operations are autocast to"""
+
+def set_autocast_dtype(dtype: Dtype | None) -> None:
+    """Set the low precision dtype new operations are autocast to, None disables autocasting"""
+
 class Array:
     @property
     def id(self) -> str:
@@ -245,12 +385,33 @@ class Array:
     def __matmul__(self, rhs: Array) -> Array:
         """Matrix multiply two arrays"""
 
+    def quantize(self, scale: Array) -> Array:
+        """Quantize array to i8 with the given scales"""
+
+    def dequantize(self, scale: Array) -> Array:
+        """Dequantize i8 array with the given scales"""
+
+    def qmatmul(self, rhs: Array, scale: Array) -> Array:
+        """Matrix multiply two i8 arrays and scale the i32 results"""
+
+    def linear(self, weight: Array, bias: Array, activation: arrayx.nn.Activation = arrayx.nn.Activation.NONE) -> Array:
+        """Linear layer with bias and activation fused into the matmul"""
+
+    def conv2d(self, weight: Array, stride: Sequence[int] = [1, 1], padding: Sequence[int] = [0, 0], dilation: Sequence[int] = [1, 1], groups: int = 1) -> Array:
+        """2D convolution of NCHW array with (out_channels, in_channels / groups, KH, KW) weight"""
+
     def detach(self) -> Array:
         """Detach array from computation graph"""
 
     def exp(self, in_place: bool = False) -> Array:
         """Compute exponential of array elements"""
 
+    def gelu(self, in_place: bool = False) -> Array:
+        """Compute GELU of array elements with the tanh approximation"""
+
+    def silu(self, in_place: bool = False) -> Array:
+        """Compute SiLU of array elements"""
+
     def log(self, in_place: bool = False) -> Array:
         """Compute natural logarithm of array elements"""
 
@@ -269,6 +430,15 @@ class Array:
     def recip(self, in_place: bool = False) -> Array:
         """Compute reciprocal of array elements"""
 
+    def softmax(self) -> Array:
+        """Softmax over the last dimension"""
+
+    def log_softmax(self) -> Array:
+        """Log-softmax over the last dimension"""
+
+    def cross_entropy(self, labels: Array) -> Array:
+        """Cross-entropy of each row of logits against its integer class label"""
+
     def __eq__(self, rhs: object) -> Array:
         """Element-wise equality comparison"""
 
@@ -293,6 +463,12 @@ class Array:
     def maximum(self, rhs: object) -> Array:
         """Element-wise maximum comparison"""
 
+    def pack_mask(self) -> Array:
+        """Pack boolean array into i32 words of 32 bits"""
+
+    def mask_mul(self, mask: Array) -> Array:
+        """Zero out elements where the boolean or packed mask is not set"""
+
     def sum(self, dims: Sequence[int] = []) -> Array:
         """Sum array elements along specified dimensions"""
 
@@ -311,6 +487,18 @@ class Array:
     def argmin(self, dims: Sequence[int] = []) -> Array:
         """Indices of minimum values along specified dimensions"""
 
+    def logsumexp(self) -> Array:
+        """Log of the sum of exponentials over the last dimension"""
+
+    def count_nonzero(self) -> Array:
+        """Number of nonzero elements"""
+
+    def any(self) -> Array:
+        """Whether any element is nonzero"""
+
+    def all(self) -> Array:
+        """Whether all elements are nonzero"""
+
     def broadcast(self, view: Sequence[int]) -> Array:
         """Broadcast array to new shape"""
 
@@ -1,17 +1,78 @@
+from collections.abc import Callable, Sequence
+from typing import overload
+
+import enum
+
 import arrayx.core
 
 
+class Activation(enum.Enum):
+    NONE = 0
+
+    RELU = 1
+
+    GELU = 2
+
+    SILU = 3
+
+class QuantizedWeight:
+    def __init__(self, weight: arrayx.core.Array, scale: arrayx.core.Array) -> None:
+        """Linear weight quantized to i8 with one scale per output channel"""
+
+    @property
+    def weight(self) -> arrayx.core.Array:
+        """Quantized weight"""
+
+    @weight.setter
+    def weight(self, arg: arrayx.core.Array, /) -> None: ...
+
+    @property
+    def scale(self) -> arrayx.core.Array:
+        """Scale of each output channel"""
+
+    @scale.setter
+    def scale(self, arg: arrayx.core.Array, /) -> None: ...
+
+@overload
 def linear(x: arrayx.core.Array, weight: arrayx.core.Array) -> arrayx.core.Array:
     """Functional linear without bias"""
 
+@overload
+def linear(x: arrayx.core.Array, weight: QuantizedWeight) -> arrayx.core.Array:
+    """Functional linear with quantized weight"""
+
+@overload
+def linear(x: arrayx.core.Array, weight: arrayx.core.Array, bias: arrayx.core.Array, activation: Activation) -> arrayx.core.Array:
+    """Functional linear with bias and activation fused into the matmul"""
+
+@overload
 def linear_with_bias(x: arrayx.core.Array, weight: arrayx.core.Array, bias: arrayx.core.Array) -> arrayx.core.Array:
     """Functional linear with bias"""
 
+@overload
+def linear_with_bias(x: arrayx.core.Array, weight: QuantizedWeight, bias: arrayx.core.Array) -> arrayx.core.Array:
+    """Functional linear with quantized weight and bias"""
+
+def quantize_weight(weight: arrayx.core.Array) -> QuantizedWeight:
+    """Quantize linear weight to i8 with one scale per output channel"""
+
+def conv2d(x: arrayx.core.Array, weight: arrayx.core.Array, bias: arrayx.core.Array | None = None, stride: Sequence[int] = [1, 1], padding: Sequence[int] = [0, 0], dilation: Sequence[int] = [1, 1], groups: int = 1) -> arrayx.core.Array:
+    """Functional 2D convolution with optional per-channel bias"""
+
 def relu(x: arrayx.core.Array) -> arrayx.core.Array:
     """ReLU activation function"""
 
+def gelu(x: arrayx.core.Array) -> arrayx.core.Array:
+    """GELU activation function with the tanh approximation"""
+
+def silu(x: arrayx.core.Array) -> arrayx.core.Array:
+    """SiLU activation function"""
+
 def onehot(x: arrayx.core.Array, num_classes: int = -1) -> arrayx.core.Array:
     """One-hot encode input array"""
 
 def cross_entropy_loss(x: arrayx.core.Array, y: arrayx.core.Array) -> arrayx.core.Array:
     """Compute cross-entropy loss between input x and target y"""
+
+def vmap(f: Callable[[Sequence[arrayx.core.Array]], arrayx.core.Array], inputs: Sequence[arrayx.core.Array], in_dims: Sequence[int | None]) -> arrayx.core.Array:
+    """Run a per-example function on a batch of inputs as one batched graph"""
@@ -13,6 +13,23 @@ class Optimizer:
     def step(self) -> None:
         """Update module parameters"""
 
+    def zero_grad(self) -> None:
+        """Reset accumulated parameter gradients to zero"""
+
 class GradientDescent(Optimizer):
     def __init__(self, params: Sequence[arrayx.core.Array], lr: float = 0.001) -> None:
         """Gradient Descent optimizer"""
+
+class GradScaler:
+    def __init__(self, init_scale: float = 65536.0, growth_factor: float = 2.0, backoff_factor: float = 0.5, growth_interval: int = 2000) -> None:
+        """Dynamic loss scaler for low precision backward passes"""
+
+    @property
+    def scale(self) -> float:
+        """Current loss scale"""
+
+    def scale_loss(self, loss: arrayx.core.Array) -> arrayx.core.Array:
+        """Multiply loss by the current scale"""
+
+    def step(self, optimizer: Optimizer) -> bool:
+        """Unscale gradients and step the optimizer unless they overflowed"""
@@ -1,5 +1,15 @@
 from contextlib import contextmanager
-from arrayx.core import Backend
+from arrayx.core import (
+    Backend,
+    is_grad_enabled,
+    set_grad_enabled,
+    is_inference_mode,
+    set_inference_mode,
+    get_autocast_dtype,
+    set_autocast_dtype,
+    f16,
+)
+from arrayx import nn
 
 
 @contextmanager
@@ -9,3 +19,45 @@ def context():
         yield
     finally:
         Backend.cleanup()
+
+
+@contextmanager
+def no_grad():
+    prev_enabled = is_grad_enabled()
+    try:
+        set_grad_enabled(False)
+        yield
+    finally:
+        set_grad_enabled(prev_enabled)
+
+
+@contextmanager
+def inference_mode():
+    prev_enabled = is_grad_enabled()
+    prev_inference = is_inference_mode()
+    try:
+        set_grad_enabled(False)
+        set_inference_mode(True)
+        yield
+    finally:
+        set_grad_enabled(prev_enabled)
+        set_inference_mode(prev_inference)
+
+
+@contextmanager
+def autocast(dtype=f16):
+    prev_dtype = get_autocast_dtype()
+    try:
+        set_autocast_dtype(dtype)
+        yield
+    finally:
+        set_autocast_dtype(prev_dtype)
+
+
+def vmap(f, in_dims=0):
+    # Traces f once per call with a symbolic batch dimension instead of looping over examples
+    def batched_f(*args):
+        dims = list(in_dims) if isinstance(in_dims, (list, tuple)) else [in_dims]
+        return nn.vmap(lambda inputs: f(*inputs), list(args), dims)
+
+    return batched_f
@@ -0,0 +1,59 @@
+from arrayx.core import Array
+from arrayx.nn import conv2d
+import ax
+import numpy as np
+import time
+import torch
+
+
+# (input shape, out_channels, kernel, stride, padding, groups) covering each way conv2d runs
+cases = [
+    ([8, 3, 64, 64], 16, [3, 3], [1, 1], [1, 1], 1),  # Short windows run directly
+    ([8, 32, 32, 32], 64, [3, 3], [1, 1], [1, 1], 1),  # Long windows lowered to a matmul
+    ([8, 64, 32, 32], 64, [1, 1], [1, 1], [0, 0], 1),  # Pointwise matmul without unfolding
+    ([8, 64, 32, 32], 64, [3, 3], [1, 1], [1, 1], 64),  # Depthwise runs directly
+]
+
+
+def bench(f, iters):
+    f()
+    start = time.perf_counter()
+    for _ in range(iters):
+        f()
+    return (time.perf_counter() - start) / iters * 1e3
+
+
+def bench_conv2d(view, out_channels, kernel, stride, padding, groups, iters=20):
+    x = np.random.randn(*view).astype(np.float32)
+    w = np.random.randn(out_channels, view[1] // groups, *kernel).astype(np.float32)
+    arr_x = Array.from_numpy(x)
+    arr_w = Array.from_numpy(w)
+
+    def forward():
+        conv2d(arr_x, arr_w, None, stride, padding, [1, 1], groups).eval()
+
+    def backward():
+        conv2d(arr_x, arr_w, None, stride, padding, [1, 1], groups).sum().backward()
+
+    device = "mps" if torch.backends.mps.is_available() else "cpu"
+    t_x = torch.from_numpy(x).to(device).requires_grad_(True)
+    t_w = torch.from_numpy(w).to(device).requires_grad_(True)
+
+    def t_forward():
+        torch.nn.functional.conv2d(t_x, t_w, None, stride, padding, 1, groups)
+        if device == "mps":
+            torch.mps.synchronize()
+
+    def t_backward():
+        torch.nn.functional.conv2d(t_x, t_w, None, stride, padding, 1, groups).sum().backward()
+        if device == "mps":
+            torch.mps.synchronize()
+
+    print(f"{view}, {out_channels}, {kernel}, groups={groups}: "
+          f"forward {bench(forward, iters):.2f}ms (torch {bench(t_forward, iters):.2f}ms), "
+          f"forward+backward {bench(backward, iters):.2f}ms (torch {bench(t_backward, iters):.2f}ms)")
+
+
+with ax.context():
+    for case in cases:
+        bench_conv2d(*case)
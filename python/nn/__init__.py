@@ -1,7 +1,7 @@
 from __future__ import annotations
 import numpy as np
 from arrayx.core import Array, DtypeType, f32, i32
-from arrayx.nn import linear, linear_with_bias
+from arrayx.nn import Activation, conv2d, linear, linear_with_bias
 from collections.abc import Sequence
 from typing import Callable
 
@@ -64,8 +64,12 @@ class Module:
 
 
 class Linear(Module):
-    def __init__(self, in_features: int, out_features: int, bias: bool = True):
+    def __init__(self, in_features: int, out_features: int, bias: bool = True, activation: Activation = Activation.NONE):
         super().__init__()
+        # Activations are only fused with layers that have a bias
+        if activation != Activation.NONE and not bias:
+            raise ValueError("Fused activations require a bias.")
+        self.__activation = activation
         k = np.sqrt(1 / in_features)
         # Use numpy to randomize for now
         self.__npw = np.random.uniform(-k, k, (out_features, in_features)).astype(np.float32)
@@ -85,4 +89,51 @@ class Linear(Module):
         return self.__b
 
     def forward(self, x: Array):
-        return linear(x, self.__w) if self.__b is None else linear_with_bias(x, self.__w, self.__b)
+        if self.__b is None:
+            return linear(x, self.__w)
+        if self.__activation == Activation.NONE:
+            return linear_with_bias(x, self.__w, self.__b)
+        return linear(x, self.__w, self.__b, self.__activation)
+
+
+class Conv2d(Module):
+    def __init__(
+        self,
+        in_channels: int,
+        out_channels: int,
+        kernel_size: int | Sequence[int],
+        stride: int | Sequence[int] = 1,
+        padding: int | Sequence[int] = 0,
+        dilation: int | Sequence[int] = 1,
+        groups: int = 1,
+        bias: bool = True,
+    ):
+        super().__init__()
+        if in_channels % groups != 0 or out_channels % groups != 0:
+            raise ValueError("Channels must be divisible by groups.")
+        pair = lambda x: [x, x] if isinstance(x, int) else list(x)
+        self.__stride = pair(stride)
+        self.__padding = pair(padding)
+        self.__dilation = pair(dilation)
+        self.__groups = groups
+        kernel_size = pair(kernel_size)
+        k = np.sqrt(groups / (in_channels * kernel_size[0] * kernel_size[1]))
+        # Use numpy to randomize for now
+        self.__npw = np.random.uniform(-k, k, (out_channels, in_channels // groups, *kernel_size)).astype(np.float32)
+        self.__w = Array.from_numpy(self.__npw)
+        if bias:
+            self.__npb = np.random.uniform(-k, k, (out_channels)).astype(np.float32)
+            self.__b = Array.from_numpy(self.__npb)
+        else:
+            self.__b = None
+
+    @property
+    def w(self):
+        return self.__w
+
+    @property
+    def b(self):
+        return self.__b
+
+    def forward(self, x: Array):
+        return conv2d(x, self.__w, self.__b, self.__stride, self.__padding, self.__dilation, self.__groups)
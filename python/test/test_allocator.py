@@ -0,0 +1,53 @@
+from arrayx.core import Array, Backend
+import numpy as np
+
+
+class TestAllocator:
+    @classmethod
+    def setup_class(cls):
+        """Run once before all tests in the class"""
+        print("\nSetting up TestAllocator class...")
+        # Add any setup code here
+        Backend.init()
+
+    @classmethod
+    def teardown_class(cls):
+        """Run once after all tests in the class"""
+        print("\nTearing down TestAllocator class...")
+        # Add any cleanup code here
+        Backend.cleanup()
+
+    def test_cached_buffers(self):
+        # Buffers recycled by the allocator must not leak values from earlier arrays
+        for _ in range(3):
+            arr1 = Array.full([64, 33], 7.0)
+            assert np.allclose(arr1.numpy(), np.full([64, 33], 7.0, dtype=np.float32))
+            del arr1
+            arr2 = Array.zeros([64, 33]) + Array.arange([64, 33], 0, 1)
+            assert np.allclose(arr2.numpy(), np.arange(64 * 33, dtype=np.float32).reshape(64, 33))
+            del arr2
+        Backend.set_cache_cap(1 << 20)
+        Backend.trim_cache()
+        arr3 = Array.ones([1024, 1024])
+        assert np.allclose(arr3.numpy(), np.ones([1024, 1024], dtype=np.float32))
+        Backend.set_cache_cap(1 << 62)
+
+    def test_memory_stats(self):
+        Backend.reset_peak_memory_stats()
+        stats1 = Backend.memory_stats()
+        arr1 = Array.full([256, 256], 3.0)
+        arr1.eval()
+        stats2 = Backend.memory_stats()
+        assert stats2.current_bytes >= stats1.current_bytes + arr1.nbytes
+        assert stats2.peak_bytes >= stats2.current_bytes
+        assert stats2.alloc_count > stats1.alloc_count
+        assert stats2.cache_hits + stats2.cache_misses == stats2.alloc_count
+        assert 0 <= stats2.fragmentation <= 1
+        # The buffer is attributed to the op that allocated it
+        assert any(op.id == int(arr1.id) and op.nbytes >= arr1.nbytes for op in stats2.ops)
+        del arr1
+        stats3 = Backend.memory_stats()
+        assert stats3.current_bytes < stats2.current_bytes
+        assert stats3.peak_bytes == stats2.peak_bytes
+        Backend.reset_peak_memory_stats()
+        assert Backend.memory_stats().peak_bytes == stats3.current_bytes
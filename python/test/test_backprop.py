@@ -1,4 +1,5 @@
-from arrayx.core import Array, Backend, Shape
+from arrayx.core import Array, Backend, Shape, f32
+import pytest
 import numpy as np
 import torch
 
@@ -564,3 +565,100 @@ class TestBackprop:
         compare_grads(arr1.grad, t1.grad, "arr1")
         compare_grads(arr2.grad, t2.grad, "arr2")
         compare_grads(arr3.grad, t3.grad, "arr3")
+
+    def test_max_min_reduce_backprop(self):
+        """Test backprop through max/min reductions"""
+        print("\nTesting max/min reduction backprop:")
+        x = torch.randn(7, 13, 5, dtype=torch.float32)
+        for dims in [[], [1], [0, 2]]:
+            arr1 = Array.from_numpy(x.numpy())
+            # Backward scatters into the indices located by the forward reductions
+            arr_max = arr1.max(dims)
+            arr_min = arr1.min(dims)
+            arr2 = (arr_max * 2.0 + arr_min).sum()
+            arr2.backward()
+            t1 = x.clone().requires_grad_(True)
+            tdims = list(range(x.ndim)) if not dims else dims
+            t2 = (t1.amax(dim=tdims) * 2.0 + t1.amin(dim=tdims)).sum()
+            t2.backward()
+            assert np.array_equal(arr_max.numpy().reshape(-1), x.amax(dim=tdims).numpy().reshape(-1))
+            assert np.array_equal(arr_min.numpy().reshape(-1), x.amin(dim=tdims).numpy().reshape(-1))
+            compare_grads(arr1.grad, t1.grad, f"arr1 (dims={dims})")
+        # Half reductions record their indices while reducing into f32
+        x = torch.randn(9, 33, dtype=torch.float16)
+        for dims in [[], [1]]:
+            arr1 = Array.from_numpy(x.numpy())
+            arr_max = arr1.max(dims)
+            arr_max.sum().backward()
+            t1 = x.clone().float().requires_grad_(True)
+            tdims = list(range(x.ndim)) if not dims else dims
+            t1.amax(dim=tdims).sum().backward()
+            assert np.array_equal(arr_max.numpy().reshape(-1), x.amax(dim=tdims).numpy().reshape(-1))
+            compare_grads(arr1.grad.astype(f32), t1.grad, f"arr1 (f16, dims={dims})")
+
+    def test_relu_backprop(self):
+        """Test backprop through maximum with a scalar"""
+        print("\nTesting relu backprop:")
+        np1 = np.random.randn(64, 128).astype(np.float32)
+        arr1 = Array.from_numpy(np1)
+        arr2 = arr1.maximum(0.0).minimum(1.0)
+        arr3 = (arr2 * arr2).sum()
+        arr3.backward()
+        t1 = torch.from_numpy(np1).requires_grad_(True)
+        t2 = t1.clamp(0.0, 1.0)
+        t3 = (t2 * t2).sum()
+        t3.backward()
+        compare_grads(arr1.grad, t1.grad, "arr1")
+
+    def test_inplace_backprop(self):
+        """Test backprop through in-place operations that do not overwrite saved arrays"""
+        print("\nTesting in-place backprop:")
+        np1 = np.random.randn(17, 23).astype(np.float32)
+        arr1 = Array.from_numpy(np1)
+        arr2 = arr1 + 1.0
+        arr2 += 1.0
+        arr3 = arr2.exp(in_place=True)
+        arr4 = arr3.sum()
+        arr4.backward()
+        t1 = torch.from_numpy(np1).requires_grad_(True)
+        t2 = t1 + 1.0
+        t2 += 1.0
+        t3 = t2.exp_()
+        t4 = t3.sum()
+        t4.backward()
+        assert torch.allclose(arr3.torch(), t3, atol=1e-3, rtol=1e-4)
+        compare_grads(arr1.grad, t1.grad, "arr1")
+
+    def test_inplace_modified_saved_array(self):
+        """Test backprop raises when an array saved for backward is modified in-place"""
+        print("\nTesting in-place modification of saved arrays:")
+        np1 = np.random.randn(17, 23).astype(np.float32)
+        # exp saves its output
+        arr1 = Array.from_numpy(np1)
+        arr2 = arr1.exp()
+        arr3 = arr2 + 0.0
+        arr2 += 1.0
+        arr4 = (arr2 + arr3).sum()
+        with pytest.raises(RuntimeError):
+            arr4.backward()
+        # sq saves its input which is overwritten by the in-place variant
+        arr5 = Array.from_numpy(np1) * 3.0
+        arr6 = arr5.sq(in_place=True).sum()
+        with pytest.raises(RuntimeError):
+            arr6.backward()
+
+    def test_backprop_mixed_dtypes(self):
+        """Test integer operands of promoted ops take no gradient"""
+        print("\nTesting backprop through mixed dtypes:")
+        np1 = np.random.randn(13, 7).astype(np.float32)
+        np2 = np.random.randint(-3, 4, size=[7]).astype(np.int32)
+        arr1 = Array.from_numpy(np1)
+        arr2 = Array.from_numpy(np2)
+        arr3 = (arr1 * arr2).maximum(arr2 - 1).sum()
+        arr3.backward()
+        t1 = torch.from_numpy(np1).requires_grad_(True)
+        t2 = torch.from_numpy(np2)
+        t3 = (t1 * t2).maximum(t2 - 1).sum()
+        t3.backward()
+        compare_grads(arr1.grad, t1.grad, "arr1")
+        assert arr2.grad is None
@@ -1,8 +1,9 @@
 from __future__ import annotations
 from arrayx.core import Array, Backend
-from arrayx.nn import relu, onehot, cross_entropy_loss
+from arrayx.nn import Activation, linear, relu, onehot, cross_entropy_loss
 from arrayx.optim import GradientDescent
 from mnist import MnistModel
+import ax
 import nn
 import numpy as np
 import torch
@@ -56,6 +57,60 @@ class TestBasicNN:
         assert torch.allclose(arr2.torch(), t2, atol=1e-3, rtol=0)
         assert torch.allclose(arr1.grad.torch(), t1.grad, atol=1e-3, rtol=0)
 
+    def test_fused_linear(self):
+        x = np.random.randn(2, 5, 64).astype(np.float32)
+        w = (np.random.randn(32, 64) * 0.1).astype(np.float32)
+        b = np.random.randn(32).astype(np.float32)
+        # Weights the outputs so that the upstream gradient is not uniform
+        g = np.random.randn(2, 5, 32).astype(np.float32)
+        activations = {
+            Activation.NONE: lambda t: t,
+            Activation.RELU: torch.relu,
+            Activation.GELU: lambda t: torch.nn.functional.gelu(t, approximate="tanh"),
+            Activation.SILU: torch.nn.functional.silu,
+        }
+        for activation, torch_activation in activations.items():
+            arr_x = Array.from_numpy(x)
+            arr_w = Array.from_numpy(w)
+            arr_b = Array.from_numpy(b)
+            out = linear(arr_x, arr_w, arr_b, activation)
+            (out * Array.from_numpy(g)).sum().backward()
+            t_x = torch.from_numpy(x).requires_grad_(True)
+            t_w = torch.from_numpy(w).requires_grad_(True)
+            t_b = torch.from_numpy(b).requires_grad_(True)
+            t_out = torch_activation(t_x @ t_w.T + t_b)
+            (t_out * torch.from_numpy(g)).sum().backward()
+            assert out.view == [2, 5, 32]
+            assert torch.allclose(out.torch(), t_out, atol=1e-4, rtol=1e-4), activation
+            assert torch.allclose(arr_x.grad.torch(), t_x.grad, atol=1e-4, rtol=1e-4), activation
+            assert torch.allclose(arr_w.grad.torch(), t_w.grad, atol=1e-4, rtol=1e-4), activation
+            assert torch.allclose(arr_b.grad.torch(), t_b.grad, atol=1e-4, rtol=1e-4), activation
+            # Untracked layers apply every activation in the epilogue
+            with ax.no_grad():
+                fused_out = linear(arr_x, arr_w, arr_b, activation)
+            assert torch.allclose(fused_out.torch(), t_out, atol=1e-4, rtol=1e-4), activation
+
+    def test_softmax(self):
+        # Rows longer than a threadgroup are scanned in several strides
+        for shape in [(4, 7, 10), (3, 2050)]:
+            x = (np.random.randn(*shape) * 5).astype(np.float32)
+            for name in ["softmax", "log_softmax", "logsumexp"]:
+                # Weights the outputs so that the upstream gradient is not uniform
+                w = np.random.randn(*shape[:-1], 1 if name == "logsumexp" else shape[-1]).astype(np.float32)
+                arr1 = Array.from_numpy(x)
+                arr2 = getattr(arr1, name)()
+                arr3 = (arr2 * Array.from_numpy(w)).sum()
+                arr3.backward()
+                t1 = torch.from_numpy(x).requires_grad_(True)
+                if name == "logsumexp":
+                    t2 = torch.logsumexp(t1, dim=-1, keepdim=True)
+                else:
+                    t2 = getattr(torch, name)(t1, dim=-1)
+                t3 = (t2 * torch.from_numpy(w)).sum()
+                t3.backward()
+                assert torch.allclose(arr2.torch(), t2, atol=1e-4, rtol=1e-4), name
+                assert torch.allclose(arr1.grad.torch(), t1.grad, atol=1e-4, rtol=1e-4), name
+
     def test_onehot(self):
         x = np.random.randint(0, 10, (64,), dtype=np.int32)
         arr1 = Array.from_numpy(x)
@@ -79,6 +134,24 @@ class TestBasicNN:
         assert torch.allclose(loss1.torch(), loss2, atol=1e-3, rtol=0)
         assert torch.allclose(arr1.grad.torch(), t1.grad, atol=1e-3, rtol=0)
 
+    def test_cross_entropy_rows(self):
+        # Batched rows wider than a threadgroup with labels of both integer widths
+        x = (np.random.randn(3, 4, 2050) * 5).astype(np.float32)
+        w = np.random.randn(3, 4).astype(np.float32)
+        for dtype in [np.int32, np.int64]:
+            y = np.random.randint(0, 2050, (3, 4)).astype(dtype)
+            arr1 = Array.from_numpy(x)
+            arr2 = arr1.cross_entropy(Array.from_numpy(y))
+            arr3 = (arr2 * Array.from_numpy(w)).sum()
+            arr3.backward()
+            t1 = torch.from_numpy(x).requires_grad_(True)
+            t2 = torch.nn.functional.cross_entropy(t1.transpose(1, 2), torch.from_numpy(y).type(torch.int64), reduction="none")
+            t3 = (t2 * torch.from_numpy(w)).sum()
+            t3.backward()
+            assert arr2.view == [3, 4]
+            assert torch.allclose(arr2.torch(), t2, atol=1e-4, rtol=1e-4)
+            assert torch.allclose(arr1.grad.torch(), t1.grad, atol=1e-4, rtol=1e-4)
+
     def test_single_pass(self):
         # Input data
         x = np.random.randn(64, 784).astype(np.float32)
@@ -246,3 +319,94 @@ class TestBasicNN:
             assert torch.allclose(model.linear1.b.torch(), torch_model[0].bias.data, atol=1e-3, rtol=0)
             assert torch.allclose(model.linear2.w.torch(), torch_model[2].weight.data, atol=1e-3, rtol=0)
             assert torch.allclose(model.linear2.b.torch(), torch_model[2].bias.data, atol=1e-3, rtol=0)
+
+    def test_grad_accumulation_with_zero_grad(self):
+        # Gradients of micro-batches accumulate into the full-batch gradient
+        x = np.random.randn(64, 784).astype(np.float32)
+        model = nn.Linear(784, 10)
+        optimizer = GradientDescent(model.parameters(), lr=1e-3)
+        t1 = torch.from_numpy(x)
+        w: torch.Tensor = model.w.torch()
+        b: torch.Tensor = model.b.torch()
+        w.requires_grad_(True)
+        b.requires_grad_(True)
+
+        for _ in range(2):
+            optimizer.zero_grad()
+            for i in range(0, 64, 16):
+                arr1 = Array.from_numpy(x[i : i + 16])
+                model(arr1).sum().backward()
+            t2 = (t1 @ w.T + b).sum()
+            t2.backward()
+            assert torch.allclose(model.w.grad.torch(), w.grad, atol=1e-3, rtol=0)
+            assert torch.allclose(model.b.grad.torch(), b.grad, atol=1e-3, rtol=0)
+            w.grad = None
+            b.grad = None
+
+        optimizer.zero_grad()
+        assert torch.count_nonzero(model.w.grad.torch()) == 0
+        assert torch.count_nonzero(model.b.grad.torch()) == 0
+
+    def test_single_pass_with_spill(self):
+        # Saved activations spilled to disk are faulted back in for backward
+        x = np.random.randn(64, 784).astype(np.float32)
+        y = np.random.randint(0, 10, (64,), dtype=np.int32)
+        arr1 = Array.from_numpy(x)
+        arr2 = Array.from_numpy(y)
+        model = MnistModel()
+        w1: torch.Tensor = model.linear1.w.torch().requires_grad_(True)
+        b1: torch.Tensor = model.linear1.b.torch().requires_grad_(True)
+        w2: torch.Tensor = model.linear2.w.torch().requires_grad_(True)
+        b2: torch.Tensor = model.linear2.b.torch().requires_grad_(True)
+        t1 = torch.from_numpy(x)
+        t2 = torch.from_numpy(y).type(torch.int64)
+
+        Backend.enable_spill(64 * 128 * 4)
+        try:
+            loss = cross_entropy_loss(model(arr1), arr2)
+            loss.backward()
+        finally:
+            Backend.disable_spill()
+        torch_logits = torch.relu(t1 @ w1.T + b1) @ w2.T + b2
+        torch_loss: torch.Tensor = torch.nn.CrossEntropyLoss()(torch_logits, t2)
+        torch_loss.backward()
+        assert torch.allclose(loss.torch(), torch_loss, atol=1e-3, rtol=0)
+        assert torch.allclose(model.linear1.w.grad.torch(), w1.grad, atol=1e-3, rtol=0)
+        assert torch.allclose(model.linear2.b.grad.torch(), b2.grad, atol=1e-3, rtol=0)
+
+    def test_spill_between_forward_and_backward(self):
+        # Backward reads saved activations through detached arrays, which must follow their buffers to disk and back
+        x = np.random.randn(64, 256).astype(np.float32)
+        w = (np.random.randn(128, 256) * 0.1).astype(np.float32)
+        t_w = torch.from_numpy(w).requires_grad_(True)
+        t_loss = (torch.from_numpy(x) @ t_w.T).exp().square().mean()
+        t_loss.backward()
+        arr_w = Array.from_numpy(w)
+        loss = linear(Array.from_numpy(x), arr_w).exp().sq().mean()
+        # Every buffer not used by the running op is spilled
+        Backend.enable_spill(0)
+        try:
+            loss.eval()
+            assert Backend.spilled_bytes() > 0
+            loss.backward()
+        finally:
+            Backend.disable_spill()
+        assert torch.allclose(loss.torch(), t_loss, atol=1e-3, rtol=1e-4)
+        assert torch.allclose(arr_w.grad.torch(), t_w.grad, atol=1e-3, rtol=1e-3)
+
+    def test_spill_keeps_exported_views(self):
+        # Numpy and torch views point into the buffer so it stays resident while they are alive
+        x = np.random.randn(64, 256).astype(np.float32)
+        arr1 = Array.from_numpy(x) * 2.0
+        np_view = arr1.numpy()
+        t_view = arr1.torch()
+        Backend.enable_spill(0)
+        try:
+            arr2 = ((arr1 + 1.0).exp() * arr1).sum()
+            arr2.eval()
+            assert Backend.spilled_bytes() > 0
+            assert np.array_equal(np_view, x * 2.0)
+            assert torch.equal(t_view, torch.from_numpy(x) * 2.0)
+        finally:
+            Backend.disable_spill()
+        assert np.allclose(arr2.numpy()[0], np.sum(np.exp(x * 2.0 + 1.0) * x * 2.0), rtol=1e-3)
@@ -1,6 +1,7 @@
 from __future__ import annotations
-from arrayx.core import Array, Backend
+from arrayx.core import Array, Backend, f32, i64
 import numpy as np
+import pytest
 import operator
 
 
@@ -185,3 +186,69 @@ class TestBinary:
 
     def test_div_inplace_broadcast(self):
         self.binary_inplace_broadcast("div", operator.itruediv, operator.itruediv)
+
+    def test_mixed_dtypes(self):
+        # Operands of different dtypes are converted by the kernel instead of being cast beforehand
+        cases = [
+            (np.int32, np.float32, f32),
+            (np.float16, np.int8, f32),
+            (np.int32, np.float16, f32),
+            (np.float16, np.float32, f32),
+            (np.int8, np.int64, i64),
+        ]
+        ops = [operator.add, operator.sub, operator.mul, lambda x, y: x.maximum(y)]
+        np_ops = [operator.add, operator.sub, operator.mul, np.maximum]
+        for ldtype, rdtype, dtype in cases:
+            np1 = (randn([7, 1, 13]) * 10).astype(ldtype)
+            np2 = (randn([5, 13]) * 10).astype(rdtype)
+            arr1 = Array.from_numpy(np1)
+            arr2 = Array.from_numpy(np2)
+            for op, np_op in zip(ops, np_ops):
+                arr3: Array = op(arr1, arr2)
+                assert arr3.dtype == dtype
+                np3 = np_op(np1.astype(np.float32), np2.astype(np.float32))
+                assert np.allclose(arr3.numpy().astype(np.float32), np3, atol=1e-1, rtol=1e-3)
+            arr4 = arr1 < arr2
+            assert np.array_equal(arr4.numpy(), np1.astype(np.float32) < np2.astype(np.float32))
+
+    def test_mixed_int_half(self):
+        # Ints mixed with half arrays are computed in f32 since the sums would overflow f16
+        np1 = np.random.randint(60000, 70000, size=[3, 17]).astype(np.int32)
+        np2 = randn([17]).astype(np.float16)
+        arr3 = Array.from_numpy(np1) + Array.from_numpy(np2)
+        assert arr3.dtype == f32
+        assert np.all(np.isfinite(arr3.numpy()))
+        assert np.allclose(arr3.numpy(), np1 + np2.astype(np.float32), atol=1e-3, rtol=0)
+        # The lhs of an in-place op cannot be widened
+        arr4 = Array.from_numpy(np2)
+        with pytest.raises(ValueError):
+            arr4 += Array.from_numpy(np1[0])
+
+    def test_mixed_dtypes_inplace(self):
+        np1 = randn([4, 9])
+        np2 = np.random.randint(-5, 5, size=[9]).astype(np.int32)
+        arr1 = Array.from_numpy(np1)
+        arr2 = Array.from_numpy(np2)
+        arr1 += arr2
+        assert arr1.dtype == f32
+        assert np.allclose(arr1.numpy(), np1 + np2, atol=1e-5, rtol=0)
+        # The lhs of an in-place op cannot be widened
+        arr3 = Array.from_numpy(np2)
+        with pytest.raises(ValueError):
+            arr3 += Array.from_numpy(np1)
+
+    def test_mask_mul(self):
+        np1 = randn([3, 45, 29])
+        np2 = randn([45, 1])
+        arr1 = Array.from_numpy(np1)
+        arr2 = Array.from_numpy(np2)
+        expected = np.where(np2 > 0, np1, 0)
+        # Boolean masks are broadcasted and packed on the fly
+        assert np.allclose(arr1.mask_mul(arr2 > 0).numpy(), expected, atol=0, rtol=0)
+        # Packed masks are reused as is
+        packed = (arr2 > 0).broadcast_to([3, 45, 29]).pack_mask()
+        assert np.allclose(arr1.mask_mul(packed).numpy(), expected, atol=0, rtol=0)
+        # Strided lhs reads the mask in its own row-major order
+        arr3 = arr1.transpose(1, 2)
+        np3 = np.where(np2.reshape(1, 1, 45) > 0, np1.transpose(0, 2, 1), 0)
+        assert np.allclose(arr3.mask_mul(arr2.reshape([1, 1, 45]) > 0).numpy(), np3, atol=0, rtol=0)
@@ -0,0 +1,81 @@
+import numpy as np
+import pytest
+import torch
+from arrayx.core import Array, Backend, f16
+from arrayx.nn import conv2d
+
+
+class TestConv:
+    @classmethod
+    def setup_class(cls):
+        """Run once before all tests in the class"""
+        print("\nSetting up TestConv class...")
+        Backend.init()
+
+    @classmethod
+    def teardown_class(cls):
+        """Run once after all tests in the class"""
+        print("\nTearing down TestConv class...")
+        Backend.cleanup()
+
+    def test_conv2d(self):
+        """Test 2D convolution and its gradients against torch"""
+        # Test cases: [(input shape, out_channels, kernel, stride, padding, dilation, groups)]
+        test_cases = [
+            ([2, 3, 8, 8], 4, [3, 3], [1, 1], [0, 0], [1, 1], 1),  # Valid convolution
+            ([2, 3, 8, 8], 4, [3, 3], [1, 1], [1, 1], [1, 1], 1),  # Same padding
+            ([1, 4, 9, 7], 6, [3, 2], [2, 3], [1, 0], [1, 1], 1),  # Rectangular kernel and uneven strides
+            ([2, 2, 10, 10], 3, [3, 3], [1, 1], [2, 2], [2, 2], 1),  # Dilated kernel
+            ([1, 8, 6, 6], 1, [1, 1], [1, 1], [0, 0], [1, 1], 1),  # Pointwise convolution
+            ([2, 4, 7, 7], 6, [3, 3], [2, 2], [1, 1], [1, 1], 2),  # Grouped convolution
+            ([2, 5, 8, 8], 5, [3, 3], [1, 1], [1, 1], [1, 1], 5),  # Depthwise convolution
+            ([2, 16, 9, 9], 8, [3, 3], [1, 1], [1, 1], [1, 1], 1),  # Long windows lowered to a matmul
+            ([2, 8, 11, 10], 4, [3, 3], [2, 1], [2, 1], [2, 1], 1),  # Lowered with strides, padding and dilation
+            ([1, 4, 3, 3], 2, [3, 3], [1, 1], [0, 0], [1, 1], 1),  # Single output position per weight element
+            ([2, 3, 32, 32], 4, [3, 3], [1, 1], [1, 1], [1, 1], 1),  # More output positions than threads per weight element
+        ]
+
+        for view, out_channels, kernel, stride, padding, dilation, groups in test_cases:
+            print(f"\nTesting conv2d: {view}, {out_channels}, {kernel}, {stride}, {padding}, {dilation}, {groups}")
+            x = np.random.randn(*view).astype(np.float32)
+            w = np.random.randn(out_channels, view[1] // groups, *kernel).astype(np.float32)
+            b = np.random.randn(out_channels).astype(np.float32)
+            arr_x = Array.from_numpy(x)
+            arr_w = Array.from_numpy(w)
+            arr_b = Array.from_numpy(b)
+            out = conv2d(arr_x, arr_w, arr_b, stride, padding, dilation, groups)
+            t_x = torch.from_numpy(x).requires_grad_(True)
+            t_w = torch.from_numpy(w).requires_grad_(True)
+            t_b = torch.from_numpy(b).requires_grad_(True)
+            t_out = torch.nn.functional.conv2d(t_x, t_w, t_b, stride, padding, dilation, groups)
+            # Weights the outputs so that the upstream gradient is not uniform
+            g = np.random.randn(*t_out.shape).astype(np.float32)
+            (out * Array.from_numpy(g)).sum().backward()
+            (t_out * torch.from_numpy(g)).sum().backward()
+            assert tuple(out.view) == tuple(t_out.shape)
+            assert torch.allclose(out.torch(), t_out, atol=1e-4, rtol=1e-4)
+            assert torch.allclose(arr_x.grad.torch(), t_x.grad, atol=1e-4, rtol=1e-4)
+            assert torch.allclose(arr_w.grad.torch(), t_w.grad, atol=1e-3, rtol=1e-4)
+            assert torch.allclose(arr_b.grad.torch(), t_b.grad, atol=1e-3, rtol=1e-4)
+
+    def test_conv2d_f16(self):
+        """Test half precision convolution against torch in f32"""
+        # Run directly and lowered to a matmul
+        for channels in [3, 16]:
+            x = np.random.randn(2, channels, 8, 8).astype(np.float32)
+            w = (np.random.randn(4, channels, 3, 3) / np.sqrt(channels)).astype(np.float32)
+            out = Array.from_numpy(x).astype(f16).conv2d(Array.from_numpy(w).astype(f16), padding=[1, 1])
+            t_out = torch.nn.functional.conv2d(torch.from_numpy(x), torch.from_numpy(w), padding=1)
+            assert torch.allclose(out.torch().float(), t_out, atol=5e-2, rtol=1e-2), channels
+
+    def test_conv2d_invalid(self):
+        """Test that mismatched channels and kernels larger than the padded input are rejected"""
+        x = Array.from_numpy(np.random.randn(1, 3, 8, 8).astype(np.float32))
+        w = Array.from_numpy(np.random.randn(4, 2, 3, 3).astype(np.float32))
+        with pytest.raises(ValueError):
+            x.conv2d(w)
+        # The kernel overhangs the input by one element, which a truncating division would round to one output
+        x = Array.from_numpy(np.random.randn(1, 1, 2, 2).astype(np.float32))
+        w = Array.from_numpy(np.random.randn(1, 1, 3, 3).astype(np.float32))
+        with pytest.raises(ValueError):
+            x.conv2d(w, stride=[2, 2])
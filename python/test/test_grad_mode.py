@@ -0,0 +1,244 @@
+from arrayx.core import Array, Backend, is_grad_enabled, is_inference_mode, get_autocast_dtype, bf16, f16, f32
+from arrayx.nn import linear, cross_entropy_loss
+from arrayx.optim import GradientDescent, GradScaler
+import ax
+import numpy as np
+import pytest
+import torch
+
+
+class TestGradMode:
+    @classmethod
+    def setup_class(cls):
+        """Run once before all tests in the class"""
+        print("\nSetting up TestGradMode class...")
+        # Add any setup code here
+        Backend.init()
+
+    @classmethod
+    def teardown_class(cls):
+        """Run once after all tests in the class"""
+        print("\nTearing down TestGradMode class...")
+        # Add any cleanup code here
+        Backend.cleanup()
+
+    def test_no_grad_scope(self):
+        assert is_grad_enabled()
+        with ax.no_grad():
+            assert not is_grad_enabled()
+            with ax.no_grad():
+                assert not is_grad_enabled()
+            assert not is_grad_enabled()
+        assert is_grad_enabled()
+
+    def test_inference_mode_scope(self):
+        with ax.inference_mode():
+            assert not is_grad_enabled()
+            assert is_inference_mode()
+        assert is_grad_enabled()
+        assert not is_inference_mode()
+
+    def test_no_grad_forward(self):
+        x = np.random.randn(37, 19).astype(np.float32)
+        arr1 = Array.from_numpy(x)
+        with ax.no_grad():
+            arr2 = ((arr1 * 2.0).exp() + arr1).sum()
+        t1 = torch.from_numpy(x)
+        t2 = ((t1 * 2.0).exp() + t1).sum().unsqueeze(dim=-1)
+        assert torch.allclose(arr2.torch(), t2, atol=1e-3, rtol=1e-4)
+        with pytest.raises(RuntimeError):
+            arr2.backward()
+
+    def test_no_grad_partial_backward(self):
+        # Only the branch created outside of no_grad receives gradients
+        x = np.random.randn(16, 8).astype(np.float32)
+        arr1 = Array.from_numpy(x)
+        with ax.no_grad():
+            arr2 = arr1.exp()
+        arr3 = (arr1 * arr2).sum()
+        arr3.backward()
+        t1 = torch.from_numpy(x).requires_grad_(True)
+        t2 = t1.exp().detach()
+        t3 = (t1 * t2).sum()
+        t3.backward()
+        assert torch.allclose(arr1.grad.torch(), t1.grad, atol=1e-3, rtol=0)
+
+    def test_no_grad_shared_operand(self):
+        # An operand read both by a no_grad branch and by a tracked branch keeps receiving gradients
+        x = np.random.randn(16, 8).astype(np.float32)
+        w = np.random.randn(16, 8).astype(np.float32)
+        arr_x = Array.from_numpy(x)
+        arr_w = Array.from_numpy(w)
+        arr1 = arr_w * 2.0
+        with ax.no_grad():
+            arr2 = arr1.exp()
+        arr3 = (arr1 * arr_x + arr2).sum()
+        arr3.backward()
+        assert arr1.grad_enabled
+        t_x = torch.from_numpy(x)
+        t_w = torch.from_numpy(w).requires_grad_(True)
+        t1 = t_w * 2.0
+        t3 = (t1 * t_x + t1.exp().detach()).sum()
+        t3.backward()
+        assert torch.allclose(arr_w.grad.torch(), t_w.grad, atol=1e-3, rtol=0)
+
+    def test_inference_mode_forward(self):
+        # Long element-wise chains reuse dead intermediate buffers
+        x = np.random.randn(67, 31, 5).astype(np.float32)
+        y = np.random.randn(67, 31, 5).astype(np.float32)
+        arr1 = Array.from_numpy(x)
+        arr2 = Array.from_numpy(y)
+        with ax.inference_mode():
+            arr3 = (((arr1 + arr2) * arr1).exp() - arr2).sq().sqrt() / (arr2.sq() + 1.0)
+            arr4 = arr3.sum()
+        t1 = torch.from_numpy(x)
+        t2 = torch.from_numpy(y)
+        t3 = (((t1 + t2) * t1).exp() - t2).square().sqrt() / (t2.square() + 1.0)
+        assert torch.allclose(arr3.torch(), t3, atol=1e-3, rtol=1e-4)
+        # Inputs must be left untouched
+        assert torch.allclose(arr1.torch(), t1, atol=0, rtol=0)
+        assert torch.allclose(arr2.torch(), t2, atol=0, rtol=0)
+        with pytest.raises(RuntimeError):
+            arr4.backward()
+
+    def test_inference_mode_held_intermediates(self):
+        # Intermediates held by arrays or aliased by detached arrays keep their buffers
+        x = np.random.randn(33, 17).astype(np.float32)
+        arr1 = Array.from_numpy(x)
+        with ax.inference_mode():
+            arr2 = arr1.exp()
+            arr3 = arr1 * 2.0
+            arr3.eval()
+            arr4 = arr3.detach()
+            arr5 = ((arr2 + 1.0) * (arr3 - 1.0)).sq()
+        t1 = torch.from_numpy(x)
+        t2 = t1.exp()
+        t3 = t1 * 2.0
+        assert torch.allclose(arr5.torch(), ((t2 + 1.0) * (t3 - 1.0)).square(), atol=1e-3, rtol=1e-4)
+        assert torch.allclose(arr2.torch(), t2, atol=1e-5, rtol=1e-5)
+        assert torch.allclose(arr4.torch(), t3, atol=1e-5, rtol=1e-5)
+
+    def test_inference_mode_mask_reductions(self):
+        # Masks of at most 32 elements pack into one word shaped like the count accumulated over it
+        x = np.random.randn(5, 6).astype(np.float32)
+        arr1 = Array.from_numpy(x)
+        with ax.inference_mode():
+            count = (arr1 > 0.0).count_nonzero()
+            any_pos = (arr1 > 0.0).any()
+            all_pos = (arr1 > 0.0).all()
+            all_finite = (arr1 > -100.0).all()
+        assert count.numpy()[0] == np.count_nonzero(x > 0.0)
+        assert any_pos.numpy()[0] == np.any(x > 0.0)
+        assert all_pos.numpy()[0] == np.all(x > 0.0)
+        assert all_finite.numpy()[0]
+
+    def test_autocast_scope(self):
+        assert get_autocast_dtype() is None
+        with ax.autocast():
+            assert get_autocast_dtype() == f16
+            with ax.autocast(bf16):
+                assert get_autocast_dtype() == bf16
+            assert get_autocast_dtype() == f16
+        assert get_autocast_dtype() is None
+
+    def test_autocast_backward(self):
+        # Matmuls run in f16 while the loss and the master weights stay in f32
+        x = np.random.randn(32, 64).astype(np.float32)
+        w = (np.random.randn(16, 64) * 0.1).astype(np.float32)
+        y = np.random.randint(0, 16, (32,), dtype=np.int32)
+        arr_x = Array.from_numpy(x)
+        arr_w = Array.from_numpy(w)
+        with ax.autocast():
+            logits = linear(arr_x, arr_w)
+            loss = cross_entropy_loss(logits, Array.from_numpy(y))
+        assert logits.dtype == f16
+        assert loss.dtype == f32
+        loss.backward()
+        assert arr_w.grad.dtype == f32
+        t_x = torch.from_numpy(x)
+        t_w = torch.from_numpy(w).requires_grad_(True)
+        t_loss = torch.nn.CrossEntropyLoss()(t_x @ t_w.T, torch.from_numpy(y).type(torch.int64))
+        t_loss.backward()
+        assert torch.allclose(loss.torch(), t_loss, atol=1e-2, rtol=0)
+        assert torch.allclose(arr_w.grad.torch(), t_w.grad, atol=1e-2, rtol=0)
+
+    def test_autocast_mixed_elmwise(self):
+        # Element-wise ops promote half autocast outputs combined with f32 arrays to f32
+        x = np.random.randn(8, 16).astype(np.float32)
+        w = (np.random.randn(4, 16) * 0.1).astype(np.float32)
+        y = (np.random.randn(8, 4) * 1e-4).astype(np.float32)
+        arr_x = Array.from_numpy(x)
+        arr_w = Array.from_numpy(w)
+        arr_y = Array.from_numpy(y)
+        with ax.autocast():
+            logits = linear(arr_x, arr_w)
+            arr1 = logits + arr_y
+            arr2 = arr_y * logits
+        assert logits.dtype == f16
+        assert arr1.dtype == f32
+        assert arr2.dtype == f32
+        t_logits = torch.from_numpy(logits.numpy()).float()
+        t_y = torch.from_numpy(y)
+        assert torch.allclose(arr1.torch(), t_logits + t_y, atol=1e-6, rtol=0)
+        assert torch.allclose(arr2.torch(), t_y * t_logits, atol=1e-8, rtol=1e-6)
+        arr1.sum().backward()
+        assert arr_w.grad.dtype == f32
+
+    def test_autocast_softmax(self):
+        # Row ops over half arrays are computed in f32 while autocasting
+        x = (np.random.randn(8, 33) * 3).astype(np.float32)
+        arr1 = Array.from_numpy(x).astype(f16)
+        t1 = torch.from_numpy(x).half().float()
+        for name in ["softmax", "log_softmax", "logsumexp"]:
+            with ax.autocast():
+                arr2 = getattr(arr1, name)()
+            if name == "logsumexp":
+                t2 = torch.logsumexp(t1, dim=-1, keepdim=True)
+            else:
+                t2 = getattr(torch, name)(t1, dim=-1)
+            assert arr2.dtype == f32, name
+            assert torch.allclose(arr2.torch(), t2, atol=1e-4, rtol=1e-4), name
+        assert arr1.softmax().dtype == f16
+
+    def test_autocast_cross_entropy(self):
+        # Losses over half logits are computed in f32 while autocasting and gradients flow back in half precision
+        x = (np.random.randn(16, 37) * 3).astype(np.float32)
+        y = np.random.randint(0, 37, (16,), dtype=np.int32)
+        arr1 = Array.from_numpy(x.astype(np.float16))
+        with ax.autocast():
+            loss = arr1.cross_entropy(Array.from_numpy(y))
+        assert loss.dtype == f32
+        loss.sum().backward()
+        assert arr1.grad.dtype == f16
+        t1 = torch.from_numpy(x).half().float().requires_grad_(True)
+        t_loss = torch.nn.functional.cross_entropy(t1, torch.from_numpy(y).type(torch.int64), reduction="none")
+        t_loss.sum().backward()
+        assert torch.allclose(loss.torch(), t_loss, atol=1e-4, rtol=1e-4)
+        assert torch.allclose(arr1.grad.torch().float(), t1.grad, atol=1e-2, rtol=1e-2)
+        assert arr1.cross_entropy(Array.from_numpy(y)).dtype == f16
+
+    def test_grad_scaler(self):
+        x = np.random.randn(8, 4).astype(np.float32)
+        w = np.random.randn(3, 4).astype(np.float32)
+        y = np.random.randint(0, 3, (8,), dtype=np.int32)
+        for init_scale, stepped in [(1024.0, True), (3e38, False)]:
+            # Arrays share memory with the numpy arrays they are created from
+            npw = w.copy()
+            arr_w = Array.from_numpy(npw)
+            optim = GradientDescent([arr_w], lr=0.1)
+            scaler = GradScaler(init_scale=init_scale, growth_interval=1)
+            with ax.autocast():
+                loss = cross_entropy_loss(linear(Array.from_numpy(x), arr_w), Array.from_numpy(y))
+            scaler.scale_loss(loss).backward()
+            assert scaler.step(optim) == stepped
+            if stepped:
+                # Gradients are unscaled before the update and the scale grows after a good step
+                t_w = torch.from_numpy(w.copy()).requires_grad_(True)
+                t_loss = torch.nn.CrossEntropyLoss()(torch.from_numpy(x) @ t_w.T, torch.from_numpy(y).type(torch.int64))
+                t_loss.backward()
+                assert torch.allclose(arr_w.torch(), t_w.detach() - 0.1 * t_w.grad, atol=1e-2, rtol=0)
+                assert scaler.scale == init_scale * 2
+            else:
+                # Overflowed steps leave the weights untouched and back off
+                assert np.array_equal(npw, w)
+                assert scaler.scale == pytest.approx(init_scale * 0.5, rel=1e-6)
@@ -1,4 +1,4 @@
-from arrayx.core import Array, Backend
+from arrayx.core import Array, Backend, f32, f64, i8, i16, i64
 import numpy as np
 
 
@@ -53,6 +53,26 @@ class TestInitializers:
             assert np.allclose(arr.numpy(), nparr)
             assert tuple(arr.view) == nparr.shape
 
+    def test_wide_and_narrow_dtypes(self):
+        print("\nTesting f64, i64, i8 and i16 arrays:")
+
+        for dtype, np_dtype in [(f64, np.float64), (i64, np.int64), (i8, np.int8), (i16, np.int16)]:
+            nparr = (np.random.randn(7, 13) * 100).astype(np_dtype)
+            arr = Array.from_numpy(nparr)
+            assert arr.dtype == dtype
+            assert np.array_equal(arr.numpy(), nparr)
+            # Strided copies keep the values
+            assert np.array_equal(arr.transpose().reshape([13 * 7]).numpy(), nparr.T.reshape(-1))
+
+        # Values that do not fit in 32 bits are kept exactly
+        arr = Array.full([3], 2**40 + 3, dtype=i64)
+        assert np.array_equal(arr.numpy(), np.full([3], 2**40 + 3, dtype=np.int64))
+        assert (arr + 1).numpy()[0] == 2**40 + 4
+        arr = Array.full([3], 0.1, dtype=f64)
+        assert arr.numpy()[0] == 0.1
+        assert arr.astype(f32).numpy()[0] == np.float32(0.1)
+        assert np.array_equal(Array.from_numpy(np.arange(5, dtype=np.int8)).astype(f64).numpy(), np.arange(5, dtype=np.float64))
+
     def test_like_methods(self):
         print("\nTesting *_like methods:")
 
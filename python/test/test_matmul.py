@@ -1,5 +1,6 @@
 import numpy as np
-from arrayx.core import Array, Backend
+from arrayx.core import Array, Backend, f16, i8
+from arrayx.nn import linear, quantize_weight
 
 
 class TestMatmul:
@@ -103,3 +104,57 @@ class TestMatmul:
             # Verify shape and values
             assert tuple(arr3.view) == np3.shape, f"Shape mismatch: got {arr3.view()}, expected {np3.shape}"
             assert np.allclose(arr3.numpy(), np3, atol=1e-3, rtol=0), f"Value mismatch for {shape1} @ {shape2}"
+
+    def test_half_matmul(self):
+        """Test matrix multiplication of 16-bit floats accumulated in f32"""
+        print("\nTesting half precision matrix multiplication:")
+
+        # Long inner dimensions overflow or lose most bits if accumulated in half precision
+        test_cases = [([64, 4096], [4096, 32]), ([3, 17, 1031], [3, 1031, 9])]
+
+        for shape1, shape2 in test_cases:
+            print(f"Shapes: {shape1} @ {shape2}")
+            np1 = np.random.rand(*shape1).astype(np.float16)
+            np2 = np.random.rand(*shape2).astype(np.float16)
+            arr1 = Array.from_numpy(np1)
+            arr2 = Array.from_numpy(np2)
+            arr3 = arr1 @ arr2
+            np3 = (np1.astype(np.float32) @ np2.astype(np.float32)).astype(np.float16)
+            assert arr3.dtype == f16
+            assert tuple(arr3.view) == np3.shape, f"Shape mismatch: got {arr3.view}, expected {np3.shape}"
+            assert np.allclose(arr3.numpy().astype(np.float32), np3.astype(np.float32), atol=0, rtol=2e-3), f"Value mismatch for {shape1} @ {shape2}"
+
+    def test_quantized_linear(self):
+        """Test linear with i8 weights, i32 accumulation and per-channel scales"""
+        print("\nTesting quantized linear:")
+
+        test_cases = [([64, 784], [10, 784]), ([4, 7, 33], [5, 33]), ([3, 2, 1000], [3, 16, 1000])]
+
+        for x_shape, w_shape in test_cases:
+            print(f"Shapes: x {x_shape}, weight {w_shape}")
+            npx = np.random.randn(*x_shape).astype(np.float32)
+            npw = np.random.randn(*w_shape).astype(np.float32)
+            # Zero channels must quantize to zeros instead of dividing by a zero scale
+            npw[..., 0, :] = 0
+            x = Array.from_numpy(npx)
+            w = Array.from_numpy(npw)
+            qw = quantize_weight(w)
+            w_scale = np.maximum(np.abs(npw).max(axis=-1, keepdims=True) / 127, np.finfo(np.float32).tiny)
+            qnpw = np.clip(np.rint(npw / w_scale), -127, 127)
+            assert qw.weight.dtype == i8
+            assert np.allclose(qw.scale.numpy(), w_scale, rtol=1e-6)
+            # Division on the device may round ties differently
+            assert np.abs(qw.weight.numpy().astype(np.float32) - qnpw).max() <= 1
+            assert np.all(np.abs(qw.weight.dequantize(qw.scale).numpy() - npw) <= w_scale * 0.51)
+
+            x_scale = np.abs(npx).max() / 127
+            qnpx = np.clip(np.rint(npx / x_scale), -127, 127)
+            expected = (qnpx @ np.swapaxes(qnpw, -1, -2)) * np.swapaxes(w_scale, -1, -2) * x_scale
+            out = linear(x, qw)
+            assert tuple(out.view) == expected.shape, f"Shape mismatch: got {out.view}, expected {expected.shape}"
+            # Off-by-one quantized values move a dot product by a few of its steps
+            step = x_scale * w_scale.max() * 127 * 4
+            assert np.allclose(out.numpy(), expected, rtol=1e-4, atol=step), f"Value mismatch for x {x_shape}, weight {w_shape}"
+            # The quantized path stays close to the float one
+            reference = npx @ np.swapaxes(npw, -1, -2)
+            assert np.abs(out.numpy() - reference).max() <= 0.05 * np.abs(reference).max()
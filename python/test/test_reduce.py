@@ -1,7 +1,7 @@
 import torch
 import torch.testing
 import numpy as np
-from arrayx.core import Array, Backend
+from arrayx.core import Array, Backend, f16, bf16
 
 
 class TestReduce:
@@ -200,3 +200,59 @@ class TestReduce:
         self.arg_reduce_dim_in_multidim_arr(
             lambda x, dim: x.argmin(dim), lambda x, dim: x.argmin(dim=dim).unsqueeze(dim=-1).type(torch.int32)
         )
+
+    def test_reduce_half(self):
+        """Test reductions over 16-bit floats accumulated in f32"""
+        print("\nTesting reductions over 16-bit floats:")
+        shapes = [(1024, 60), (297, 101), (1, 997)]
+
+        for dtype, torch_dtype in [(f16, torch.float16), (bf16, torch.bfloat16)]:
+            for shape in shapes:
+                x = torch.rand(*shape, dtype=torch.float32)
+                arr1 = Array.from_numpy(x.numpy()).astype(dtype)
+                # The reference sums the rounded inputs in f32 and rounds the result once
+                x = x.type(torch_dtype).type(torch.float32)
+                for dims, expected in [([], x.sum().unsqueeze(dim=-1)), ([1], x.sum(dim=1).unsqueeze(dim=-1))]:
+                    arr2 = arr1.sum(dims)
+                    assert arr2.dtype == dtype
+                    self.check_err(arr2.torch().type(torch.float32), expected.type(torch_dtype).type(torch.float32), rtol=1e-2, atol=1e-2)
+                arr3 = arr1.max([0])
+                self.check_err(arr3.torch().type(torch.float32), x.max(dim=0).values.unsqueeze(dim=-1), rtol=0, atol=0)
+
+    def test_reduce_integers(self):
+        """Test reductions over 8, 16 and 64-bit integers"""
+        print("\nTesting reductions over 8, 16 and 64-bit integers:")
+        x = np.random.randint(-100, 100, size=(297, 101))
+
+        for np_dtype in [np.int8, np.int16]:
+            arr = Array.from_numpy(x.astype(np_dtype))
+            assert np.array_equal(arr.max([1]).numpy(), x.max(axis=1, keepdims=True).astype(np_dtype))
+            assert np.array_equal(arr.min().numpy(), np.array([x.min()], dtype=np_dtype))
+            assert np.array_equal(arr.argmax([1]).numpy(), x.argmax(axis=1, keepdims=True).astype(np.int32))
+
+        # Sums carry across the 32-bit halves and extrema beyond 32 bits are found exactly
+        y = x.astype(np.int64) * (2**40 + 1)
+        arr = Array.from_numpy(y)
+        assert np.array_equal(arr.sum().numpy(), np.array([y.sum()]))
+        assert np.array_equal(arr.sum([0]).numpy(), y.sum(axis=0).reshape(-1, 1))
+        assert np.array_equal(arr.max([1]).numpy(), y.max(axis=1, keepdims=True))
+        assert np.array_equal(arr.min().numpy(), np.array([y.min()]))
+
+    def test_mask_reductions(self):
+        """Test popcount reductions over packed boolean masks"""
+        print("\nTesting popcount reductions over packed masks:")
+        x = np.random.randn(37, 101).astype(np.float32)
+        arr = Array.from_numpy(x)
+        mask = arr > 0.5
+        packed = mask.pack_mask()
+        # 32 booleans per word
+        assert tuple(packed.view) == ((x.size + 31) // 32,)
+        bits = np.unpackbits(packed.numpy().view(np.uint8), bitorder="little")[: x.size]
+        assert np.array_equal(bits.astype(bool), (x > 0.5).reshape(-1))
+        assert arr.count_nonzero().numpy()[0] == np.count_nonzero(x)
+        assert mask.count_nonzero().numpy()[0] == np.count_nonzero(x > 0.5)
+        # Transposed masks are packed in their own row-major order
+        assert mask.transpose(0, 1).count_nonzero().numpy()[0] == np.count_nonzero(x > 0.5)
+        assert mask.any().numpy()[0] and not mask.all().numpy()[0]
+        assert (arr > -100.0).all().numpy()[0]
+        assert not (arr > 100.0).any().numpy()[0]
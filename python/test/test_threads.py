@@ -0,0 +1,56 @@
+from arrayx.core import Array, Backend
+from concurrent.futures import ThreadPoolExecutor
+import numpy as np
+import torch
+
+
+class TestThreads:
+    @classmethod
+    def setup_class(cls):
+        """Run once before all tests in the class"""
+        print("\nSetting up TestThreads class...")
+        # Add any setup code here
+        Backend.init()
+
+    @classmethod
+    def teardown_class(cls):
+        """Run once after all tests in the class"""
+        print("\nTearing down TestThreads class...")
+        # Add any cleanup code here
+        Backend.cleanup()
+
+    def test_independent_graphs(self):
+        # Each thread builds and runs its own graph
+        def run(seed: int):
+            rng = np.random.default_rng(seed)
+            x = rng.standard_normal((32, 17)).astype(np.float32)
+            y = rng.standard_normal((17, 8)).astype(np.float32)
+            arr1 = Array.from_numpy(x)
+            arr2 = Array.from_numpy(y)
+            arr3 = ((arr1 @ arr2).exp() + 1.0).log().sum()
+            arr3.backward()
+            t1 = torch.from_numpy(x).requires_grad_(True)
+            t2 = torch.from_numpy(y)
+            t3 = ((t1 @ t2).exp() + 1.0).log().sum()
+            t3.backward()
+            return (
+                torch.allclose(arr3.torch(), t3.unsqueeze(dim=-1), atol=1e-2, rtol=1e-4)
+                and torch.allclose(arr1.grad.torch(), t1.grad, atol=1e-3, rtol=1e-4),
+                arr3.id,
+            )
+
+        with ThreadPoolExecutor(max_workers=8) as executor:
+            results = list(executor.map(run, range(32)))
+        assert all(ok for ok, _ in results)
+        # Ids stay unique across threads
+        assert len({id for _, id in results}) == len(results)
+
+    def test_shared_array(self):
+        # Evaluating the same array from several threads runs its graph once at a time
+        x = np.random.randn(64, 64).astype(np.float32)
+        arr1 = Array.from_numpy(x)
+        arr2 = (arr1 * 2.0 + 1.0).sum()
+        with ThreadPoolExecutor(max_workers=8) as executor:
+            values = list(executor.map(lambda _: arr2.item(), range(16)))
+        expected = (x * 2.0 + 1.0).sum()
+        assert np.allclose(values, expected, atol=1e-1, rtol=1e-4)
@@ -1,5 +1,6 @@
-from arrayx.core import Array, Backend
+from arrayx.core import Array, Backend, i32
 import numpy as np
+import torch
 
 
 class TestTransform:
@@ -160,3 +161,56 @@ class TestTransform:
                 npflatten1, npflatten2, atol=1e-3, rtol=0
             ), f"Flatten failed for shape {shape} with dims {start},{end}"
             assert npflatten1.shape == tuple(expected), f"Shape mismatch: got {npflatten1.shape}, expected {expected}"
+
+    def test_reshape_strided(self):
+        print("\nTesting reshape of strided arrays:")
+
+        # Test cases: [(shape, permutation, slice, target, is_view)]
+        test_cases = [
+            # Merging dims that stay contiguous with each other
+            ([4, 3, 5], [1, 0, 2], (slice(None), slice(None), slice(None)), [3, 20], False),
+            ([4, 6, 5], [0, 1, 2], (slice(None), slice(0, 6, 2), slice(None)), [12, 5], True),
+            ([6, 4], [1, 0], (slice(None), slice(None)), [2, 2, 6], True),
+            # Splitting and inserting size-1 dims
+            ([8, 6], [1, 0], (slice(None), slice(None)), [6, 2, 1, 4], True),
+            # Merging dims that are not contiguous requires a copy
+            ([4, 6], [1, 0], (slice(None), slice(None)), [24], False),
+            ([4, 6, 5], [0, 1, 2], (slice(1, 4), slice(0, 6, 2), slice(None)), [45], False),
+        ]
+
+        for shape, permutation, index, target, is_view in test_cases:
+            print(f"\nTesting shape {shape} permuted by {permutation} and sliced by {index} to {target}")
+            nparr = np.random.randn(*shape).astype(np.float32)
+            arr1 = Array.from_numpy(nparr)
+            arr2 = arr1.permute(permutation)[index].reshape(target)
+            npreshape = np.transpose(nparr, permutation)[index].reshape(target)
+            assert np.allclose(arr2.numpy(), npreshape, atol=1e-3, rtol=0)
+            # Views keep the strides of the input while copies are contiguous
+            assert arr2.is_contiguous != is_view
+
+            t1 = torch.from_numpy(nparr).requires_grad_(True)
+            t2 = t1.permute(permutation)[index].reshape(target)
+            (arr2 * arr2).sum().backward()
+            (t2 * t2).sum().backward()
+            assert torch.allclose(arr1.grad.torch(), t1.grad, atol=1e-3, rtol=0)
+
+    def test_transpose_copy(self):
+        print("\nTesting copies of transposed arrays:")
+
+        # Test cases: [(shape, permutation)]
+        test_cases = [
+            ([70, 45], [1, 0]),  # Partial tiles on both sides
+            ([3, 64, 33], [0, 2, 1]),  # Batched transpose
+            ([5, 40, 2, 37], [3, 1, 0, 2]),  # Row dim merged from several dims
+            ([33, 1, 65], [2, 1, 0]),  # With dimension size 1
+        ]
+
+        for shape, permutation in test_cases:
+            print(f"\nTesting shape {shape} with permutation {permutation}")
+            nparr = np.random.randn(*shape).astype(np.float32)
+            arr1 = Array.from_numpy(nparr).permute(permutation)
+            nppermute = np.transpose(nparr, permutation)
+            numel = nppermute.size
+            assert np.allclose(arr1.reshape([numel]).numpy(), nppermute.reshape(numel), atol=1e-3, rtol=0)
+            # The cast is fused into the copy
+            assert np.array_equal(arr1.astype(i32).numpy(), nppermute.astype(np.int32))
@@ -0,0 +1,78 @@
+from arrayx.core import Array, Backend
+import ax
+import numpy as np
+import torch
+
+
+class TestVmap:
+    @classmethod
+    def setup_class(cls):
+        """Run once before all tests in the class"""
+        print("\nSetting up TestVmap class...")
+        # Add any setup code here
+        Backend.init()
+
+    @classmethod
+    def teardown_class(cls):
+        """Run once after all tests in the class"""
+        print("\nTearing down TestVmap class...")
+        # Add any cleanup code here
+        Backend.cleanup()
+
+    def test_vmap_elmwise(self):
+        x = np.random.randn(8, 5, 3).astype(np.float32)
+        y = np.random.randn(3).astype(np.float32)
+        arr1 = Array.from_numpy(x)
+        arr2 = Array.from_numpy(y)
+        arr3 = ax.vmap(lambda a, b: ((a + b) * 2.0).exp() - a, in_dims=(0, None))(arr1, arr2)
+        t1 = torch.from_numpy(x)
+        t2 = torch.from_numpy(y)
+        t3 = torch.vmap(lambda a, b: ((a + b) * 2.0).exp() - a, in_dims=(0, None))(t1, t2)
+        assert arr3.view == list(t3.shape)
+        assert torch.allclose(arr3.torch(), t3, atol=1e-3, rtol=1e-4)
+
+    def test_vmap_broadcast(self):
+        # Per-example operands broadcast against each other
+        x = np.random.randn(6, 4).astype(np.float32)
+        y = np.random.randn(6, 3, 1).astype(np.float32)
+        arr1 = Array.from_numpy(x)
+        arr2 = Array.from_numpy(y)
+        arr3 = ax.vmap(lambda a, b: a * b)(arr1, arr2)
+        t3 = torch.from_numpy(x).unsqueeze(1) * torch.from_numpy(y)
+        assert arr3.view == list(t3.shape)
+        assert torch.allclose(arr3.torch(), t3, atol=1e-3, rtol=0)
+
+    def test_vmap_matmul(self):
+        x = np.random.randn(16, 7, 5).astype(np.float32)
+        w = np.random.randn(4, 5).astype(np.float32)
+        arr1 = Array.from_numpy(x)
+        arr2 = Array.from_numpy(w)
+        arr3 = ax.vmap(lambda a, b: a @ b.transpose(), in_dims=(0, None))(arr1, arr2)
+        t3 = torch.from_numpy(x) @ torch.from_numpy(w).T
+        assert arr3.view == list(t3.shape)
+        assert torch.allclose(arr3.torch(), t3, atol=1e-3, rtol=1e-4)
+
+    def test_vmap_reduce(self):
+        x = np.random.randn(5, 9, 12).astype(np.float32)
+        arr1 = Array.from_numpy(x)
+        arr2 = ax.vmap(lambda a: a.sum(), in_dims=1)(arr1)
+        arr3 = ax.vmap(lambda a: a.max([1]))(arr1)
+        t1 = torch.from_numpy(x)
+        t2 = t1.sum(dim=(0, 2)).unsqueeze(-1)
+        t3 = t1.max(dim=2, keepdim=True).values
+        assert torch.allclose(arr2.torch(), t2, atol=1e-3, rtol=1e-4)
+        assert torch.allclose(arr3.torch(), t3, atol=1e-3, rtol=0)
+
+    def test_vmap_backprop(self):
+        # Gradients flow from the batched graph to the shared arrays
+        x = np.random.randn(16, 5).astype(np.float32)
+        w = np.random.randn(4, 5).astype(np.float32)
+        arr1 = Array.from_numpy(x)
+        arr2 = Array.from_numpy(w)
+        arr3 = ax.vmap(lambda a, b: (b @ a.unsqueeze()).sq().sum(), in_dims=(0, None))(arr1, arr2)
+        arr3.sum().backward()
+        t1 = torch.from_numpy(x)
+        t2 = torch.from_numpy(w).requires_grad_(True)
+        t3 = (t1 @ t2.T).square().sum()
+        t3.backward()
+        assert torch.allclose(arr2.grad.torch(), t2.grad, atol=1e-2, rtol=1e-4)